@@ -0,0 +1,206 @@
+/* The file is part of Snowman decompiler. */
+/* See doc/licenses.asciidoc for the licensing information. */
+
+#include "SyntheticImage.h"
+
+#include <vector>
+
+#include <QByteArray>
+
+#include <nc/common/Unreachable.h>
+#include <nc/common/make_unique.h>
+#include <nc/core/image/Image.h>
+#include <nc/core/image/Section.h>
+
+namespace nc {
+namespace bench {
+
+namespace {
+
+/** Address of the code section. */
+const ByteAddr CODE_ADDR = 0x401000;
+
+/** Address of the data section. */
+const ByteAddr DATA_ADDR = 0x800000;
+
+/**
+ * Buffer of little-endian machine code or data placed at a given address.
+ */
+class Buffer {
+    ByteAddr addr_;
+    QByteArray bytes_;
+
+public:
+    explicit Buffer(ByteAddr addr): addr_(addr) {}
+
+    ByteAddr addr() const { return addr_; }
+    ByteAddr currentAddr() const { return addr_ + bytes_.size(); }
+    const QByteArray &bytes() const { return bytes_; }
+
+    void emit8(quint8 value) {
+        bytes_.append(static_cast<char>(value));
+    }
+
+    void emit32(quint32 value) {
+        for (int i = 0; i < 4; ++i) {
+            emit8(static_cast<quint8>(value >> (8 * i)));
+        }
+    }
+
+    /**
+     * Emits a 32-bit displacement of the given target relative to the end of the displacement.
+     */
+    void emitRel32(ByteAddr target) {
+        emit32(static_cast<quint32>(target - (currentAddr() + 4)));
+    }
+
+    /**
+     * Overwrites the 32-bit displacement at the given address.
+     */
+    void patchRel32(ByteAddr addr, ByteAddr target) {
+        auto value = static_cast<quint32>(target - (addr + 4));
+        for (int i = 0; i < 4; ++i) {
+            bytes_[static_cast<int>(addr - addr_) + i] = static_cast<char>(value >> (8 * i));
+        }
+    }
+};
+
+/*
+ * loop_i: inc eax
+ *         ...
+ *         cmp eax, i
+ *         jne loop_i
+ */
+void makeDeepLoops(Buffer &code, int depth) {
+    std::vector<ByteAddr> headers;
+    for (int i = 0; i < depth; ++i) {
+        headers.push_back(code.currentAddr());
+        code.emit8(0x40);
+    }
+    for (int i = depth - 1; i >= 0; --i) {
+        code.emit8(0x3d);
+        code.emit32(i);
+        code.emit8(0x0f);
+        code.emit8(0x85);
+        code.emitRel32(headers[i]);
+    }
+    code.emit8(0xc3);
+}
+
+/*
+ *          mov eax, [esp+4]
+ *          cmp eax, count - 1
+ *          ja default
+ *          jmp [eax*4 + table]
+ * case_k:  mov eax, k
+ *          ret
+ * default: xor eax, eax
+ *          ret
+ */
+void makeHugeSwitch(Buffer &code, Buffer &data, int count) {
+    code.emit8(0x8b);
+    code.emit8(0x44);
+    code.emit8(0x24);
+    code.emit8(0x04);
+
+    code.emit8(0x3d);
+    code.emit32(count - 1);
+
+    code.emit8(0x0f);
+    code.emit8(0x87);
+    ByteAddr defaultDisplacement = code.currentAddr();
+    code.emit32(0);
+
+    code.emit8(0xff);
+    code.emit8(0x24);
+    code.emit8(0x85);
+    code.emit32(static_cast<quint32>(data.currentAddr()));
+
+    for (int k = 0; k < count; ++k) {
+        data.emit32(static_cast<quint32>(code.currentAddr()));
+
+        code.emit8(0xb8);
+        code.emit32(k);
+        code.emit8(0xc3);
+    }
+
+    code.patchRel32(defaultDisplacement, code.currentAddr());
+    code.emit8(0x31);
+    code.emit8(0xc0);
+    code.emit8(0xc3);
+}
+
+/*
+ *      cmp eax, i
+ *      jne next_i
+ *      inc eax
+ * next_i:
+ *      ...
+ *      ret
+ */
+void makeManyBlocks(Buffer &code, int count) {
+    for (int i = 0; i < count / 2; ++i) {
+        code.emit8(0x3d);
+        code.emit32(i);
+        code.emit8(0x75);
+        code.emit8(0x01);
+        code.emit8(0x40);
+    }
+    code.emit8(0xc3);
+}
+
+} // anonymous namespace
+
+QString getSyntheticName(SyntheticKind kind, int size) {
+    switch (kind) {
+        case DEEP_LOOPS:
+            return QString("synthetic:loops-%1").arg(size);
+        case HUGE_SWITCH:
+            return QString("synthetic:switch-%1").arg(size);
+        case MANY_BLOCKS:
+            return QString("synthetic:blocks-%1").arg(size);
+    }
+    unreachable();
+}
+
+void makeSyntheticImage(core::image::Image &image, SyntheticKind kind, int size) {
+    Buffer code(CODE_ADDR);
+    Buffer data(DATA_ADDR);
+
+    switch (kind) {
+        case DEEP_LOOPS:
+            makeDeepLoops(code, size);
+            break;
+        case HUGE_SWITCH:
+            makeHugeSwitch(code, data, size);
+            break;
+        case MANY_BLOCKS:
+            makeManyBlocks(code, size);
+            break;
+    }
+
+    image.platform().setArchitecture(QLatin1String("i386"));
+    image.setEntryPoint(CODE_ADDR);
+
+    auto text = std::make_unique<core::image::Section>(".text", code.addr(), code.bytes().size());
+    text->setAllocated();
+    text->setReadable();
+    text->setExecutable();
+    text->setCode();
+    text->setContent(code.bytes());
+    image.addSection(std::move(text));
+
+    if (!data.bytes().isEmpty()) {
+        auto rodata = std::make_unique<core::image::Section>(".rodata", data.addr(), data.bytes().size());
+        rodata->setAllocated();
+        rodata->setReadable();
+        rodata->setData();
+        rodata->setContent(data.bytes());
+        image.addSection(std::move(rodata));
+    }
+}
+
+} // namespace bench
+} // namespace nc
+
+/* vim:set et sts=4 sw=4: */
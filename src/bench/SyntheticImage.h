@@ -0,0 +1,49 @@
+/* The file is part of Snowman decompiler. */
+/* See doc/licenses.asciidoc for the licensing information. */
+
+#pragma once
+
+#include <nc/config.h>
+
+#include <QString>
+
+namespace nc {
+
+namespace core {
+    namespace image {
+        class Image;
+    }
+}
+
+namespace bench {
+
+/**
+ * Kinds of synthetic programs stressing particular parts of the decompiler.
+ */
+enum SyntheticKind {
+    DEEP_LOOPS,     ///< A function with the given number of nested loops.
+    HUGE_SWITCH,    ///< A function with a table-based switch of the given number of cases.
+    MANY_BLOCKS     ///< A function with the given number of basic blocks.
+};
+
+/**
+ * \param kind Kind of the program.
+ * \param size Depth of the loop nest, number of switch cases, or number of basic blocks.
+ *
+ * \return Human-readable name of the program.
+ */
+QString getSyntheticName(SyntheticKind kind, int size);
+
+/**
+ * Fills an empty image with a synthetic i386 program.
+ *
+ * \param[out] image Image to fill.
+ * \param[in] kind Kind of the program.
+ * \param[in] size Depth of the loop nest, number of switch cases, or number of basic blocks.
+ */
+void makeSyntheticImage(core::image::Image &image, SyntheticKind kind, int size);
+
+} // namespace bench
+} // namespace nc
+
+/* vim:set et sts=4 sw=4: */
@@ -0,0 +1,446 @@
+/* The file is part of Snowman decompiler. */
+/* See doc/licenses.asciidoc for the licensing information. */
+
+#include <nc/config.h>
+
+#include <algorithm>
+#include <memory>
+#include <vector>
+
+#include <nc/common/Exception.h>
+#include <nc/common/Foreach.h>
+#include <nc/common/Version.h>
+
+#include <nc/core/Context.h>
+#include <nc/core/Driver.h>
+#include <nc/core/Statistics.h>
+#include <nc/core/arch/Instructions.h>
+#include <nc/core/ir/Functions.h>
+#include <nc/core/likec/Tree.h>
+
+#include <QCoreApplication>
+#include <QDir>
+#include <QDirIterator>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QFileInfo>
+#include <QStringList>
+#include <QTextStream>
+#include <QThread>
+
+#include "SyntheticImage.h"
+
+const char *self = "nc-bench";
+
+QTextStream qout(stdout, QIODevice::WriteOnly);
+QTextStream qerr(stderr, QIODevice::WriteOnly);
+
+/**
+ * A program to benchmark the decompiler on.
+ */
+struct Input {
+    QString name; ///< Name of the input in the results.
+    QString filename; ///< Name of the file to parse, empty for a synthetic program.
+    nc::bench::SyntheticKind kind; ///< Kind of the synthetic program.
+    int size; ///< Size of the synthetic program.
+    bool incrementalStructuring; ///< Whether to structure regions incrementally.
+
+    Input(): kind(nc::bench::DEEP_LOOPS), size(0), incrementalStructuring(false) {}
+};
+
+/**
+ * Aggregated measurements of a pass over all the runs.
+ */
+struct PassResult {
+    QString name; ///< Name of the pass.
+    qint64 bestNanoseconds; ///< Minimal wall time.
+    qint64 totalNanoseconds; ///< Sum of the wall times.
+    boost::optional<qint64> memoryGrowth; ///< Change of the memory usage in bytes during the last run, if known.
+    nc::core::Statistics::Counters counters; ///< Counters of the last run.
+};
+
+/**
+ * Aggregated measurements of an input over all the runs.
+ */
+struct Result {
+    QString name; ///< Name of the input.
+    QString error; ///< Error message, empty on success.
+    int runs; ///< Number of completed runs.
+    qint64 instructions; ///< Number of instructions.
+    qint64 functions; ///< Number of functions.
+    qint64 bestNanoseconds; ///< Minimal wall time of a whole run.
+    qint64 totalNanoseconds; ///< Sum of the wall times of whole runs.
+    boost::optional<qint64> memoryGrowth; ///< Change of the memory usage in bytes during the last run, if known.
+    qint64 processPeakMemory; ///< Peak memory usage of the whole process so far, or -1 if unknown.
+    std::vector<PassResult> passes; ///< Measurements of the passes, in the order of execution.
+    QString output; ///< Code printed by the last run.
+    boost::optional<bool> sameOutput; ///< Whether the code equals the one of the same input structured by restarting.
+
+    Result(): runs(0), instructions(0), functions(0), bestNanoseconds(0), totalNanoseconds(0), processPeakMemory(-1) {}
+};
+
+QString escapeJson(const QString &string) {
+    QString result = "\"";
+    foreach (QChar c, string) {
+        if (c == '"' || c == '\\') {
+            result += '\\';
+            result += c;
+        } else if (c.unicode() < 0x20) {
+            result += QString("\\u%1").arg(c.unicode(), 4, 16, QChar('0'));
+        } else {
+            result += c;
+        }
+    }
+    result += '"';
+    return result;
+}
+
+QString seconds(qint64 nanoseconds) {
+    return QString::number(nanoseconds / 1e9, 'f', 6);
+}
+
+QString perSecond(qint64 count, qint64 nanoseconds) {
+    return nanoseconds > 0 ? QString::number(count / (nanoseconds / 1e9), 'f', 1) : QString("null");
+}
+
+/**
+ * Decompiles the input once and adds the measurements to the result.
+ *
+ * \param input Input.
+ * \param threadCount Number of threads for per-function analyses.
+ * \param result Result to update.
+ */
+void runOnce(const Input &input, int threadCount, Result &result) {
+    auto memoryUsage = nc::core::Statistics::currentMemoryUsage();
+
+    nc::core::Context context;
+    context.setThreadCount(threadCount);
+    context.setIncrementalStructuring(input.incrementalStructuring);
+    context.setStatistics(std::make_shared<nc::core::Statistics>());
+
+    QElapsedTimer timer;
+    timer.start();
+
+    if (input.filename.isEmpty()) {
+        nc::bench::makeSyntheticImage(*context.image(), input.kind, input.size);
+    } else {
+        nc::core::Driver::parse(context, input.filename);
+    }
+
+    nc::core::Driver::disassemble(context);
+    nc::core::Driver::decompile(context);
+
+    {
+        nc::core::PassMeasurement measurement(context.statistics(), "printTree");
+
+        QString text;
+        QTextStream out(&text);
+        context.tree()->print(out);
+        out.flush();
+
+        measurement.addCounter("characters", text.size());
+
+        result.output = text;
+    }
+
+    qint64 nanoseconds = timer.nsecsElapsed();
+
+    auto passes = context.statistics()->passes();
+
+    if (result.runs == 0) {
+        result.instructions = context.instructions()->size();
+        result.functions = context.functions()->list().size();
+        result.bestNanoseconds = nanoseconds;
+
+        foreach (const auto &pass, passes) {
+            PassResult passResult;
+            passResult.name = pass.name;
+            passResult.bestNanoseconds = pass.nanoseconds;
+            passResult.totalNanoseconds = 0;
+            result.passes.push_back(passResult);
+        }
+    }
+
+    /* The sequence of passes is the same in every run. */
+    for (std::size_t i = 0; i < passes.size() && i < result.passes.size(); ++i) {
+        PassResult &passResult = result.passes[i];
+        passResult.bestNanoseconds = std::min(passResult.bestNanoseconds, passes[i].nanoseconds);
+        passResult.totalNanoseconds += passes[i].nanoseconds;
+        passResult.memoryGrowth = passes[i].memoryGrowth;
+        passResult.counters = passes[i].counters;
+    }
+
+    result.bestNanoseconds = std::min(result.bestNanoseconds, nanoseconds);
+    result.totalNanoseconds += nanoseconds;
+    result.memoryGrowth = boost::none;
+    if (memoryUsage) {
+        if (auto newMemoryUsage = nc::core::Statistics::currentMemoryUsage()) {
+            result.memoryGrowth = *newMemoryUsage - *memoryUsage;
+        }
+    }
+    /* ru_maxrss never decreases, so it is only meaningful for the process as a whole. */
+    result.processPeakMemory = nc::core::Statistics::peakMemoryUsage();
+    ++result.runs;
+}
+
+void printResults(const std::vector<Result> &results, int repeatCount, int threadCount, QTextStream &out) {
+    out << "{" << endl;
+    out << "  \"version\": " << escapeJson(nc::version) << "," << endl;
+    out << "  \"repeat\": " << repeatCount << "," << endl;
+    out << "  \"threads\": " << threadCount << "," << endl;
+    out << "  \"inputs\": [";
+
+    bool firstResult = true;
+    foreach (const auto &result, results) {
+        out << (firstResult ? "" : ",") << endl;
+        firstResult = false;
+
+        out << "    {" << endl;
+        out << "      \"name\": " << escapeJson(result.name) << "," << endl;
+        if (!result.error.isEmpty()) {
+            out << "      \"error\": " << escapeJson(result.error) << "," << endl;
+        }
+        out << "      \"runs\": " << result.runs << "," << endl;
+        out << "      \"instructions\": " << result.instructions << "," << endl;
+        out << "      \"functions\": " << result.functions << "," << endl;
+        out << "      \"bestTime\": " << seconds(result.bestNanoseconds) << "," << endl;
+        out << "      \"meanTime\": " << seconds(result.runs ? result.totalNanoseconds / result.runs : 0) << "," << endl;
+        out << "      \"instructionsPerSecond\": " << perSecond(result.instructions, result.bestNanoseconds) << "," << endl;
+        out << "      \"functionsPerSecond\": " << perSecond(result.functions, result.bestNanoseconds) << "," << endl;
+        out << "      \"memoryGrowth\": ";
+        if (result.memoryGrowth) {
+            out << *result.memoryGrowth;
+        } else {
+            out << "null";
+        }
+        out << "," << endl;
+        out << "      \"processPeakMemory\": " << result.processPeakMemory << "," << endl;
+        if (result.sameOutput) {
+            out << "      \"sameOutput\": " << (*result.sameOutput ? "true" : "false") << "," << endl;
+        }
+        out << "      \"passes\": [";
+
+        bool firstPass = true;
+        foreach (const auto &pass, result.passes) {
+            out << (firstPass ? "" : ",") << endl;
+            firstPass = false;
+
+            out << "        {\"name\": " << escapeJson(pass.name)
+                << ", \"bestTime\": " << seconds(pass.bestNanoseconds)
+                << ", \"meanTime\": " << seconds(result.runs ? pass.totalNanoseconds / result.runs : 0)
+                << ", \"memoryGrowth\": ";
+            if (pass.memoryGrowth) {
+                out << *pass.memoryGrowth;
+            } else {
+                out << "null";
+            }
+            out << ", \"counters\": {";
+
+            bool firstCounter = true;
+            foreach (const auto &counter, pass.counters) {
+                out << (firstCounter ? "" : ", ") << escapeJson(counter.first) << ": " << counter.second;
+                firstCounter = false;
+            }
+            out << "}}";
+        }
+
+        out << (firstPass ? "" : "\n      ") << "]" << endl;
+        out << "    }";
+    }
+
+    out << (firstResult ? "" : "\n  ") << "]" << endl;
+    out << "}" << endl;
+}
+
+void help() {
+    qout << "Usage: " << self << " [options] [--] [file|directory]..." << endl
+         << endl
+         << "Options:" << endl
+         << "  --help, -h          Produce this help message and quit." << endl
+         << "  --output=FILE       Write the results in JSON format to the file (default: stdout)." << endl
+         << "  --repeat=N          Decompile every input N times (default: 3)." << endl
+         << "  --jobs[=N]          Analyze up to N functions in parallel (default: 1, or number of CPUs if N is omitted)." << endl
+         << "  --synthetic         Add synthetic programs: 200 nested loops, a switch with 4096 cases," << endl
+         << "                      and a function with 50000 basic blocks." << endl
+         << "  --loops=N           Add a synthetic program with N nested loops." << endl
+         << "  --switch=N          Add a synthetic program with a switch of N cases." << endl
+         << "  --blocks=N          Add a synthetic program with a function of N basic blocks." << endl
+         << "  --structuring=MODE  Structure regions by restarting after every reduction (restart, default)," << endl
+         << "                      incrementally (incremental), or both ways, one after another (both)." << endl
+         << endl
+         << self << " decompiles the given executable files, all files found in the given" << endl
+         << "directories, and the requested synthetic programs, and reports the time" << endl
+         << "and memory spent in every pass, including parsing, disassembling, and" << endl
+         << "printing the generated code, together with the overall throughput." << endl
+         << "Memory is the change of the resident set size during a pass or a run" << endl
+         << "(where the platform reports it), while processPeakMemory is the peak" << endl
+         << "memory usage of the whole benchmark process up to the end of an input." << endl
+         << "Inputs that cannot be decompiled are reported with an error message." << endl
+         << "With --structuring=both, every input is reported twice, the incremental" << endl
+         << "result telling whether its code is the same as the restarting one's." << endl;
+}
+
+int parsePositive(const QString &arg) {
+    bool ok;
+    int result = arg.section('=', 1).toInt(&ok);
+    if (!ok || result < 1) {
+        throw nc::Exception(QString("invalid value: %1").arg(arg));
+    }
+    return result;
+}
+
+Input makeSyntheticInput(nc::bench::SyntheticKind kind, int size) {
+    Input input;
+    input.name = nc::bench::getSyntheticName(kind, size);
+    input.kind = kind;
+    input.size = size;
+    return input;
+}
+
+int main(int argc, char *argv[]) {
+    QCoreApplication app(argc, argv);
+
+    try {
+        QString outputFile;
+        int repeatCount = 3;
+        int threadCount = 1;
+        bool restartStructuring = true;
+        bool incrementalStructuring = false;
+
+        std::vector<Input> inputs;
+        QStringList paths;
+
+        auto args = QCoreApplication::arguments();
+
+        for (int i = 1; i < args.size(); ++i) {
+            QString arg = args[i];
+            if (arg == "--help" || arg == "-h") {
+                help();
+                return 1;
+            } else if (arg.startsWith("--output=")) {
+                outputFile = arg.section('=', 1);
+            } else if (arg.startsWith("--repeat=")) {
+                repeatCount = parsePositive(arg);
+            } else if (arg == "--jobs") {
+                threadCount = qMax(QThread::idealThreadCount(), 1);
+            } else if (arg.startsWith("--jobs=")) {
+                threadCount = parsePositive(arg);
+            } else if (arg == "--synthetic") {
+                inputs.push_back(makeSyntheticInput(nc::bench::DEEP_LOOPS, 200));
+                inputs.push_back(makeSyntheticInput(nc::bench::HUGE_SWITCH, 4096));
+                inputs.push_back(makeSyntheticInput(nc::bench::MANY_BLOCKS, 50000));
+            } else if (arg.startsWith("--loops=")) {
+                inputs.push_back(makeSyntheticInput(nc::bench::DEEP_LOOPS, parsePositive(arg)));
+            } else if (arg.startsWith("--switch=")) {
+                inputs.push_back(makeSyntheticInput(nc::bench::HUGE_SWITCH, parsePositive(arg)));
+            } else if (arg.startsWith("--blocks=")) {
+                inputs.push_back(makeSyntheticInput(nc::bench::MANY_BLOCKS, parsePositive(arg)));
+            } else if (arg.startsWith("--structuring=")) {
+                QString mode = arg.section('=', 1);
+                if (mode != "restart" && mode != "incremental" && mode != "both") {
+                    throw nc::Exception(QString("invalid value: %1").arg(arg));
+                }
+                restartStructuring = mode != "incremental";
+                incrementalStructuring = mode != "restart";
+            } else if (arg == "--") {
+                while (++i < args.size()) {
+                    paths.append(args[i]);
+                }
+            } else if (arg.startsWith("-")) {
+                throw nc::Exception(QString("unknown argument: %1").arg(arg));
+            } else {
+                paths.append(arg);
+            }
+        }
+
+        foreach (const QString &path, paths) {
+            QStringList filenames;
+            if (QFileInfo(path).isDir()) {
+                QDirIterator iterator(path, QDir::Files, QDirIterator::Subdirectories);
+                while (iterator.hasNext()) {
+                    filenames.append(iterator.next());
+                }
+                filenames.sort();
+            } else {
+                filenames.append(path);
+            }
+
+            foreach (const QString &filename, filenames) {
+                Input input;
+                input.name = filename;
+                input.filename = filename;
+                inputs.push_back(input);
+            }
+        }
+
+        if (inputs.empty()) {
+            throw nc::Exception("no inputs");
+        }
+
+        if (restartStructuring && incrementalStructuring) {
+            std::vector<Input> bothInputs;
+            foreach (const auto &input, inputs) {
+                bothInputs.push_back(input);
+                bothInputs.back().name += " [restart]";
+                bothInputs.push_back(input);
+                bothInputs.back().name += " [incremental]";
+                bothInputs.back().incrementalStructuring = true;
+            }
+            inputs.swap(bothInputs);
+        } else {
+            foreach (auto &input, inputs) {
+                input.incrementalStructuring = incrementalStructuring;
+            }
+        }
+
+        std::vector<Result> results;
+
+        foreach (const auto &input, inputs) {
+            Result result;
+            result.name = input.name;
+
+            try {
+                for (int run = 0; run < repeatCount; ++run) {
+                    runOnce(input, threadCount, result);
+                }
+                qerr << self << ": " << input.name << ": " << seconds(result.bestNanoseconds) << " s" << endl;
+            } catch (const nc::Exception &e) {
+                result.error = e.unicodeWhat();
+                qerr << self << ": " << input.name << ": " << result.error << endl;
+            } catch (const std::exception &e) {
+                result.error = e.what();
+                qerr << self << ": " << input.name << ": " << result.error << endl;
+            }
+
+            /* The restarting run of the same input goes right before the incremental one. */
+            if (restartStructuring && input.incrementalStructuring && !results.empty()) {
+                Result &restartResult = results.back();
+                if (result.error.isEmpty() && restartResult.error.isEmpty()) {
+                    result.sameOutput = result.output == restartResult.output;
+                }
+                restartResult.output = QString();
+            }
+            result.output = QString();
+
+            results.push_back(std::move(result));
+        }
+
+        if (outputFile.isEmpty() || outputFile == "-") {
+            printResults(results, repeatCount, threadCount, qout);
+        } else {
+            QFile file(outputFile);
+            if (!file.open(QIODevice::WriteOnly)) {
+                throw nc::Exception("could not open file for writing");
+            }
+            QTextStream out(&file);
+            printResults(results, repeatCount, threadCount, out);
+        }
+    } catch (const nc::Exception &e) {
+        qerr << self << ": " << e.unicodeWhat() << endl;
+        return 1;
+    }
+
+    return 0;
+}
+
+/* vim:set et sts=4 sw=4: */
@@ -52,7 +52,7 @@ std::shared_ptr<core::arch::Instruction> X86Disassembler::disassembleSingleInstr
         return nullptr;
     }
 
-    return std::make_shared<X86Instruction>(ud_obj_.dis_mode, pc, instructionSize, buffer);
+    return std::make_shared<X86Instruction>(ud_obj_.dis_mode, pc, instructionSize, buffer, ud_obj_);
 }
 
 } // namespace x86
@@ -26,12 +26,64 @@
 
 #include <QTextStream>
 
-#include "udis86.h"
-
 namespace nc {
 namespace arch {
 namespace x86 {
 
+X86Instruction::X86Instruction(SmallBitSize bitness, ByteAddr addr, SmallByteSize size, const void *bytes, const ud_t &ud):
+    core::arch::Instruction(addr, size), bitness_(checked_cast<uint8_t>(bitness)),
+    mnemonic_(checked_cast<uint16_t>(static_cast<int>(ud.mnemonic))),
+    oprMode_(ud.opr_mode), adrMode_(ud.adr_mode),
+    pfxRep_(ud.pfx_rep), pfxRepe_(ud.pfx_repe), pfxRepne_(ud.pfx_repne)
+{
+    assert(size > 0);
+    assert(size <= MAX_SIZE);
+    memcpy(&bytes_, bytes, size);
+
+    static_assert(sizeof(Operand::lval) == sizeof(ud.operand[0].lval), "lval must fit into the compact operand");
+    static_assert(sizeof(ud.operand) / sizeof(ud.operand[0]) == std::tuple_size<decltype(operands_)>::value,
+                  "all operands must be stored");
+
+    for (std::size_t i = 0; i < operands_.size(); ++i) {
+        const auto &operand = ud.operand[i];
+        auto &compact = operands_[i];
+
+        memcpy(&compact.lval, &operand.lval, sizeof(compact.lval));
+        compact.type = checked_cast<uint16_t>(static_cast<int>(operand.type));
+        compact.base = checked_cast<uint16_t>(static_cast<int>(operand.base));
+        compact.index = checked_cast<uint16_t>(static_cast<int>(operand.index));
+        compact.size = operand.size;
+        compact.offset = operand.offset;
+        compact.scale = operand.scale;
+    }
+}
+
+X86DecodedInstruction X86Instruction::decoded() const {
+    X86DecodedInstruction result;
+
+    result.mnemonic = mnemonic();
+    for (std::size_t i = 0; i < operands_.size(); ++i) {
+        const auto &compact = operands_[i];
+        auto &operand = result.operand[i];
+
+        memcpy(&operand.lval, &compact.lval, sizeof(compact.lval));
+        operand.type = static_cast<enum ud_type>(compact.type);
+        operand.base = static_cast<enum ud_type>(compact.base);
+        operand.index = static_cast<enum ud_type>(compact.index);
+        operand.size = compact.size;
+        operand.offset = compact.offset;
+        operand.scale = compact.scale;
+    }
+    result.opr_mode = oprMode_;
+    result.adr_mode = adrMode_;
+    result.pfx_rep = pfxRep_;
+    result.pfx_repe = pfxRepe_;
+    result.pfx_repne = pfxRepne_;
+    result.pc = endAddr();
+
+    return result;
+}
+
 void X86Instruction::print(QTextStream &out) const {
     ud_t ud_obj;
 
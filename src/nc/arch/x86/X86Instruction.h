@@ -33,10 +33,27 @@
 
 #include <nc/core/arch/Instruction.h>
 
+#include "udis86.h"
+
 namespace nc {
 namespace arch {
 namespace x86 {
 
+/**
+ * Decoded form of an x86 instruction: the part of udis86's ud_t
+ * consumed by the analyzers. Field names follow the ones in ud_t.
+ */
+struct X86DecodedInstruction {
+    enum ud_mnemonic_code mnemonic; ///< Mnemonic.
+    struct ud_operand operand[3]; ///< Operands. Unused operands have type UD_NONE.
+    uint8_t opr_mode; ///< Operand size in bits.
+    uint8_t adr_mode; ///< Address size in bits.
+    uint8_t pfx_rep; ///< REP prefix, or UD_NONE.
+    uint8_t pfx_repe; ///< REPE prefix, or UD_NONE.
+    uint8_t pfx_repne; ///< REPNE prefix, or UD_NONE.
+    uint64_t pc; ///< Address of the next instruction.
+};
+
 /**
  * An instruction of Intel x86 platform.
  */
@@ -52,6 +69,32 @@ private:
     /** Copy of architecture's bitness value. */
     uint8_t bitness_;
 
+    /** Operand decoded by udis86, stored compactly. */
+    struct Operand {
+        uint64_t lval; ///< Value of the operand's lval union.
+        uint16_t type; ///< Type.
+        uint16_t base; ///< Base register.
+        uint16_t index; ///< Index register.
+        uint8_t size; ///< Size in bits.
+        uint8_t offset; ///< Size of the offset in bits.
+        uint8_t scale; ///< Scale.
+    };
+
+    /** Decoded operands. */
+    std::array<Operand, 3> operands_;
+
+    /** Decoded mnemonic. */
+    uint16_t mnemonic_;
+
+    /** Operand size in bits. */
+    uint8_t oprMode_;
+
+    /** Address size in bits. */
+    uint8_t adrMode_;
+
+    /** Repetition prefixes. */
+    uint8_t pfxRep_, pfxRepe_, pfxRepne_;
+
 public:
     /**
      * Class constructor.
@@ -60,14 +103,19 @@ public:
      * \param[in] addr Instruction address in bytes.
      * \param[in] size Instruction size in bytes.
      * \param[in] bytes Valid pointer to the bytes of the instruction.
+     * \param[in] ud udis86 state right after decoding the instruction.
+     */
+    X86Instruction(SmallBitSize bitness, ByteAddr addr, SmallByteSize size, const void *bytes, const ud_t &ud);
+
+    /**
+     * \return Mnemonic of the instruction.
+     */
+    enum ud_mnemonic_code mnemonic() const { return static_cast<enum ud_mnemonic_code>(mnemonic_); }
+
+    /**
+     * \return The instruction in the form decoded by udis86 during disassembly.
      */
-    X86Instruction(SmallBitSize bitness, ByteAddr addr, SmallByteSize size, const void *bytes):
-        core::arch::Instruction(addr, size), bitness_(checked_cast<uint8_t>(bitness))
-    {
-        assert(size > 0);
-        assert(size <= MAX_SIZE);
-        memcpy(&bytes_, bytes, size);
-    }
+    X86DecodedInstruction decoded() const;
 
     /**
      * \return Valid pointer to the buffer containing the binary
@@ -91,7 +91,7 @@ class X86InstructionAnalyzerImpl {
     Q_DECLARE_TR_FUNCTIONS(X86InstructionAnalyzerImpl)
 
     const X86Architecture *architecture_;
-    ud_t ud_obj_;
+    X86DecodedInstruction ud_obj_;
     const X86Instruction *currentInstruction_;
 
 public:
@@ -100,9 +100,6 @@ public:
         architecture_(architecture)
     {
         assert(architecture != nullptr);
-
-        ud_init(&ud_obj_);
-        ud_set_mode(&ud_obj_, architecture_->bitness());
     }
 
     void createStatements(const X86Instruction *instr, core::ir::Program *program) {
@@ -111,9 +108,7 @@ public:
 
         currentInstruction_ = instr;
 
-        ud_set_pc(&ud_obj_, instr->addr());
-        ud_set_input_buffer(&ud_obj_, const_cast<uint8_t *>(instr->bytes()), checked_cast<std::size_t>(instr->size()));
-        ud_disassemble(&ud_obj_);
+        ud_obj_ = instr->decoded();
 
         assert(ud_obj_.mnemonic != UD_Iinvalid);
 
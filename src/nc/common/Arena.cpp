@@ -0,0 +1,312 @@
+/* The file is part of Snowman decompiler. */
+/* See doc/licenses.asciidoc for the licensing information. */
+
+#include "Arena.h"
+
+#include <cassert>
+#include <new>
+
+#if defined(NC_USE_THREADS) && defined(NC_DEBUG)
+#include <atomic>
+#include <thread>
+#define NC_ARENA_CHECK_OWNER
+#endif
+
+namespace nc {
+
+namespace {
+
+/** Alignment of all allocated chunks. */
+const std::size_t ALIGNMENT = 8;
+
+/** Size of the header preceding each chunk. */
+const std::size_t HEADER_SIZE = ALIGNMENT;
+
+/** Size of a memory block. */
+const std::size_t BLOCK_SIZE = 64 * 1024;
+
+/** Chunks larger than this get a block of their own. */
+const std::size_t MAX_SMALL_SIZE = BLOCK_SIZE / 8;
+
+/**
+ * Memory block. Chunks follow the block header.
+ */
+struct Block {
+    Arena::Pool *pool; ///< Pool the block belongs to.
+    Block *prev; ///< Previous block of the pool.
+    Block *next; ///< Next block of the pool.
+    std::size_t references; ///< Number of live chunks allocated from the block.
+};
+
+/** Size of the block header, aligned. */
+const std::size_t BLOCK_HEADER_SIZE = (sizeof(Block) + ALIGNMENT - 1) & ~(ALIGNMENT - 1);
+
+/**
+ * Header preceding each allocated chunk.
+ */
+union Header {
+    Block *block; ///< Block the chunk belongs to, or nullptr if allocated from the heap.
+    char padding[HEADER_SIZE];
+};
+
+static_assert(sizeof(Header) == HEADER_SIZE, "Header must occupy exactly HEADER_SIZE bytes.");
+
+} // anonymous namespace
+
+class Arena::Pool: boost::noncopyable {
+    /** Blocks having live chunks, and the current block. */
+    Block *blocks_;
+
+    /** Block being filled. */
+    Block *current_;
+
+    /** Free memory in the current block. */
+    char *next_;
+
+    /** End of the current block. */
+    char *end_;
+
+    /** Number of bytes handed out. */
+    std::size_t allocatedSize_;
+
+    /** Whether the owning arena has been destroyed. */
+    bool orphaned_;
+
+#ifdef NC_ARENA_CHECK_OWNER
+    /** Thread performing an operation on the pool, or the default id if none. */
+    std::atomic<std::thread::id> owner_;
+#endif
+
+    /**
+     * Makes the calling thread the owner of the pool for the lifetime of the object.
+     * Asserts in debug builds that no other thread owns the pool at the same time.
+     *
+     * Pools change threads legitimately, e.g. when a program lifted in worker
+     * threads is used by the main thread afterwards. Therefore, only the
+     * operations themselves, not the whole lifetime of the pool, are owned.
+     */
+    class OwnerCheck: boost::noncopyable {
+#ifdef NC_ARENA_CHECK_OWNER
+        Pool *pool_;
+
+    public:
+        explicit OwnerCheck(Pool *pool): pool_(pool) {
+            std::thread::id none;
+            bool owned = pool_->owner_.compare_exchange_strong(none, std::this_thread::get_id());
+            assert(owned && "Objects of one arena must not be allocated or deallocated concurrently.");
+            (void)owned;
+        }
+
+        ~OwnerCheck() {
+            pool_->owner_.store(std::thread::id());
+        }
+#else
+    public:
+        explicit OwnerCheck(Pool *) {}
+#endif
+    };
+
+public:
+    Pool(): blocks_(nullptr), current_(nullptr), next_(nullptr), end_(nullptr), allocatedSize_(0), orphaned_(false) {}
+
+    ~Pool() {
+        assert(blocks_ == nullptr);
+    }
+
+    std::size_t allocatedSize() const { return allocatedSize_; }
+
+    /**
+     * \param size Size of the memory chunk, including the header, aligned.
+     *
+     * \return Valid pointer to the header of the chunk.
+     */
+    Header *allocate(std::size_t size) {
+        assert(size % ALIGNMENT == 0);
+
+        OwnerCheck check(this);
+
+        Block *block;
+        char *result;
+        if (size > MAX_SMALL_SIZE) {
+            block = createBlock(BLOCK_HEADER_SIZE + size);
+            result = reinterpret_cast<char *>(block) + BLOCK_HEADER_SIZE;
+        } else {
+            if (static_cast<std::size_t>(end_ - next_) < size) {
+                /* An empty current block is rewound, so it always has room for a small chunk. */
+                assert(current_ == nullptr || current_->references > 0);
+
+                current_ = createBlock(BLOCK_SIZE);
+                next_ = reinterpret_cast<char *>(current_) + BLOCK_HEADER_SIZE;
+                end_ = reinterpret_cast<char *>(current_) + BLOCK_SIZE;
+            }
+            block = current_;
+            result = next_;
+            next_ += size;
+        }
+
+        ++block->references;
+        allocatedSize_ += size;
+
+        auto header = reinterpret_cast<Header *>(result);
+        header->block = block;
+        return header;
+    }
+
+    /**
+     * Drops a reference to a block, freeing or rewinding the block when it was the last one.
+     *
+     * \param block Valid pointer to a block.
+     */
+    static void release(Block *block) {
+        Pool *pool = block->pool;
+        bool unused = false;
+        {
+            OwnerCheck check(pool);
+
+            assert(block->references > 0);
+            if (--block->references == 0) {
+                unused = pool->onEmpty(block);
+            }
+        }
+        if (unused) {
+            delete pool;
+        }
+    }
+
+    /**
+     * Detaches the pool from its arena. The pool deletes itself when all its blocks are freed.
+     */
+    void orphan() {
+        {
+            OwnerCheck check(this);
+
+            orphaned_ = true;
+
+            if (current_ && current_->references == 0) {
+                destroyBlock(current_);
+            }
+            if (blocks_) {
+                return;
+            }
+        }
+        delete this;
+    }
+
+private:
+    /**
+     * \param size Size of the block, including the block header.
+     *
+     * \return Valid pointer to a new block linked into the list of blocks.
+     */
+    Block *createBlock(std::size_t size) {
+        auto block = static_cast<Block *>(::operator new(size));
+        block->pool = this;
+        block->prev = nullptr;
+        block->next = blocks_;
+        block->references = 0;
+
+        if (blocks_) {
+            blocks_->prev = block;
+        }
+        blocks_ = block;
+
+        return block;
+    }
+
+    /**
+     * Unlinks the block from the list of blocks and frees it.
+     *
+     * \param block Valid pointer to a block of this pool.
+     */
+    void destroyBlock(Block *block) {
+        if (block->prev) {
+            block->prev->next = block->next;
+        } else {
+            blocks_ = block->next;
+        }
+        if (block->next) {
+            block->next->prev = block->prev;
+        }
+        if (block == current_) {
+            current_ = nullptr;
+            next_ = nullptr;
+            end_ = nullptr;
+        }
+
+        ::operator delete(block);
+    }
+
+    /**
+     * Called when the last chunk of a block is deallocated.
+     *
+     * \param block Valid pointer to a block of this pool.
+     *
+     * \return True if the pool has no blocks left and nobody needs it anymore.
+     */
+    bool onEmpty(Block *block) {
+        if (block == current_ && !orphaned_) {
+            next_ = reinterpret_cast<char *>(block) + BLOCK_HEADER_SIZE;
+            return false;
+        }
+
+        destroyBlock(block);
+
+        return orphaned_ && !blocks_;
+    }
+};
+
+namespace {
+
+/** Arena pool current in this thread. */
+NC_THREAD_LOCAL Arena::Pool *currentPool = nullptr;
+
+} // anonymous namespace
+
+Arena::Arena(): pool_(new Pool()) {}
+
+Arena::~Arena() {
+    pool_->orphan();
+}
+
+std::size_t Arena::allocatedSize() const {
+    return pool_->allocatedSize();
+}
+
+void *Arena::allocate(std::size_t size) {
+    size = (size + HEADER_SIZE + ALIGNMENT - 1) & ~(ALIGNMENT - 1);
+
+    Header *header;
+    if (currentPool) {
+        header = currentPool->allocate(size);
+    } else {
+        header = static_cast<Header *>(::operator new(size));
+        header->block = nullptr;
+    }
+
+    return header + 1;
+}
+
+void Arena::deallocate(void *pointer) noexcept {
+    if (!pointer) {
+        return;
+    }
+
+    Header *header = static_cast<Header *>(pointer) - 1;
+    if (header->block) {
+        Pool::release(header->block);
+    } else {
+        ::operator delete(header);
+    }
+}
+
+Arena::Scope::Scope(Arena &arena): previous_(currentPool) {
+    currentPool = arena.pool_;
+}
+
+Arena::Scope::~Scope() {
+    currentPool = previous_;
+}
+
+} // namespace nc
+
+/* vim:set et sts=4 sw=4: */
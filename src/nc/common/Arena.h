@@ -0,0 +1,118 @@
+/* The file is part of Snowman decompiler. */
+/* See doc/licenses.asciidoc for the licensing information. */
+
+#pragma once
+
+#include <nc/config.h>
+
+#include <cstddef>
+
+#include <boost/noncopyable.hpp>
+
+namespace nc {
+
+/**
+ * Bump-pointer allocator for large numbers of small objects.
+ *
+ * Memory is carved out of big blocks. Each block counts the objects
+ * allocated from it that are still alive. A block is freed when all its
+ * objects are deallocated, except the block currently being filled,
+ * which is reused from the beginning instead. The remaining blocks are
+ * freed when the arena is destroyed and their objects are deallocated,
+ * whichever happens last. Therefore, objects may safely outlive the
+ * owner of the arena they were allocated from.
+ *
+ * Classes opt in via NC_ARENA_ALLOCATED. Objects of such classes are
+ * allocated from the arena made current in the calling thread by an
+ * Arena::Scope, or from the global heap when there is none. Such classes
+ * must not require an alignment stricter than 8 bytes.
+ *
+ * The reference counts are not atomic: objects allocated from one arena
+ * must not be allocated or deallocated concurrently, including after
+ * the arena is destroyed. Different arenas can be used from different
+ * threads independently, and an arena can be passed on to another thread
+ * once the previous one is done with it. Debug builds assert that no two
+ * threads allocate or deallocate objects of the same arena at a time.
+ */
+class Arena: boost::noncopyable {
+public:
+    class Pool;
+    class Scope;
+
+private:
+    /** Pool of memory blocks. */
+    Pool *pool_;
+
+public:
+
+    /**
+     * Constructor.
+     */
+    Arena();
+
+    /**
+     * Destructor. Frees the memory unless some objects allocated from it are still alive.
+     */
+    ~Arena();
+
+    /**
+     * \return Number of bytes allocated from this arena so far, including the headers.
+     *         Memory that was reused is counted every time it is handed out.
+     */
+    std::size_t allocatedSize() const;
+
+    /**
+     * Allocates memory from the current arena, or from the global heap if there is no current arena.
+     *
+     * \param size Size of the memory chunk.
+     *
+     * \return Valid pointer to the allocated memory.
+     */
+    static void *allocate(std::size_t size);
+
+    /**
+     * Deallocates memory allocated by allocate().
+     *
+     * \param pointer Pointer returned by allocate(). Can be nullptr.
+     */
+    static void deallocate(void *pointer) noexcept;
+};
+
+/**
+ * Makes an arena current in the calling thread for the lifetime of the object.
+ * Scopes can be nested; the previous arena is restored on destruction.
+ */
+class Arena::Scope: boost::noncopyable {
+    Pool *previous_;
+
+public:
+    /**
+     * Constructor.
+     *
+     * \param arena Arena to make current.
+     */
+    explicit Scope(Arena &arena);
+
+    /**
+     * Destructor.
+     */
+    ~Scope();
+};
+
+} // namespace nc
+
+/**
+ * Defines class-specific operator new and operator delete allocating
+ * objects of the class and its subclasses via nc::Arena.
+ *
+ * Must be used in the public section of a class declaration.
+ */
+#define NC_ARENA_ALLOCATED                                                      \
+    static void *operator new(std::size_t size) {                               \
+        return nc::Arena::allocate(size);                                       \
+    }                                                                           \
+    static void operator delete(void *pointer) noexcept {                       \
+        nc::Arena::deallocate(pointer);                                         \
+    }
+
+/* vim:set et sts=4 sw=4: */
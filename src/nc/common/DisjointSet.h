@@ -106,7 +106,11 @@ class DisjointSet {
      */
     DisjointSet<T> *findSetImpl() const {
         if (parent_ != this) {
-            parent_ = parent_->findSetImpl();
+            DisjointSet<T> *root = parent_->findSetImpl();
+            /* Compressed paths are not written again, so they can be read concurrently. */
+            if (parent_ != root) {
+                parent_ = root;
+            }
         }
         return parent_;
     }
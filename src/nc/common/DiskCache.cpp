@@ -0,0 +1,64 @@
+/* The file is part of Snowman decompiler. */
+/* See doc/licenses.asciidoc for the licensing information. */
+
+#include "DiskCache.h"
+
+#include <cassert>
+
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QTemporaryFile>
+
+namespace nc {
+
+DiskCache::DiskCache(QString directory):
+    directory_(std::move(directory))
+{}
+
+QString DiskCache::getPath(const QByteArray &key) const {
+    assert(!key.isEmpty());
+
+    /* Two-level layout keeps the number of files per directory moderate. */
+    QString hex = QString::fromLatin1(key.toHex());
+    return directory_ + '/' + hex.left(2) + '/' + hex.mid(2);
+}
+
+boost::optional<QByteArray> DiskCache::load(const QByteArray &key) const {
+    QFile file(getPath(key));
+    if (!file.open(QIODevice::ReadOnly)) {
+        return boost::none;
+    }
+    return file.readAll();
+}
+
+bool DiskCache::store(const QByteArray &key, const QByteArray &value) const {
+    QString path = getPath(key);
+    QString directory = QFileInfo(path).path();
+
+    if (!QDir().mkpath(directory)) {
+        return false;
+    }
+
+    /* The temporary file must be on the same file system for the rename to be atomic. */
+    QTemporaryFile file(directory + "/tmp.XXXXXX");
+    if (!file.open()) {
+        return false;
+    }
+    if (file.write(value) != value.size() || !file.flush()) {
+        return false;
+    }
+    file.close();
+
+    if (!file.rename(path)) {
+        /* Somebody else has already stored the value. */
+        return QFile::exists(path);
+    }
+    file.setAutoRemove(false);
+
+    return true;
+}
+
+} // namespace nc
+
+/* vim:set et sts=4 sw=4: */
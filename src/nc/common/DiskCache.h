@@ -0,0 +1,72 @@
+/* The file is part of Snowman decompiler. */
+/* See doc/licenses.asciidoc for the licensing information. */
+
+#pragma once
+
+#include <nc/config.h>
+
+#include <QByteArray>
+#include <QString>
+
+#include <boost/optional.hpp>
+
+namespace nc {
+
+/**
+ * Content-addressed key-value store in a local directory.
+ *
+ * Every value is kept in a file named by the hexadecimal representation
+ * of its key. Files are written under temporary names and atomically
+ * renamed into place, so that several processes can share one directory:
+ * a reader either sees a complete value or no value at all. Since a key
+ * is supposed to be a hash of everything the value depends on, two
+ * writers racing for the same key write equivalent values, and it does
+ * not matter which of them wins.
+ */
+class DiskCache {
+    /** Path to the cache directory. */
+    QString directory_;
+
+public:
+
+    /**
+     * Constructor.
+     *
+     * \param directory Path to the cache directory. Created on first store, if necessary.
+     */
+    explicit DiskCache(QString directory);
+
+    /**
+     * \return Path to the cache directory.
+     */
+    const QString &directory() const { return directory_; }
+
+    /**
+     * \param key Non-empty key.
+     *
+     * \return Value stored under the given key, or boost::none if there is no such value.
+     */
+    boost::optional<QByteArray> load(const QByteArray &key) const;
+
+    /**
+     * Stores a value under the given key.
+     *
+     * \param key Non-empty key.
+     * \param value Value.
+     *
+     * \return True on success, false if the value could not be written.
+     */
+    bool store(const QByteArray &key, const QByteArray &value) const;
+
+private:
+    /**
+     * \param key Non-empty key.
+     *
+     * \return Path to the file containing the value for the given key.
+     */
+    QString getPath(const QByteArray &key) const;
+};
+
+} // namespace nc
+
+/* vim:set et sts=4 sw=4: */
@@ -58,6 +58,12 @@ public:
         assert(logger_);
     }
 
+    /**
+     * \return True if messages are actually logged somewhere.
+     *         Can be used to avoid formatting messages nobody will see.
+     */
+    bool enabled() const { return logger_ != nullptr; }
+
     /**
      * Logs a message with a given level.
      *
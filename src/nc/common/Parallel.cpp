@@ -0,0 +1,113 @@
+/* The file is part of Snowman decompiler. */
+/* See doc/licenses.asciidoc for the licensing information. */
+
+#include "Parallel.h"
+
+#include "Unused.h"
+
+#ifdef NC_USE_THREADS
+#include <exception>
+
+#include <QAtomicInt>
+#include <QMutex>
+#include <QMutexLocker>
+#include <QRunnable>
+#include <QThreadPool>
+#endif
+
+namespace nc {
+
+#ifdef NC_USE_THREADS
+namespace {
+
+/**
+ * State shared by all the threads executing a parallelFor() call.
+ */
+class ParallelForState {
+    const std::function<void(std::size_t)> &function_;
+    const int count_;
+    QAtomicInt next_;
+    QMutex mutex_;
+    std::exception_ptr exception_;
+
+public:
+    ParallelForState(const std::function<void(std::size_t)> &function, int count):
+        function_(function), count_(count), next_(0)
+    {}
+
+    /**
+     * Takes indices one by one and calls the function on them,
+     * until there is nothing left or somebody has failed.
+     */
+    void work() {
+        int index;
+        while ((index = next_.fetchAndAddOrdered(1)) < count_) {
+            try {
+                function_(static_cast<std::size_t>(index));
+            } catch (...) {
+                QMutexLocker locker(&mutex_);
+                if (!exception_) {
+                    exception_ = std::current_exception();
+                }
+                next_.fetchAndStoreOrdered(count_);
+            }
+        }
+    }
+
+    /**
+     * Rethrows the first exception thrown by the function, if any.
+     */
+    void rethrow() {
+        if (exception_) {
+            std::rethrow_exception(exception_);
+        }
+    }
+};
+
+class ParallelForWorker: public QRunnable {
+    ParallelForState &state_;
+
+public:
+    ParallelForWorker(ParallelForState &state): state_(state) {}
+
+    void run() override { state_.work(); }
+};
+
+} // anonymous namespace
+#endif
+
+void parallelFor(std::size_t count, int nthreads, const std::function<void(std::size_t)> &function) {
+#ifdef NC_USE_THREADS
+    if (nthreads > 1 && count > 1) {
+        ParallelForState state(function, static_cast<int>(count));
+
+        /*
+         * A private pool: if we are already running inside a thread
+         * of the global pool, waiting for its other threads could deadlock.
+         */
+        QThreadPool pool;
+        pool.setMaxThreadCount(nthreads - 1);
+
+        for (int i = 1; i < nthreads && static_cast<std::size_t>(i) < count; ++i) {
+            auto worker = new ParallelForWorker(state);
+            worker->setAutoDelete(true);
+            pool.start(worker);
+        }
+
+        state.work();
+        pool.waitForDone();
+        state.rethrow();
+        return;
+    }
+#else
+    NC_UNUSED(nthreads);
+#endif
+
+    for (std::size_t i = 0; i < count; ++i) {
+        function(i);
+    }
+}
+
+} // namespace nc
+
+/* vim:set et sts=4 sw=4: */
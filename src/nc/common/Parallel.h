@@ -0,0 +1,38 @@
+/* The file is part of Snowman decompiler. */
+/* See doc/licenses.asciidoc for the licensing information. */
+
+#pragma once
+
+#include <nc/config.h>
+
+#include <cstddef>
+#include <functional>
+
+namespace nc {
+
+/**
+ * Calls the given function for every index from 0 to count - 1
+ * using at most the given number of threads.
+ *
+ * Indices are handed out to the threads dynamically, one at a time,
+ * so that a thread that has finished with a cheap item immediately
+ * takes the next one. The calling thread takes part in the work, therefore,
+ * the function never waits for a thread pool slot to become free.
+ *
+ * If the function throws, the remaining indices are not handed out anymore,
+ * and the first thrown exception is rethrown in the calling thread after
+ * all the threads have finished.
+ *
+ * When threads are disabled at compile time or the number of threads is
+ * less than two, the indices are processed sequentially in ascending order.
+ *
+ * \param count     Number of indices.
+ * \param nthreads  Maximal number of threads to use.
+ * \param function  Function to call for every index. Must be safe to be
+ *                  called concurrently for different indices.
+ */
+void parallelFor(std::size_t count, int nthreads, const std::function<void(std::size_t)> &function);
+
+} // namespace nc
+
+/* vim:set et sts=4 sw=4: */
@@ -3,11 +3,13 @@
 
 #include "StreamLogger.h"
 
+#include <QMutexLocker>
 #include <QObject>
 
 namespace nc {
 
 void StreamLogger::log(LogLevel level, const QString &text) {
+    QMutexLocker locker(&mutex_);
     stream_ << tr("[%1] %2").arg(level.getName()).arg(text) << endl;
 }
 
@@ -6,6 +6,7 @@
 #include <nc/config.h>
 
 #include <QCoreApplication>
+#include <QMutex>
 #include <QTextStream>
 
 #include "Logger.h"
@@ -19,6 +20,7 @@ class StreamLogger: public nc::Logger {
     Q_DECLARE_TR_FUNCTIONS(StreamLogger)
 
     QTextStream &stream_;
+    QMutex mutex_;
 
 public:
     /**
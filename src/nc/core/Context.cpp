@@ -46,7 +46,9 @@ namespace core {
 
 Context::Context():
     image_(std::make_shared<image::Image>()),
-    instructions_(std::make_shared<arch::Instructions>())
+    instructions_(std::make_shared<arch::Instructions>()),
+    threadCount_(1),
+    incrementalStructuring_(false)
 {}
 
 Context::~Context() {}
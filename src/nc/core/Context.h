@@ -25,16 +25,24 @@
 
 #include <nc/config.h>
 
+#include <cassert>
 #include <memory> /* For std::unique_ptr. */
+#include <vector>
 
 #include <QObject>
 
 #include <nc/common/CancellationToken.h>
 #include <nc/common/LogToken.h>
+#include <nc/common/Types.h>
 
 namespace nc {
+
+class DiskCache;
+
 namespace core {
 
+class Statistics;
+
 namespace arch {
     class Instructions;
 }
@@ -45,6 +53,7 @@ namespace image {
 
 namespace ir {
     class Function;
+    class FunctionCache;
     class Functions;
     class Program;
 
@@ -95,6 +104,12 @@ class Context: public QObject {
     std::unique_ptr<likec::Tree> tree_; ///< Abstract syntax tree of the LikeC program.
     LogToken logToken_; ///< Log token.
     CancellationToken cancellationToken_; ///< Cancellation token.
+    int threadCount_; ///< Maximal number of threads to use for analyzing functions.
+    bool incrementalStructuring_; ///< Whether structural analysis updates the depth-first search incrementally.
+    std::shared_ptr<Statistics> statistics_; ///< Profiling statistics.
+    std::shared_ptr<DiskCache> cache_; ///< Persistent cache of decompilation results.
+    std::shared_ptr<ir::FunctionCache> functionCache_; ///< Cached per-function results.
+    std::vector<ByteAddr> selectedFunctions_; ///< Entry addresses of the functions to generate code for.
 
 public:
     /**
@@ -317,6 +332,99 @@ public:
      */
     const LogToken &logToken() const { return logToken_; }
 
+    /**
+     * Sets the maximal number of threads that may be used for running
+     * per-function analyses concurrently. 1 means no concurrency.
+     *
+     * \param threadCount Number of threads, must be positive.
+     */
+    void setThreadCount(int threadCount) { assert(threadCount > 0); threadCount_ = threadCount; }
+
+    /**
+     * \return Maximal number of threads that may be used for running per-function analyses.
+     */
+    int threadCount() const { return threadCount_; }
+
+    /**
+     * Sets whether structural analysis performs all applicable reductions
+     * of a kind in one pass and updates the depth-first search locally,
+     * instead of restarting after every reduction. Off by default.
+     *
+     * \param incremental Whether to structure regions incrementally.
+     *
+     * \see ir::cflow::StructureAnalyzer
+     */
+    void setIncrementalStructuring(bool incremental) { incrementalStructuring_ = incremental; }
+
+    /**
+     * \return True if structural analysis structures regions incrementally.
+     */
+    bool incrementalStructuring() const { return incrementalStructuring_; }
+
+    /**
+     * Sets the object collecting profiling statistics of the decompiler passes.
+     *
+     * \param statistics Pointer to the statistics. Can be nullptr, which disables profiling.
+     */
+    void setStatistics(const std::shared_ptr<Statistics> &statistics) { statistics_ = statistics; }
+
+    /**
+     * \return Pointer to the profiling statistics. Can be nullptr.
+     */
+    Statistics *statistics() const { return statistics_.get(); }
+
+    /**
+     * \return Shared pointer to the profiling statistics. Can be nullptr.
+     */
+    const std::shared_ptr<Statistics> &sharedStatistics() const { return statistics_; }
+
+    /**
+     * Sets the persistent cache of decompilation results, shared between runs.
+     *
+     * \param cache Pointer to the cache. Can be nullptr, which disables caching.
+     */
+    void setCache(const std::shared_ptr<DiskCache> &cache) { cache_ = cache; }
+
+    /**
+     * \return Pointer to the persistent cache of decompilation results. Can be nullptr.
+     */
+    DiskCache *cache() const { return cache_.get(); }
+
+    /**
+     * Sets the cache of per-function results. If there is none when the program
+     * is analyzed, it is created for the persistent cache, if there is one.
+     * A cache can be shared by contexts analyzing the same program, e.g. for
+     * reusing the results of the previous decompilation or of a restored session.
+     *
+     * \param functionCache Pointer to the cache. Can be nullptr.
+     */
+    void setFunctionCache(const std::shared_ptr<ir::FunctionCache> &functionCache) { functionCache_ = functionCache; }
+
+    /**
+     * \return Pointer to the cache of per-function results. Can be nullptr.
+     */
+    ir::FunctionCache *functionCache() const { return functionCache_.get(); }
+
+    /**
+     * \return Shared pointer to the cache of per-function results. Can be nullptr.
+     */
+    const std::shared_ptr<ir::FunctionCache> &sharedFunctionCache() const { return functionCache_; }
+
+    /**
+     * Restricts code generation to the functions with the given entry addresses.
+     * Other functions are still analyzed, e.g. for computing signatures,
+     * but only declared.
+     *
+     * \param addresses Entry addresses. Empty vector means all functions.
+     */
+    void setSelectedFunctions(std::vector<ByteAddr> addresses) { selectedFunctions_ = std::move(addresses); }
+
+    /**
+     * \return Entry addresses of the functions to generate code for.
+     *          Empty vector means all functions.
+     */
+    const std::vector<ByteAddr> &selectedFunctions() const { return selectedFunctions_; }
+
     Q_SIGNALS:
 
     /**
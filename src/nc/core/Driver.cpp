@@ -3,27 +3,125 @@
 
 #include "Driver.h"
 
+#include <algorithm>
+
 #include <QFile>
 
 #include <nc/common/Foreach.h>
 #include <nc/common/Exception.h>
+#include <nc/common/Parallel.h>
 
 #include <nc/core/arch/Architecture.h>
 #include <nc/core/arch/Disassembler.h>
+#include <nc/core/arch/Instruction.h>
 #include <nc/core/arch/Instructions.h>
 #include <nc/core/image/Image.h>
 #include <nc/core/image/Section.h>
+#include <nc/core/image/Symbol.h>
 #include <nc/core/input/Parser.h>
 #include <nc/core/input/ParserRepository.h>
 #include <nc/core/ir/Function.h>
 #include <nc/core/ir/Functions.h>
+#include <nc/core/irgen/RecursiveDisassembler.h>
 
 #include "Context.h"
 #include "MasterAnalyzer.h"
+#include "Session.h"
+#include "Statistics.h"
 
 namespace nc {
 namespace core {
 
+namespace {
+
+/** Minimal size of a shard for disassembling a range of addresses in parallel. */
+const ByteSize MIN_SHARD_SIZE = 1 << 20;
+
+/**
+ * Disassembles the range of addresses by splitting it into shards swept on
+ * multiple threads, each with its own disassembler. The result is the same as
+ * that of a single linear sweep over the whole range.
+ *
+ * \param context Context.
+ * \param source Valid pointer to a byte source.
+ * \param begin First address in the range.
+ * \param end First address past the range.
+ * \param callback Function being called for each disassembled instruction, in the order of addresses.
+ */
+void disassembleSharded(const Context &context, const image::ByteSource *source, ByteAddr begin, ByteAddr end,
+                        const arch::Disassembler::InstructionCallback &callback)
+{
+    auto image = context.image().get();
+    auto architecture = image->platform().architecture();
+    const auto &canceled = context.cancellationToken();
+
+    auto shardCount = static_cast<std::size_t>(std::min<ByteSize>(
+        (end - begin) / MIN_SHARD_SIZE, static_cast<ByteSize>(context.threadCount()) * 4));
+    assert(shardCount > 0);
+
+    std::vector<ByteAddr> bounds(shardCount + 1);
+    for (std::size_t i = 0; i <= shardCount; ++i) {
+        bounds[i] = begin + (end - begin) / static_cast<ByteSize>(shardCount) * static_cast<ByteSize>(i);
+    }
+    bounds.back() = end;
+
+    /*
+     * Sweep each shard starting from its first address. Shards are given
+     * enough trailing bytes to decode any instruction starting inside them,
+     * and a shard's sweep stops at the first address past the shard.
+     */
+    std::vector<std::vector<std::shared_ptr<arch::Instruction>>> shardInstructions(shardCount);
+    std::vector<ByteAddr> shardStops(shardCount);
+
+    parallelFor(shardCount, context.threadCount(), [&](std::size_t i) {
+        auto shardEnd = std::min(bounds[i + 1] + architecture->maxInstructionSize(), end);
+
+        shardStops[i] = architecture->createDisassembler()->disassembleUntil(
+            image, source, bounds[i], shardEnd,
+            [&](std::shared_ptr<arch::Instruction> instr) { shardInstructions[i].push_back(std::move(instr)); },
+            [&](ByteAddr pc) { return pc >= bounds[i + 1]; },
+            canceled);
+    });
+
+    /*
+     * Stitch the shards together. Decoding depends only on the address,
+     * so once the sequential sweep reaches the start of an instruction found
+     * in a shard, the rest of the shard's sweep coincides with the sequential
+     * one. Only the few instructions between a seam and such a point have to
+     * be decoded once more.
+     */
+    auto disassembler = architecture->createDisassembler();
+    ByteAddr pc = begin;
+
+    for (std::size_t i = 0; i < shardCount; ++i) {
+        const auto &instructions = shardInstructions[i];
+
+        auto findInstruction = [&](ByteAddr addr) {
+            return std::lower_bound(instructions.begin(), instructions.end(), addr,
+                [](const std::shared_ptr<arch::Instruction> &instr, ByteAddr value) { return instr->addr() < value; });
+        };
+
+        pc = disassembler->disassembleUntil(image, source, pc, end, callback,
+            [&](ByteAddr addr) {
+                if (addr >= bounds[i + 1]) {
+                    return true;
+                }
+                auto it = findInstruction(addr);
+                return it != instructions.end() && (*it)->addr() == addr;
+            },
+            canceled);
+
+        if (pc < bounds[i + 1]) {
+            for (auto it = findInstruction(pc); it != instructions.end(); ++it) {
+                callback(*it);
+            }
+            pc = shardStops[i];
+        }
+    }
+}
+
+} // anonymous namespace
+
 void Driver::parse(Context &context, const QString &filename) {
     QFile source(filename);
 
@@ -50,8 +148,13 @@ void Driver::parse(Context &context, const QString &filename) {
 
     context.logToken().info(tr("Parsing using %1 parser...").arg(suitableParser->name()));
 
+    PassMeasurement measurement(context.statistics(), "parse");
+
     suitableParser->parse(&source, context.image().get(), context.logToken());
 
+    measurement.addCounter("bytes", source.size());
+    measurement.addCounter("sections", context.image()->sections().size());
+
     context.logToken().info(tr("Parsing completed."));
 }
 
@@ -65,6 +168,90 @@ void Driver::disassemble(Context &context) {
     }
 }
 
+void Driver::disassembleReachable(Context &context) {
+    context.logToken().info(tr("Disassemble code reachable from entry points."));
+
+    auto image = context.image().get();
+    auto newInstructions = std::make_shared<arch::Instructions>(*context.instructions());
+
+    irgen::RecursiveDisassembler disassembler(image, newInstructions.get(), context.cancellationToken());
+
+    bool haveEntries = false;
+    if (image->entrypoint()) {
+        haveEntries |= disassembler.addEntry(*image->entrypoint());
+    }
+    foreach (const image::Symbol *symbol, image->symbols()) {
+        if (symbol->type() == image::SymbolType::FUNCTION && symbol->value()) {
+            haveEntries |= disassembler.addEntry(*symbol->value());
+        }
+    }
+
+    if (!haveEntries) {
+        context.logToken().warning(tr("No entry points found, disassembling all code sections instead."));
+        disassemble(context);
+        return;
+    }
+
+    PassMeasurement measurement(context.statistics(), "disassemble");
+
+    try {
+        disassembler.disassemble();
+
+        measurement.addCounter("rounds", disassembler.rounds());
+        measurement.addCounter("analyzedBlocks", disassembler.analyzedBlocks());
+        measurement.addCounter("instructions",
+            static_cast<qint64>(newInstructions->size()) - static_cast<qint64>(context.instructions()->size()));
+
+        context.setInstructions(newInstructions);
+
+        context.logToken().info(tr("Disassembly completed."));
+    } catch (const CancellationException &) {
+        context.logToken().info(tr("Disassembly canceled."));
+    }
+}
+
+void Driver::disassembleFunctions(Context &context, const std::vector<ByteAddr> &addresses) {
+    context.logToken().info(tr("Disassemble selected functions and their callees."));
+
+    PassMeasurement measurement(context.statistics(), "disassemble");
+
+    try {
+        auto image = context.image().get();
+        auto newInstructions = std::make_shared<arch::Instructions>(*context.instructions());
+
+        irgen::RecursiveDisassembler disassembler(image, newInstructions.get(), context.cancellationToken());
+        disassembler.setFollowCalls(false);
+
+        foreach (ByteAddr addr, addresses) {
+            if (!disassembler.addEntry(addr)) {
+                context.logToken().warning(tr("There is no code at address 0x%1.").arg(addr, 0, 16));
+            }
+        }
+        disassembler.disassemble();
+
+        /*
+         * Callees are decoded only for computing their signatures.
+         * Their own callees stay unknown.
+         */
+        std::vector<ByteAddr> callees = disassembler.calledAddresses();
+        foreach (ByteAddr addr, callees) {
+            disassembler.addEntry(addr);
+        }
+        disassembler.disassemble();
+
+        measurement.addCounter("rounds", disassembler.rounds());
+        measurement.addCounter("analyzedBlocks", disassembler.analyzedBlocks());
+        measurement.addCounter("instructions",
+            static_cast<qint64>(newInstructions->size()) - static_cast<qint64>(context.instructions()->size()));
+
+        context.setInstructions(newInstructions);
+
+        context.logToken().info(tr("Disassembly completed."));
+    } catch (const CancellationException &) {
+        context.logToken().info(tr("Disassembly canceled."));
+    }
+}
+
 void Driver::disassemble(Context &context, const image::Section *section) {
     assert(section != nullptr);
 
@@ -78,16 +265,29 @@ void Driver::disassemble(Context &context, const image::ByteSource *source, Byte
 
     context.logToken().info(tr("Disassemble addresses from %2 to %3...").arg(begin, 0, 16).arg(end, 0, 16));
 
+    PassMeasurement measurement(context.statistics(), "disassemble");
+
     try {
         auto newInstructions = std::make_shared<arch::Instructions>(*context.instructions());
 
-        context.image()->platform().architecture()->createDisassembler()->disassemble(
-            context.image().get(),
-            source,
-            begin,
-            end,
-            [&](std::shared_ptr<arch::Instruction> instr){ newInstructions->add(std::move(instr)); },
-            context.cancellationToken());
+        arch::Disassembler::InstructionCallback callback =
+            [&](std::shared_ptr<arch::Instruction> instr){ newInstructions->add(std::move(instr)); };
+
+        if (context.threadCount() > 1 && end - begin >= 2 * MIN_SHARD_SIZE) {
+            disassembleSharded(context, source, begin, end, callback);
+        } else {
+            context.image()->platform().architecture()->createDisassembler()->disassemble(
+                context.image().get(),
+                source,
+                begin,
+                end,
+                callback,
+                context.cancellationToken());
+        }
+
+        measurement.addCounter("bytes", end - begin);
+        measurement.addCounter("instructions",
+            static_cast<qint64>(newInstructions->size()) - static_cast<qint64>(context.instructions()->size()));
 
         context.setInstructions(newInstructions);
 
@@ -106,6 +306,41 @@ void Driver::decompile(Context &context) {
     }
 }
 
+void Driver::decompile(Context &context, QTextStream &out) {
+    try {
+        context.image()->platform().architecture()->masterAnalyzer()->decompile(context, out);
+    } catch (const CancellationException &) {
+        context.logToken().info(tr("Decompilation canceled."));
+        throw;
+    }
+}
+
+void Driver::saveSession(const Context &context, const QString &filename) {
+    context.logToken().info(tr("Saving session to %1...").arg(filename));
+
+    QFile file(filename);
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+        throw nc::Exception(tr("Could not open file \"%1\" for writing.").arg(filename));
+    }
+
+    Session::save(context, &file);
+
+    context.logToken().info(tr("Session saved."));
+}
+
+void Driver::loadSession(Context &context, const QString &filename) {
+    context.logToken().info(tr("Loading session from %1...").arg(filename));
+
+    QFile file(filename);
+    if (!file.open(QIODevice::ReadOnly)) {
+        throw nc::Exception(tr("Could not open file \"%1\" for reading.").arg(filename));
+    }
+
+    Session::load(context, &file);
+
+    context.logToken().info(tr("Session loaded."));
+}
+
 } // namespace core
 } // namespace nc
 
@@ -5,10 +5,16 @@
 
 #include <nc/config.h>
 
+#include <vector>
+
 #include <nc/common/Types.h>
 
 #include <QCoreApplication> /* For Q_DECLARE_TR_FUNCTIONS. */
 
+QT_BEGIN_NAMESPACE
+class QTextStream;
+QT_END_NAMESPACE
+
 namespace nc {
 namespace core {
 
@@ -41,6 +47,26 @@ public:
      */
     static void disassemble(Context &context);
 
+    /**
+     * Disassembles the code reachable from the entry point and function
+     * symbols of the image, following jumps, calls, and jump tables.
+     * Falls back to disassembling all code sections if there is neither
+     * an entry point nor a function symbol in a code section.
+     *
+     * \param context Context.
+     */
+    static void disassembleReachable(Context &context);
+
+    /**
+     * Disassembles the functions starting at the given addresses and the
+     * functions called by them, so that signatures of the callees can be
+     * reconstructed. Calls made by the callees are not followed.
+     *
+     * \param context Context.
+     * \param addresses Entry addresses of the functions.
+     */
+    static void disassembleFunctions(Context &context, const std::vector<ByteAddr> &addresses);
+
     /**
      * Disassembles an image section.
      *
@@ -51,6 +77,8 @@ public:
 
     /*
      * Disassembles all instructions in the given range of addresses.
+     * Large ranges are split into shards disassembled in parallel
+     * if the context's thread count allows it.
      *
      * \param context Context.
      * \param source Valid pointer to a byte source.
@@ -66,6 +94,32 @@ public:
      * \param context Context.
      */
     static void decompile(Context &context);
+
+    /**
+     * Performs decompilation, printing the generated code function
+     * by function instead of building the whole tree.
+     *
+     * \param context Context.
+     * \param out Output stream.
+     */
+    static void decompile(Context &context, QTextStream &out);
+
+    /**
+     * Saves a snapshot of the decompilation session to the given file.
+     *
+     * \param context Context.
+     * \param filename Name of the file.
+     */
+    static void saveSession(const Context &context, const QString &filename);
+
+    /**
+     * Restores a decompilation session from the given file.
+     * The restored sections read their contents from a memory mapping of the file, when possible.
+     *
+     * \param context Context with an empty image.
+     * \param filename Name of the file.
+     */
+    static void loadSession(Context &context, const QString &filename);
 };
 
 } // namespace core
@@ -24,24 +24,34 @@
 
 #include "MasterAnalyzer.h"
 
+#include <vector>
+
+#include <QTextStream>
+
 #include <nc/common/Foreach.h>
+#include <nc/common/Parallel.h>
 #include <nc/common/make_unique.h>
 
 #include <nc/core/Context.h>
+#include <nc/core/Statistics.h>
 #include <nc/core/arch/Architecture.h>
+#include <nc/core/arch/Instructions.h>
 #include <nc/core/image/Image.h>
 #include <nc/core/ir/BasicBlock.h>
 #include <nc/core/ir/CFG.h>
 #include <nc/core/ir/Function.h>
+#include <nc/core/ir/FunctionCache.h>
 #include <nc/core/ir/Functions.h>
 #include <nc/core/ir/FunctionsGenerator.h>
 #include <nc/core/ir/Program.h>
 #include <nc/core/ir/calling/Conventions.h>
+#include <nc/core/ir/calling/FunctionSignature.h>
 #include <nc/core/ir/calling/Hooks.h>
 #include <nc/core/ir/calling/SignatureAnalyzer.h>
 #include <nc/core/ir/calling/Signatures.h>
 #include <nc/core/ir/cflow/Graphs.h>
 #include <nc/core/ir/cflow/GraphBuilder.h>
+#include <nc/core/ir/cflow/Reductions.h>
 #include <nc/core/ir/cflow/StructureAnalyzer.h>
 #include <nc/core/ir/cgen/CodeGenerator.h>
 #include <nc/core/ir/cgen/NameGenerator.h>
@@ -54,6 +64,7 @@
 #include <nc/core/ir/vars/VariableAnalyzer.h>
 #include <nc/core/ir/vars/Variables.h>
 #include <nc/core/irgen/IRGenerator.h>
+#include <nc/core/likec/Declaration.h>
 #include <nc/core/likec/Tree.h>
 #include <nc/core/mangling/Demangler.h>
 
@@ -65,11 +76,18 @@ MasterAnalyzer::~MasterAnalyzer() {}
 void MasterAnalyzer::createProgram(Context &context) const {
     context.logToken().info(tr("Creating intermediate representation of the program."));
 
+    PassMeasurement measurement(context.statistics(), "createProgram");
+
     std::unique_ptr<ir::Program> program(new ir::Program());
 
-    core::irgen::IRGenerator(context.image().get(), context.instructions().get(), program.get(),
-        context.cancellationToken(), context.logToken())
-    .generate();
+    core::irgen::IRGenerator generator(context.image().get(), context.instructions().get(), program.get(),
+        context.cancellationToken(), context.logToken());
+    generator.setThreadCount(context.threadCount());
+    generator.generate();
+
+    measurement.addCounter("instructions", context.instructions()->size());
+    measurement.addCounter("basicBlocks", program->basicBlocks().size());
+    measurement.addCounter("arenaBytes", program->arena().allocatedSize());
 
     context.setProgram(std::move(program));
 }
@@ -77,10 +95,21 @@ void MasterAnalyzer::createProgram(Context &context) const {
 void MasterAnalyzer::createFunctions(Context &context) const {
     context.logToken().info(tr("Creating functions."));
 
+    PassMeasurement measurement(context.statistics(), "createFunctions");
+
     std::unique_ptr<ir::Functions> functions(new ir::Functions);
 
     ir::FunctionsGenerator().makeFunctions(*context.program(), *functions);
 
+    if (measurement.enabled()) {
+        std::size_t arenaBytes = 0;
+        foreach (auto function, functions->list()) {
+            arenaBytes += function->arena().allocatedSize();
+        }
+        measurement.addCounter("functions", functions->list().size());
+        measurement.addCounter("arenaBytes", arenaBytes);
+    }
+
     context.setFunctions(std::move(functions));
 }
 
@@ -106,83 +135,180 @@ void MasterAnalyzer::detectCallingConvention(Context &context, const ir::calling
     }
 }
 
+void MasterAnalyzer::loadCache(Context &context) const {
+    if (!context.functionCache()) {
+        if (!context.cache()) {
+            return;
+        }
+        context.setFunctionCache(std::make_shared<ir::FunctionCache>(context.cache()));
+    }
+
+    context.logToken().info(tr("Loading cached results of functions."));
+
+    PassMeasurement measurement(context.statistics(), "loadCache");
+
+    auto functionCache = context.functionCache();
+    functionCache->load(*context.image(), *context.functions(), *context.hooks());
+
+    measurement.addCounter("functions", functionCache->size());
+    measurement.addCounter("hits", functionCache->hits());
+}
+
 void MasterAnalyzer::dataflowAnalysis(Context &context) const {
     context.logToken().info(tr("Dataflow analysis."));
 
+    PassMeasurement measurement(context.statistics(), "dataflowAnalysis");
+
     context.setDataflows(std::make_unique<ir::dflow::Dataflows>());
 
-    foreach (auto function, context.functions()->list()) {
-        dataflowAnalysis(context, function);
+    std::vector<ir::Function *> functions(context.functions()->list().begin(), context.functions()->list().end());
+    std::vector<std::unique_ptr<ir::dflow::Dataflow>> dataflows(functions.size());
+
+    parallelFor(functions.size(), context.threadCount(), [&](std::size_t i) {
+        dataflows[i] = dataflowAnalysis(context, functions[i], measurement);
         context.cancellationToken().poll();
+    });
+
+    for (std::size_t i = 0; i < functions.size(); ++i) {
+        context.dataflows()->emplace(functions[i], std::move(dataflows[i]));
     }
 }
 
-void MasterAnalyzer::dataflowAnalysis(Context &context, ir::Function *function) const {
-    context.logToken().info(tr("Dataflow analysis of %1.").arg(getFunctionName(context, function)));
+std::unique_ptr<ir::dflow::Dataflow> MasterAnalyzer::dataflowAnalysis(Context &context, ir::Function *function, const PassMeasurement &pass) const {
+    if (context.logToken().enabled()) {
+        context.logToken().info(tr("Dataflow analysis of %1.").arg(getFunctionName(context, function)));
+    }
+
+    FunctionMeasurement measurement(pass, function);
 
     std::unique_ptr<ir::dflow::Dataflow> dataflow(new ir::dflow::Dataflow());
 
     context.hooks()->instrument(function, dataflow.get());
 
-    ir::dflow::DataflowAnalyzer(*dataflow, context.image()->platform().architecture(), context.cancellationToken(),
-                                context.logToken()).analyze(ir::CFG(function->basicBlocks()));
+    ir::dflow::DataflowAnalyzer analyzer(*dataflow, context.image()->platform().architecture(),
+                                         context.cancellationToken(), context.logToken());
+    analyzer.analyze(ir::CFG(function->basicBlocks()));
 
-    context.dataflows()->emplace(function, std::move(dataflow));
+    measurement.addCounter("basicBlockExecutions", analyzer.basicBlockExecutions());
+    measurement.addCounter("terms", dataflow->terms().size());
+
+    return dataflow;
 }
 
 void MasterAnalyzer::reconstructSignatures(Context &context) const {
     context.logToken().info(tr("Reconstructing function signatures."));
 
-    ir::calling::SignatureAnalyzer(*context.signatures(), *context.dataflows(), *context.hooks(),
-        *context.livenesses(), context.cancellationToken(), context.logToken())
-        .analyze();
+    PassMeasurement measurement(context.statistics(), "reconstructSignatures");
+
+    ir::calling::SignatureAnalyzer analyzer(*context.signatures(), *context.dataflows(), *context.hooks(),
+        *context.livenesses(), context.cancellationToken(), context.logToken());
+
+    auto functionCache = context.functionCache();
+    if (functionCache) {
+        std::size_t known = 0;
+        foreach (const ir::Function *function, context.functions()->list()) {
+            if (auto signature = functionCache->getSignature(function)) {
+                analyzer.setKnownSignature(ir::calling::getCalleeId(function), signature->arguments, signature->returnValue);
+                ++known;
+            }
+        }
+        measurement.addCounter("cachedSignatures", known);
+    }
+
+    analyzer.analyze();
+
+    if (functionCache) {
+        foreach (const ir::Function *function, context.functions()->list()) {
+            if (functionCache->getSignature(function)) {
+                continue;
+            }
+
+            /* Extra arguments of variadic functions are computed from the calls. */
+            auto signature = context.signatures()->getSignature(function);
+            if (signature && signature->variadic()) {
+                continue;
+            }
+
+            auto calleeId = ir::calling::getCalleeId(function);
+
+            ir::FunctionCache::Signature cached;
+            cached.arguments = analyzer.getArguments(calleeId);
+            cached.returnValue = analyzer.getReturnValue(calleeId);
+            functionCache->setSignature(function, std::move(cached));
+        }
+    }
 }
 
 void MasterAnalyzer::reconstructVariables(Context &context) const {
     context.logToken().info(tr("Reconstructing variables."));
 
+    PassMeasurement measurement(context.statistics(), "reconstructVariables");
+
     std::unique_ptr<ir::vars::Variables> variables(new ir::vars::Variables());
 
     ir::vars::VariableAnalyzer(*variables, *context.dataflows(), context.image()->platform().architecture())
         .analyze();
 
+    measurement.addCounter("variables", variables->list().size());
+
     context.setVariables(std::move(variables));
 }
 
 void MasterAnalyzer::livenessAnalysis(Context &context) const {
     context.logToken().info(tr("Liveness analysis."));
 
+    PassMeasurement measurement(context.statistics(), "livenessAnalysis");
+
     context.setLivenesses(std::make_unique<ir::liveness::Livenesses>());
 
-    foreach (const ir::Function *function, context.functions()->list()) {
-        livenessAnalysis(context, function);
+    std::vector<const ir::Function *> functions(context.functions()->list().begin(), context.functions()->list().end());
+    std::vector<std::unique_ptr<ir::liveness::Liveness>> livenesses(functions.size());
+
+    parallelFor(functions.size(), context.threadCount(), [&](std::size_t i) {
+        auto graph = context.graphs() ? context.graphs()->at(functions[i]).get() : nullptr;
+        livenesses[i] = livenessAnalysis(context, functions[i], graph, measurement);
+    });
+
+    for (std::size_t i = 0; i < functions.size(); ++i) {
+        context.livenesses()->emplace(functions[i], std::move(livenesses[i]));
     }
 }
 
-void MasterAnalyzer::livenessAnalysis(Context &context, const ir::Function *function) const {
-    context.logToken().info(tr("Liveness analysis of %1.").arg(getFunctionName(context, function)));
+std::unique_ptr<ir::liveness::Liveness> MasterAnalyzer::livenessAnalysis(Context &context, const ir::Function *function,
+    const ir::cflow::Graph *graph, const PassMeasurement &pass) const
+{
+    if (context.logToken().enabled()) {
+        context.logToken().info(tr("Liveness analysis of %1.").arg(getFunctionName(context, function)));
+    }
+
+    FunctionMeasurement measurement(pass, function);
 
     std::unique_ptr<ir::liveness::Liveness> liveness(new ir::liveness::Liveness());
 
     ir::liveness::LivenessAnalyzer(*liveness, function,
         *context.dataflows()->at(function), context.image()->platform().architecture(),
-        context.graphs() ? context.graphs()->at(function).get() : nullptr, *context.hooks(),
+        graph, *context.hooks(),
         context.signatures(), context.logToken())
     .analyze();
 
-    context.livenesses()->emplace(function, std::move(liveness));
+    return liveness;
 }
 
 void MasterAnalyzer::reconstructTypes(Context &context) const {
     context.logToken().info(tr("Reconstructing types."));
 
+    PassMeasurement measurement(context.statistics(), "reconstructTypes");
+
     std::unique_ptr<ir::types::Types> types(new ir::types::Types());
 
-    ir::types::TypeAnalyzer(
+    ir::types::TypeAnalyzer analyzer(
         *types, *context.functions(), *context.dataflows(), *context.variables(),
         *context.livenesses(), *context.hooks(), *context.signatures(),
-        context.cancellationToken())
-    .analyze();
+        context.cancellationToken());
+    analyzer.analyze();
+
+    measurement.addCounter("rounds", analyzer.rounds());
+    measurement.addCounter("visits", analyzer.visits());
 
     context.setTypes(std::move(types));
 }
@@ -190,41 +316,148 @@ void MasterAnalyzer::reconstructTypes(Context &context) const {
 void MasterAnalyzer::structuralAnalysis(Context &context) const {
     context.logToken().info(tr("Structural analysis."));
 
+    PassMeasurement measurement(context.statistics(), "structuralAnalysis");
+
     context.setGraphs(std::make_unique<ir::cflow::Graphs>());
 
-    foreach (auto function, context.functions()->list()) {
-        structuralAnalysis(context, function);
+    std::vector<const ir::Function *> functions(context.functions()->list().begin(), context.functions()->list().end());
+    std::vector<std::unique_ptr<ir::cflow::Graph>> graphs(functions.size());
+
+    parallelFor(functions.size(), context.threadCount(), [&](std::size_t i) {
+        graphs[i] = structuralAnalysis(context, functions[i], measurement);
         context.cancellationToken().poll();
+    });
+
+    for (std::size_t i = 0; i < functions.size(); ++i) {
+        context.graphs()->emplace(functions[i], std::move(graphs[i]));
     }
 }
 
-void MasterAnalyzer::structuralAnalysis(Context &context, const ir::Function *function) const {
-    context.logToken().info(tr("Structural analysis of %1.").arg(getFunctionName(context, function)));
+std::unique_ptr<ir::cflow::Graph> MasterAnalyzer::structuralAnalysis(Context &context, const ir::Function *function, const PassMeasurement &pass) const {
+    if (context.logToken().enabled()) {
+        context.logToken().info(tr("Structural analysis of %1.").arg(getFunctionName(context, function)));
+    }
 
-    std::unique_ptr<ir::cflow::Graph> graph(new ir::cflow::Graph());
+    FunctionMeasurement measurement(pass, function);
 
+    const auto &dataflow = *context.dataflows()->at(function);
+
+    /* Incremental structuring can produce different regions, so its results are not cached. */
+    auto functionCache = context.incrementalStructuring() ? nullptr : context.functionCache();
+    auto reductions = functionCache ? functionCache->getReductions(function) : nullptr;
+
+    std::unique_ptr<ir::cflow::Graph> graph(new ir::cflow::Graph());
     ir::cflow::GraphBuilder()(*graph, function);
-    ir::cflow::StructureAnalyzer(*graph, *context.dataflows()->at(function)).analyze();
 
-    context.graphs()->emplace(function, std::move(graph));
+    if (reductions && !ir::cflow::StructureAnalyzer(*graph, dataflow).replay(*reductions)) {
+        /* The graph is left partially reduced. */
+        graph.reset(new ir::cflow::Graph());
+        ir::cflow::GraphBuilder()(*graph, function);
+        reductions = nullptr;
+    }
+
+    if (reductions) {
+        measurement.addCounter("replayed", 1);
+    } else {
+        ir::cflow::StructureAnalyzer analyzer(*graph, dataflow, context.incrementalStructuring());
+        ir::cflow::Reductions recording;
+        if (functionCache) {
+            analyzer.setRecording(&recording);
+        }
+        analyzer.analyze();
+
+        if (functionCache && recording.complete()) {
+            functionCache->setReductions(function, std::move(recording));
+        }
+    }
+
+    measurement.addCounter("nodes", graph->nodes().size());
+
+    return graph;
+}
+
+void MasterAnalyzer::structuralAndLivenessAnalysis(Context &context) const {
+    context.logToken().info(tr("Structural and liveness analysis."));
+
+    PassMeasurement measurement(context.statistics(), "structuralAndLivenessAnalysis");
+
+    context.setGraphs(std::make_unique<ir::cflow::Graphs>());
+    context.setLivenesses(std::make_unique<ir::liveness::Livenesses>());
+
+    std::vector<const ir::Function *> functions(context.functions()->list().begin(), context.functions()->list().end());
+    std::vector<std::unique_ptr<ir::liveness::Liveness>> livenesses(functions.size());
+
+    parallelFor(functions.size(), context.threadCount(), [&](std::size_t i) {
+        auto graph = structuralAnalysis(context, functions[i], measurement);
+        livenesses[i] = livenessAnalysis(context, functions[i], graph.get(), measurement);
+        context.cancellationToken().poll();
+    });
+
+    for (std::size_t i = 0; i < functions.size(); ++i) {
+        context.livenesses()->emplace(functions[i], std::move(livenesses[i]));
+    }
 }
 
 void MasterAnalyzer::generateTree(Context &context) const {
     context.logToken().info(tr("Generating AST."));
 
+    PassMeasurement measurement(context.statistics(), "generateTree");
+
     auto tree = std::make_unique<nc::core::likec::Tree>();
 
-    ir::cgen::CodeGenerator(*tree, *context.image(), *context.functions(), *context.hooks(),
+    ir::cgen::CodeGenerator generator(*tree, *context.image(), *context.functions(), *context.hooks(),
         *context.signatures(), *context.dataflows(), *context.variables(), *context.graphs(),
-        *context.livenesses(), *context.types(), context.cancellationToken())
-        .makeCompilationUnit();
+        *context.livenesses(), *context.types(), context.cancellationToken());
+    generator.setCache(context.functionCache());
+    generator.setThreadCount(context.threadCount());
+    generator.selectFunctions(context.selectedFunctions());
+    generator.makeCompilationUnit();
+
+    if (context.functionCache()) {
+        context.functionCache()->store();
+    }
 
     context.setTree(std::move(tree));
 }
 
-void MasterAnalyzer::decompile(Context &context) const {
-    context.logToken().info(tr("Decompiling."));
+void MasterAnalyzer::streamTree(Context &context, QTextStream &out) const {
+    context.logToken().info(tr("Generating and printing code function by function."));
+
+    PassMeasurement measurement(context.statistics(), "streamTree");
+
+    likec::Tree tree;
 
+    ir::cgen::CodeGenerator generator(tree, *context.image(), *context.functions(), *context.hooks(),
+        *context.signatures(), *context.dataflows(), *context.variables(), *context.graphs(),
+        *context.livenesses(), *context.types(), context.cancellationToken());
+    generator.setCache(context.functionCache());
+    generator.setThreadCount(context.threadCount());
+    generator.selectFunctions(context.selectedFunctions());
+    generator.makeCompilationUnit([&](const ir::Function *function) {
+        /* The graph was discarded after computing the function's liveness. */
+        context.graphs()->emplace(function, structuralAnalysis(context, function, measurement));
+    }, [&](const ir::Function *function, const std::vector<const likec::Declaration *> &declarations) {
+        /* Same layout as produced by printing a whole compilation unit. */
+        foreach (const likec::Declaration *declaration, declarations) {
+            out << endl;
+            declaration->print(out);
+            out << endl;
+        }
+        out.flush();
+
+        context.dataflows()->erase(function);
+        context.livenesses()->erase(function);
+        context.graphs()->erase(function);
+    });
+
+    if (context.functionCache()) {
+        context.functionCache()->store();
+    }
+
+    measurement.addCounter("declarations", tree.root()->declarations().size());
+}
+
+void MasterAnalyzer::analyzeDataflows(Context &context) const {
     createProgram(context);
     context.cancellationToken().poll();
 
@@ -237,6 +470,9 @@ void MasterAnalyzer::decompile(Context &context) const {
     detectCallingConventions(context);
     context.cancellationToken().poll();
 
+    loadCache(context);
+    context.cancellationToken().poll();
+
     dataflowAnalysis(context);
     context.cancellationToken().poll();
 
@@ -251,6 +487,10 @@ void MasterAnalyzer::decompile(Context &context) const {
 
     reconstructVariables(context);
     context.cancellationToken().poll();
+}
+
+void MasterAnalyzer::analyze(Context &context) const {
+    analyzeDataflows(context);
 
     structuralAnalysis(context);
     context.cancellationToken().poll();
@@ -260,6 +500,22 @@ void MasterAnalyzer::decompile(Context &context) const {
 
     reconstructTypes(context);
     context.cancellationToken().poll();
+}
+
+void MasterAnalyzer::analyzeForStreaming(Context &context) const {
+    analyzeDataflows(context);
+
+    structuralAndLivenessAnalysis(context);
+    context.cancellationToken().poll();
+
+    reconstructTypes(context);
+    context.cancellationToken().poll();
+}
+
+void MasterAnalyzer::decompile(Context &context) const {
+    context.logToken().info(tr("Decompiling."));
+
+    analyze(context);
 
     generateTree(context);
     context.cancellationToken().poll();
@@ -267,6 +523,17 @@ void MasterAnalyzer::decompile(Context &context) const {
     context.logToken().info(tr("Decompilation completed."));
 }
 
+void MasterAnalyzer::decompile(Context &context, QTextStream &out) const {
+    context.logToken().info(tr("Decompiling."));
+
+    analyzeForStreaming(context);
+
+    streamTree(context, out);
+    context.cancellationToken().poll();
+
+    context.logToken().info(tr("Decompilation completed."));
+}
+
 QString MasterAnalyzer::getFunctionName(Context &context, const ir::Function *function) const {
     return ir::cgen::NameGenerator(*context.image()).getFunctionName(function).name();
 }
@@ -25,8 +25,14 @@
 
 #include <nc/config.h>
 
+#include <memory>
+
 #include <QCoreApplication> /* For Q_DECLARE_TR_FUNCTIONS. */
 
+QT_BEGIN_NAMESPACE
+class QTextStream;
+QT_END_NAMESPACE
+
 namespace nc {
 namespace core {
 
@@ -36,9 +42,19 @@ namespace ir {
     namespace calling {
         class CalleeId;
     }
+    namespace cflow {
+        class Graph;
+    }
+    namespace dflow {
+        class Dataflow;
+    }
+    namespace liveness {
+        class Liveness;
+    }
 }
 
 class Context;
+class PassMeasurement;
 
 /**
  * Class capable of performing various kinds of analysis in the right order.
@@ -48,8 +64,12 @@ class Context;
  * and register it by calling Architecture::setMasterAnalyzer().
  * 
  * Methods of this class can be executed concurrently.
- * (Though, only on different context currently.)
  * Therefore, they all are const.
+ *
+ * Per-function analyses of the same context are run concurrently
+ * by up to Context::threadCount() threads. Their results are stored
+ * in the context in the order of functions, independent of the
+ * order in which the threads finish.
  */
 class MasterAnalyzer {
     Q_DECLARE_TR_FUNCTIONS(MasterAnalyzer)
@@ -91,6 +111,14 @@ public:
      */
     virtual void detectCallingConvention(Context &context, const ir::calling::CalleeId &calleeId) const;
 
+    /**
+     * Loads the results of the functions analyzed in previous runs
+     * from the persistent cache, if there is one.
+     *
+     * \param context Context.
+     */
+    virtual void loadCache(Context &context) const;
+
     /**
      * Performs dataflow analysis of all functions.
      *
@@ -100,11 +128,15 @@ public:
 
     /**
      * Performs dataflow analysis of the given function.
+     * Can be called concurrently for different functions.
      *
      * \param context Context.
      * \param function Valid pointer to the function.
+     * \param pass Measurement of the pass the function is analyzed by.
+     *
+     * \return Valid pointer to the dataflow information for the function.
      */
-    virtual void dataflowAnalysis(Context &context, ir::Function *function) const;
+    virtual std::unique_ptr<ir::dflow::Dataflow> dataflowAnalysis(Context &context, ir::Function *function, const PassMeasurement &pass) const;
 
     /**
      * Reconstructs signatures of functions.
@@ -129,11 +161,17 @@ public:
 
     /**
      * Performs liveness analysis on the given function.
+     * Can be called concurrently for different functions.
      *
      * \param context Context.
      * \param function Valid pointer to the function.
+     * \param graph Pointer to the structural graph of the function. Can be nullptr.
+     * \param pass Measurement of the pass the function is analyzed by.
+     *
+     * \return Valid pointer to the liveness information for the function.
      */
-    virtual void livenessAnalysis(Context &context, const ir::Function *function) const;
+    virtual std::unique_ptr<ir::liveness::Liveness> livenessAnalysis(Context &context, const ir::Function *function,
+        const ir::cflow::Graph *graph, const PassMeasurement &pass) const;
 
     /**
      * Performs structural analysis of all functions.
@@ -144,11 +182,24 @@ public:
 
     /**
      * Performs structural analysis of a function.
+     * Can be called concurrently for different functions.
      *
      * \param context Context.
      * \param function Valid pointer to the function.
+     * \param pass Measurement of the pass the function is analyzed by.
+     *
+     * \return Valid pointer to the structural graph of the function.
      */
-    virtual void structuralAnalysis(Context &context, const ir::Function *function) const;
+    virtual std::unique_ptr<ir::cflow::Graph> structuralAnalysis(Context &context, const ir::Function *function, const PassMeasurement &pass) const;
+
+    /**
+     * Performs structural analysis and liveness analysis of all functions,
+     * discarding the structural graph of each function as soon as its
+     * liveness is computed. Leaves the context with no structural graphs.
+     *
+     * \param context Context.
+     */
+    virtual void structuralAndLivenessAnalysis(Context &context) const;
 
     /**
      * Computes information about types.
@@ -164,6 +215,44 @@ public:
      */
     virtual void generateTree(Context &context) const;
 
+    /**
+     * Generates the definitions of functions one at a time and prints
+     * each of them, together with the declarations it needs, as soon as it
+     * is generated. The structural graph of a function is built right
+     * before generating its definition. The body of the definition and the
+     * dataflow, liveness, and structural information of the function are
+     * released right after printing. The context is left without a tree.
+     *
+     * \param context Context.
+     * \param out Output stream.
+     */
+    virtual void streamTree(Context &context, QTextStream &out) const;
+
+    /**
+     * Runs all the analyses needed for generating the code,
+     * i.e. all the steps of decompilation except for the last one.
+     *
+     * \param context Context.
+     */
+    virtual void analyze(Context &context) const;
+
+    /**
+     * Runs the analyses needed for generating the code function by function
+     * with streamTree(). Same as analyze(), except that the structural graphs
+     * are not kept, so that at most one exists at a time.
+     *
+     * \param context Context.
+     */
+    virtual void analyzeForStreaming(Context &context) const;
+
+    /**
+     * Runs the analyses shared by analyze() and analyzeForStreaming(),
+     * i.e. all the steps up to and including the reconstruction of variables.
+     *
+     * \param context Context.
+     */
+    virtual void analyzeDataflows(Context &context) const;
+
     /**
      * Decompiles the assembler program.
      *
@@ -171,6 +260,17 @@ public:
      */
     virtual void decompile(Context &context) const;
 
+    /**
+     * Decompiles the assembler program, printing the generated code
+     * function by function instead of building the whole tree.
+     *
+     * \param context Context.
+     * \param out Output stream.
+     *
+     * \see streamTree()
+     */
+    virtual void decompile(Context &context, QTextStream &out) const;
+
 protected:
     /**
      * \param context Context.
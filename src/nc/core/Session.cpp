@@ -0,0 +1,444 @@
+/* The file is part of Snowman decompiler. */
+/* See doc/licenses.asciidoc for the licensing information. */
+
+#include "Session.h"
+
+#include <cstring>
+#include <limits>
+
+#include <QDataStream>
+#include <QIODevice>
+#include <QTextStream>
+
+#include <boost/unordered_map.hpp>
+
+#include <nc/common/Exception.h>
+#include <nc/common/Foreach.h>
+#include <nc/common/Parallel.h>
+#include <nc/common/Range.h>
+#include <nc/common/Version.h>
+#include <nc/common/make_unique.h>
+
+#include <nc/core/arch/Architecture.h>
+#include <nc/core/arch/ArchitectureRepository.h>
+#include <nc/core/arch/Disassembler.h>
+#include <nc/core/arch/Instruction.h>
+#include <nc/core/arch/Instructions.h>
+#include <nc/core/image/Image.h>
+#include <nc/core/image/MappedByteSource.h>
+#include <nc/core/image/MappedFile.h>
+#include <nc/core/image/Relocation.h>
+#include <nc/core/image/Section.h>
+#include <nc/core/image/Symbol.h>
+#include <nc/core/ir/FunctionCache.h>
+#include <nc/core/likec/CompilationUnit.h>
+#include <nc/core/likec/Tree.h>
+#include <nc/core/likec/VerbatimDeclaration.h>
+
+#include "Context.h"
+#include "Statistics.h"
+
+namespace nc {
+namespace core {
+
+namespace {
+
+/** Magic bytes at the beginning of a snapshot. */
+const char MAGIC[] = "NCSESSION";
+
+/** Version of the snapshot format. Incremented on every incompatible change. */
+const quint32 FORMAT_VERSION = 2;
+
+/** Number of instructions disassembled by a single task when restoring a snapshot. */
+const std::size_t INSTRUCTIONS_PER_TASK = 1 << 16;
+
+/** Size written by QDataStream in place of the size of a null QByteArray. */
+const quint32 NULL_BYTE_ARRAY = 0xffffffff;
+
+void checkStatus(const QDataStream &stream) {
+    if (stream.status() != QDataStream::Ok) {
+        throw nc::Exception(Session::tr("The session file is truncated or corrupt."));
+    }
+}
+
+/**
+ * Reads the contents of a section, written as a QByteArray, and attaches them to the section.
+ * If the snapshot is memory-mapped, the section reads its bytes directly from the mapping.
+ *
+ * \param in Stream reading from a device.
+ * \param mappedFile Mapping of the device's file. Can be nullptr.
+ * \param section Valid pointer to the section.
+ */
+void loadContent(QDataStream &in, const std::shared_ptr<const image::MappedFile> &mappedFile, image::Section *section) {
+    quint32 size;
+    in >> size;
+    checkStatus(in);
+
+    if (size == NULL_BYTE_ARRAY || size == 0) {
+        return;
+    }
+    if (size > static_cast<quint32>(std::numeric_limits<int>::max())) {
+        throw nc::Exception(Session::tr("The session file is truncated or corrupt."));
+    }
+
+    auto offset = in.device()->pos();
+
+    if (mappedFile && mappedFile->contains(offset, size)) {
+        if (in.skipRawData(size) != static_cast<int>(size)) {
+            throw nc::Exception(Session::tr("The session file is truncated or corrupt."));
+        }
+        section->setExternalByteSource(std::make_unique<image::MappedByteSource>(mappedFile, section, offset, size));
+    } else {
+        QByteArray content;
+        content.resize(size);
+        if (in.readRawData(content.data(), size) != static_cast<int>(size)) {
+            throw nc::Exception(Session::tr("The session file is truncated or corrupt."));
+        }
+        section->setContent(std::move(content));
+    }
+}
+
+void saveSymbol(QDataStream &out, const image::Symbol *symbol,
+                const boost::unordered_map<const image::Section *, qint32> &section2index)
+{
+    out << static_cast<qint32>(symbol->type()) << symbol->name() << static_cast<bool>(symbol->value())
+        << static_cast<quint64>(symbol->value() ? *symbol->value() : 0);
+
+    auto i = section2index.find(symbol->section());
+    out << (i != section2index.end() ? i->second : qint32(-1));
+}
+
+std::unique_ptr<image::Symbol> loadSymbol(QDataStream &in, const image::Image *image) {
+    const auto &sections = image->sections();
+
+    qint32 type, sectionIndex;
+    QString name;
+    bool hasValue;
+    quint64 value;
+
+    in >> type >> name >> hasValue >> value >> sectionIndex;
+    checkStatus(in);
+
+    if (type < image::SymbolType::NOTYPE || type > image::SymbolType::SECTION ||
+        sectionIndex < -1 || sectionIndex >= static_cast<qint32>(sections.size())) {
+        throw nc::Exception(Session::tr("The session file is truncated or corrupt."));
+    }
+
+    return std::make_unique<image::Symbol>(
+        static_cast<image::SymbolType::Type>(type),
+        std::move(name),
+        hasValue ? boost::optional<ConstantValue>(value) : boost::none,
+        sectionIndex >= 0 ? sections[sectionIndex] : nullptr);
+}
+
+} // anonymous namespace
+
+void Session::save(const Context &context, QIODevice *device) {
+    assert(device != nullptr);
+
+    PassMeasurement measurement(context.statistics(), "saveSession");
+
+    const image::Image *image = context.image().get();
+
+    QDataStream out(device);
+    out.setVersion(QDataStream::Qt_4_8);
+
+    out.writeRawData(MAGIC, sizeof(MAGIC));
+    out << FORMAT_VERSION << QString::fromLatin1(nc::version);
+
+    /* Platform. */
+    out << (image->platform().architecture() ? image->platform().architecture()->name() : QString())
+        << static_cast<qint32>(image->platform().operatingSystem())
+        << static_cast<qint32>(image->platform().intSize())
+        << static_cast<bool>(image->entrypoint())
+        << static_cast<qint64>(image->entrypoint() ? *image->entrypoint() : 0);
+
+    /* Sections. */
+    boost::unordered_map<const image::Section *, qint32> section2index;
+
+    out << static_cast<quint32>(image->sections().size());
+    foreach (const image::Section *section, image->sections()) {
+        section2index[section] = static_cast<qint32>(section2index.size());
+
+        out << section->name() << static_cast<qint64>(section->addr()) << static_cast<qint64>(section->size())
+            << section->isAllocated() << section->isReadable() << section->isWritable() << section->isExecutable()
+            << section->isCode() << section->isData() << section->isBss();
+
+        QByteArray content;
+        if (!section->isBss()) {
+            content.resize(section->size());
+            content.resize(section->readBytes(section->addr(), content.data(), section->size()));
+        }
+        out << content;
+    }
+
+    /* Symbols. */
+    boost::unordered_map<const image::Symbol *, qint32> symbol2index;
+
+    out << static_cast<quint32>(image->symbols().size());
+    foreach (const image::Symbol *symbol, image->symbols()) {
+        symbol2index[symbol] = static_cast<qint32>(symbol2index.size());
+        saveSymbol(out, symbol, section2index);
+    }
+
+    /* Relocations. A symbol not registered in the image is saved in place. */
+    out << static_cast<quint32>(image->relocations().size());
+    foreach (const image::Relocation *relocation, image->relocations()) {
+        out << static_cast<qint64>(relocation->address()) << static_cast<qint64>(relocation->size())
+            << static_cast<qint64>(relocation->addend());
+
+        auto i = symbol2index.find(relocation->symbol());
+        if (i != symbol2index.end()) {
+            out << i->second;
+        } else {
+            out << qint32(-1);
+            saveSymbol(out, relocation->symbol(), section2index);
+        }
+    }
+
+    /* Instructions. Their decoding is cheap and is redone on loading. */
+    out << static_cast<quint64>(context.instructions()->size());
+    foreach (const auto &instruction, context.instructions()->all()) {
+        out << static_cast<qint64>(instruction->addr()) << static_cast<qint32>(instruction->size());
+    }
+
+    /* Generated program. */
+    if (const likec::Tree *tree = context.tree()) {
+        out << true << static_cast<qint32>(tree->pointerSize()) << static_cast<qint32>(tree->intSize())
+            << static_cast<quint32>(tree->root()->declarations().size());
+
+        foreach (const likec::Declaration *declaration, tree->root()->declarations()) {
+            QString text;
+            QTextStream stream(&text);
+            declaration->print(stream);
+            stream.flush();
+
+            out << declaration->identifier() << text;
+        }
+    } else {
+        out << false;
+    }
+
+    /* Results of the analyses of functions. */
+    if (const ir::FunctionCache *functionCache = context.functionCache()) {
+        out << true;
+        functionCache->saveResults(out);
+    } else {
+        out << false;
+    }
+
+    if (out.status() != QDataStream::Ok) {
+        throw nc::Exception(tr("Could not write the session file."));
+    }
+
+    measurement.addCounter("bytes", device->pos());
+}
+
+void Session::load(Context &context, QIODevice *device) {
+    assert(device != nullptr);
+
+    PassMeasurement measurement(context.statistics(), "loadSession");
+    measurement.addCounter("bytes", device->size());
+
+    image::Image *image = context.image().get();
+
+    if (!image->sections().empty()) {
+        throw nc::Exception(tr("A session can be loaded only into an empty context."));
+    }
+
+    /* Section contents are not copied if the snapshot can be mapped. */
+    auto mappedFile = image::MappedFile::map(device);
+
+    QDataStream in(device);
+    in.setVersion(QDataStream::Qt_4_8);
+
+    char magic[sizeof(MAGIC)];
+    if (in.readRawData(magic, sizeof(magic)) != sizeof(magic) || memcmp(magic, MAGIC, sizeof(MAGIC)) != 0) {
+        throw nc::Exception(tr("The file is not a session file."));
+    }
+
+    quint32 formatVersion;
+    QString version;
+    in >> formatVersion >> version;
+    checkStatus(in);
+
+    if (formatVersion != FORMAT_VERSION) {
+        throw nc::Exception(tr("The session file was saved by an incompatible version %1.").arg(version));
+    }
+
+    /* Platform. */
+    QString architectureName;
+    qint32 operatingSystem, intSize;
+    bool hasEntrypoint;
+    qint64 entrypoint;
+
+    in >> architectureName >> operatingSystem >> intSize >> hasEntrypoint >> entrypoint;
+    checkStatus(in);
+
+    if (!architectureName.isEmpty()) {
+        if (!arch::ArchitectureRepository::instance()->getArchitecture(architectureName)) {
+            throw nc::Exception(tr("Unknown architecture %1.").arg(architectureName));
+        }
+        image->platform().setArchitecture(architectureName);
+    }
+    image->platform().setOperatingSystem(static_cast<image::Platform::OperatingSystem>(operatingSystem));
+    image->platform().setIntSize(intSize);
+    if (hasEntrypoint) {
+        image->setEntryPoint(entrypoint);
+    }
+
+    /* Sections. */
+    quint32 sectionCount;
+    in >> sectionCount;
+    checkStatus(in);
+
+    for (quint32 i = 0; i < sectionCount; ++i) {
+        QString name;
+        qint64 addr, size;
+        bool isAllocated, isReadable, isWritable, isExecutable, isCode, isData, isBss;
+
+        in >> name >> addr >> size >> isAllocated >> isReadable >> isWritable >> isExecutable
+           >> isCode >> isData >> isBss;
+        checkStatus(in);
+
+        auto section = std::make_unique<image::Section>(name, addr, size);
+        section->setAllocated(isAllocated);
+        section->setReadable(isReadable);
+        section->setWritable(isWritable);
+        section->setExecutable(isExecutable);
+        section->setCode(isCode);
+        section->setData(isData);
+        section->setBss(isBss);
+        loadContent(in, mappedFile, section.get());
+
+        image->addSection(std::move(section));
+    }
+
+    /* Symbols. */
+    quint32 symbolCount;
+    in >> symbolCount;
+    checkStatus(in);
+
+    std::vector<const image::Symbol *> symbols;
+    for (quint32 i = 0; i < symbolCount; ++i) {
+        symbols.push_back(image->addSymbol(loadSymbol(in, image)));
+    }
+
+    /* Relocations. */
+    quint32 relocationCount;
+    in >> relocationCount;
+    checkStatus(in);
+
+    for (quint32 i = 0; i < relocationCount; ++i) {
+        qint64 address, size, addend;
+        qint32 symbolIndex;
+
+        in >> address >> size >> addend >> symbolIndex;
+        checkStatus(in);
+
+        const image::Symbol *symbol;
+        if (symbolIndex == -1) {
+            symbol = image->addSymbol(loadSymbol(in, image));
+        } else if (symbolIndex >= 0 && symbolIndex < static_cast<qint32>(symbols.size())) {
+            symbol = symbols[symbolIndex];
+        } else {
+            throw nc::Exception(tr("The session file is truncated or corrupt."));
+        }
+
+        image->addRelocation(std::make_unique<image::Relocation>(address, symbol, size, addend));
+    }
+
+    /* Instructions. */
+    quint64 instructionCount;
+    in >> instructionCount;
+    checkStatus(in);
+
+    if (instructionCount > 0 && !image->platform().architecture()) {
+        throw nc::Exception(tr("The session file is truncated or corrupt."));
+    }
+
+    std::vector<std::pair<ByteAddr, SmallByteSize>> locations;
+    for (quint64 i = 0; i < instructionCount; ++i) {
+        qint64 addr;
+        qint32 size;
+
+        in >> addr >> size;
+        checkStatus(in);
+
+        locations.push_back(std::make_pair(addr, size));
+    }
+
+    std::vector<std::shared_ptr<arch::Instruction>> decoded(locations.size());
+
+    parallelFor((locations.size() + INSTRUCTIONS_PER_TASK - 1) / INSTRUCTIONS_PER_TASK, context.threadCount(),
+        [&](std::size_t task) {
+            auto disassembler = image->platform().architecture()->createDisassembler();
+            auto end = std::min(locations.size(), (task + 1) * INSTRUCTIONS_PER_TASK);
+
+            for (std::size_t i = task * INSTRUCTIONS_PER_TASK; i < end; ++i) {
+                decoded[i] = disassembler->disassembleSingleInstruction(locations[i].first, image);
+            }
+        });
+
+    auto instructions = std::make_shared<arch::Instructions>();
+    for (std::size_t i = 0; i < locations.size(); ++i) {
+        if (!decoded[i] || decoded[i]->size() != locations[i].second) {
+            throw nc::Exception(tr("Instruction at address %1 cannot be restored.").arg(locations[i].first, 0, 16));
+        }
+        instructions->add(std::move(decoded[i]));
+    }
+    context.setInstructions(instructions);
+
+    measurement.addCounter("instructions", instructions->size());
+
+    /* Generated program. */
+    bool hasTree;
+    in >> hasTree;
+    checkStatus(in);
+
+    if (hasTree) {
+        qint32 pointerSize, treeIntSize;
+        quint32 declarationCount;
+
+        in >> pointerSize >> treeIntSize >> declarationCount;
+        checkStatus(in);
+
+        auto tree = std::make_unique<likec::Tree>();
+        tree->setPointerSize(pointerSize);
+        tree->setIntSize(treeIntSize);
+        tree->setRoot(std::make_unique<likec::CompilationUnit>());
+
+        for (quint32 i = 0; i < declarationCount; ++i) {
+            QString identifier, text;
+            in >> identifier >> text;
+            checkStatus(in);
+
+            tree->root()->addDeclaration(std::make_unique<likec::VerbatimDeclaration>(std::move(identifier), std::move(text)));
+        }
+
+        context.setTree(std::move(tree));
+    }
+
+    /* Results of the analyses of functions. */
+    bool hasResults;
+    in >> hasResults;
+    checkStatus(in);
+
+    if (hasResults) {
+        auto functionCache = context.sharedFunctionCache();
+        if (!functionCache) {
+            functionCache = std::make_shared<ir::FunctionCache>(context.cache());
+        }
+
+        if (!functionCache->loadResults(in)) {
+            throw nc::Exception(tr("The session file is truncated or corrupt."));
+        }
+
+        context.setFunctionCache(functionCache);
+    }
+}
+
+} // namespace core
+} // namespace nc
+
+/* vim:set et sts=4 sw=4: */
@@ -0,0 +1,70 @@
+/* The file is part of Snowman decompiler. */
+/* See doc/licenses.asciidoc for the licensing information. */
+
+#pragma once
+
+#include <nc/config.h>
+
+#include <QCoreApplication> /* For Q_DECLARE_TR_FUNCTIONS. */
+
+QT_BEGIN_NAMESPACE
+class QIODevice;
+QT_END_NAMESPACE
+
+namespace nc {
+namespace core {
+
+class Context;
+
+/**
+ * Binary snapshot of a decompilation session.
+ *
+ * A snapshot contains the executable image (platform, sections with their
+ * contents, symbols, relocations), the addresses of the disassembled
+ * instructions, the source text of the generated program, and the results
+ * kept by the context's ir::FunctionCache: signatures, reductions of the
+ * structural analysis, and definitions of functions. It does not depend on
+ * the input file, which is not needed to restore the session.
+ *
+ * The results of functions are identified by the keys of the functions'
+ * code, and refer to basic blocks and terms by their offsets and positions
+ * in the code, not by pointers or by term indices, which are assigned
+ * during the dataflow analysis. When the restored instructions are
+ * decompiled again, the functions are recreated, and their results are
+ * reused instead of being recomputed. The other intermediate results
+ * (dataflow, liveness, variables, types) are not saved and are recomputed.
+ */
+class Session {
+    Q_DECLARE_TR_FUNCTIONS(Session)
+
+public:
+    /**
+     * Writes a snapshot of the given context.
+     *
+     * \param context Context.
+     * \param device Valid pointer to an open device to write to.
+     *
+     * \throws nc::Exception If writing fails.
+     */
+    static void save(const Context &context, QIODevice *device);
+
+    /**
+     * Restores a context from a snapshot.
+     *
+     * If the device is a file that can be memory-mapped, the sections of
+     * the restored image read their contents directly from the mapping.
+     * Saved results of functions are loaded into the context's cache of
+     * per-function results, which is created if the context has none.
+     *
+     * \param context Context with an empty image.
+     * \param device Valid pointer to an open device to read from.
+     *
+     * \throws nc::Exception If the snapshot is malformed or has an unsupported version.
+     */
+    static void load(Context &context, QIODevice *device);
+};
+
+} // namespace core
+} // namespace nc
+
+/* vim:set et sts=4 sw=4: */
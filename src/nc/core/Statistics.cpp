@@ -0,0 +1,258 @@
+/* The file is part of Snowman decompiler. */
+/* See doc/licenses.asciidoc for the licensing information. */
+
+#include "Statistics.h"
+
+#include <algorithm>
+#include <cassert>
+
+#include <QFile>
+#include <QMutexLocker>
+#include <QTextStream>
+
+#if defined(Q_OS_UNIX)
+#include <sys/resource.h>
+#include <unistd.h>
+#endif
+
+#include <nc/common/Foreach.h>
+
+#include <nc/core/ir/BasicBlock.h>
+#include <nc/core/ir/Function.h>
+
+namespace nc {
+namespace core {
+
+std::size_t Statistics::beginPass(const QString &name) {
+    QMutexLocker locker(&mutex_);
+
+    passes_.push_back(PassRecord());
+    passes_.back().name = name;
+    return passes_.size() - 1;
+}
+
+void Statistics::endPass(std::size_t pass, qint64 nanoseconds, const boost::optional<qint64> &memoryGrowth, Counters counters) {
+    QMutexLocker locker(&mutex_);
+
+    assert(pass < passes_.size());
+    auto &record = passes_[pass];
+    record.nanoseconds = nanoseconds;
+    record.memoryGrowth = memoryGrowth;
+    record.counters = std::move(counters);
+}
+
+void Statistics::addFunction(std::size_t pass, FunctionRecord record) {
+    QMutexLocker locker(&mutex_);
+
+    assert(pass < passes_.size());
+    passes_[pass].functions.push_back(std::move(record));
+}
+
+std::vector<Statistics::PassRecord> Statistics::passes() const {
+    std::vector<PassRecord> result;
+    {
+        QMutexLocker locker(&mutex_);
+        result = passes_;
+    }
+
+    /* Functions are measured concurrently, so the order of recording is arbitrary. */
+    foreach (auto &pass, result) {
+        std::stable_sort(pass.functions.begin(), pass.functions.end(),
+            [](const FunctionRecord &a, const FunctionRecord &b) -> bool {
+                if (a.address && b.address) {
+                    return *a.address < *b.address;
+                }
+                return a.address && !b.address;
+            });
+    }
+
+    return result;
+}
+
+namespace {
+
+void printCounters(QTextStream &out, const Statistics::Counters &counters) {
+    out << "{";
+    bool first = true;
+    foreach (const auto &counter, counters) {
+        if (!first) {
+            out << ", ";
+        }
+        first = false;
+        out << Statistics::toJsonString(counter.first) << ": " << counter.second;
+    }
+    out << "}";
+}
+
+QString seconds(qint64 nanoseconds) {
+    return QString::number(nanoseconds / 1e9, 'f', 9);
+}
+
+} // anonymous namespace
+
+QString Statistics::toJsonString(const QString &string) {
+    QString result;
+    result.reserve(string.size() + 2);
+    result += QChar('"');
+    foreach (QChar c, string) {
+        switch (c.unicode()) {
+            case '"': result += QLatin1String("\\\""); break;
+            case '\\': result += QLatin1String("\\\\"); break;
+            case '\n': result += QLatin1String("\\n"); break;
+            case '\r': result += QLatin1String("\\r"); break;
+            case '\t': result += QLatin1String("\\t"); break;
+            default:
+                if (c.unicode() < 0x20) {
+                    result += QString(QLatin1String("\\u%1")).arg(c.unicode(), 4, 16, QChar('0'));
+                } else {
+                    result += c;
+                }
+                break;
+        }
+    }
+    result += QChar('"');
+    return result;
+}
+
+void Statistics::print(QTextStream &out) const {
+    auto passes = this->passes();
+
+    out << "{" << endl;
+    out << "  \"peakMemory\": " << peakMemoryUsage() << "," << endl;
+    out << "  \"passes\": [";
+
+    bool firstPass = true;
+    foreach (const auto &pass, passes) {
+        out << (firstPass ? "" : ",") << endl;
+        firstPass = false;
+
+        out << "    {" << endl;
+        out << "      \"name\": " << Statistics::toJsonString(pass.name) << "," << endl;
+        out << "      \"time\": " << seconds(pass.nanoseconds) << "," << endl;
+        out << "      \"memoryGrowth\": ";
+        if (pass.memoryGrowth) {
+            out << *pass.memoryGrowth;
+        } else {
+            out << "null";
+        }
+        out << "," << endl;
+        out << "      \"counters\": ";
+        printCounters(out, pass.counters);
+        out << "," << endl;
+        out << "      \"functions\": [";
+
+        bool firstFunction = true;
+        foreach (const auto &function, pass.functions) {
+            out << (firstFunction ? "" : ",") << endl;
+            firstFunction = false;
+
+            out << "        {\"address\": ";
+            if (function.address) {
+                out << *function.address;
+            } else {
+                out << "null";
+            }
+            out << ", \"time\": " << seconds(function.nanoseconds) << ", \"counters\": ";
+            printCounters(out, function.counters);
+            out << "}";
+        }
+
+        out << (firstFunction ? "" : "\n      ") << "]" << endl;
+        out << "    }";
+    }
+
+    out << (firstPass ? "" : "\n  ") << "]" << endl;
+    out << "}" << endl;
+}
+
+qint64 Statistics::peakMemoryUsage() {
+#if defined(Q_OS_UNIX)
+    struct rusage usage;
+    if (getrusage(RUSAGE_SELF, &usage) == 0) {
+#if defined(Q_OS_MAC)
+        return usage.ru_maxrss;
+#else
+        return static_cast<qint64>(usage.ru_maxrss) * 1024;
+#endif
+    }
+#endif
+    return -1;
+}
+
+boost::optional<qint64> Statistics::currentMemoryUsage() {
+#if defined(Q_OS_LINUX)
+    /* The second field is the number of resident pages. */
+    QFile file(QLatin1String("/proc/self/statm"));
+    if (file.open(QIODevice::ReadOnly)) {
+        auto fields = file.readLine().split(' ');
+        bool ok;
+        if (fields.size() >= 2) {
+            qint64 pages = fields[1].toLongLong(&ok);
+            if (ok) {
+                return pages * sysconf(_SC_PAGESIZE);
+            }
+        }
+    }
+#endif
+    return boost::none;
+}
+
+PassMeasurement::PassMeasurement(Statistics *statistics, const char *name):
+    statistics_(statistics), pass_(0)
+{
+    if (statistics_) {
+        pass_ = statistics_->beginPass(QString::fromLatin1(name));
+        memoryUsage_ = Statistics::currentMemoryUsage();
+        timer_.start();
+    }
+}
+
+PassMeasurement::~PassMeasurement() {
+    if (statistics_) {
+        auto nanoseconds = timer_.nsecsElapsed();
+
+        boost::optional<qint64> memoryGrowth;
+        if (memoryUsage_) {
+            if (auto memoryUsage = Statistics::currentMemoryUsage()) {
+                memoryGrowth = *memoryUsage - *memoryUsage_;
+            }
+        }
+
+        statistics_->endPass(pass_, nanoseconds, memoryGrowth, std::move(counters_));
+    }
+}
+
+FunctionMeasurement::FunctionMeasurement(const PassMeasurement &pass, const ir::Function *function):
+    statistics_(pass.statistics_), pass_(pass.pass_), function_(function)
+{
+    assert(function != nullptr);
+
+    if (statistics_) {
+        qint64 statementCount = 0;
+        foreach (auto basicBlock, function->basicBlocks()) {
+            statementCount += basicBlock->statements().size();
+        }
+        addCounter("basicBlocks", function->basicBlocks().size());
+        addCounter("statements", statementCount);
+
+        timer_.start();
+    }
+}
+
+FunctionMeasurement::~FunctionMeasurement() {
+    if (statistics_) {
+        Statistics::FunctionRecord record;
+        record.nanoseconds = timer_.nsecsElapsed();
+        if (function_->entry()) {
+            record.address = function_->entry()->address();
+        }
+        record.counters = std::move(counters_);
+
+        statistics_->addFunction(pass_, std::move(record));
+    }
+}
+
+} // namespace core
+} // namespace nc
+
+/* vim:set et sts=4 sw=4: */
@@ -0,0 +1,224 @@
+/* The file is part of Snowman decompiler. */
+/* See doc/licenses.asciidoc for the licensing information. */
+
+#pragma once
+
+#include <nc/config.h>
+
+#include <utility>
+#include <vector>
+
+#include <boost/optional.hpp>
+
+#include <QElapsedTimer>
+#include <QMutex>
+#include <QString>
+
+#include <nc/common/Types.h>
+
+QT_BEGIN_NAMESPACE
+class QTextStream;
+QT_END_NAMESPACE
+
+namespace nc {
+namespace core {
+
+namespace ir {
+    class Function;
+}
+
+/**
+ * Profiling information about the passes of the decompiler:
+ * wall time, change of the memory usage, and various counters,
+ * both for the whole passes and for individual functions.
+ *
+ * Collecting the information is enabled by giving a Statistics object
+ * to the Context. Measurements can be recorded concurrently.
+ */
+class Statistics {
+public:
+    /** Named counters, in the order of recording. */
+    typedef std::vector<std::pair<QString, qint64>> Counters;
+
+    /**
+     * Measurements of a pass on a single function.
+     */
+    struct FunctionRecord {
+        boost::optional<ByteAddr> address; ///< Entry address of the function, if known.
+        qint64 nanoseconds; ///< Wall time.
+        Counters counters; ///< Counters.
+
+        FunctionRecord(): nanoseconds(0) {}
+    };
+
+    /**
+     * Measurements of a pass.
+     */
+    struct PassRecord {
+        QString name; ///< Name of the pass.
+        qint64 nanoseconds; ///< Wall time.
+        boost::optional<qint64> memoryGrowth; ///< Change of the memory usage in bytes during the pass, if known.
+        Counters counters; ///< Counters.
+        std::vector<FunctionRecord> functions; ///< Measurements for individual functions.
+
+        PassRecord(): nanoseconds(0) {}
+    };
+
+private:
+    /** Mutex protecting the records. */
+    mutable QMutex mutex_;
+
+    /** Records of all passes, in the order of their start. */
+    std::vector<PassRecord> passes_;
+
+public:
+    /**
+     * Starts recording a pass.
+     *
+     * \param name Name of the pass.
+     *
+     * \return Index of the pass record.
+     */
+    std::size_t beginPass(const QString &name);
+
+    /**
+     * Finishes recording a pass.
+     *
+     * \param pass Index of the pass record.
+     * \param nanoseconds Wall time of the pass.
+     * \param memoryGrowth Change of the memory usage in bytes during the pass, if known.
+     * \param counters Counters of the pass.
+     */
+    void endPass(std::size_t pass, qint64 nanoseconds, const boost::optional<qint64> &memoryGrowth, Counters counters);
+
+    /**
+     * Records measurements of a pass on a function.
+     *
+     * \param pass Index of the pass record.
+     * \param record Measurements.
+     */
+    void addFunction(std::size_t pass, FunctionRecord record);
+
+    /**
+     * \return Copy of all pass records. Function records of each pass
+     *         are sorted by address, the ones without address going last.
+     */
+    std::vector<PassRecord> passes() const;
+
+    /**
+     * Prints the records in JSON format.
+     *
+     * \param out Output stream.
+     */
+    void print(QTextStream &out) const;
+
+    /**
+     * \param string String.
+     *
+     * \return The string as a quoted and escaped JSON string literal.
+     */
+    static QString toJsonString(const QString &string);
+
+    /**
+     * \return Peak memory usage of the process since its start in bytes, or -1 if unknown.
+     */
+    static qint64 peakMemoryUsage();
+
+    /**
+     * \return Current memory usage (resident set size) of the process in bytes, if known.
+     */
+    static boost::optional<qint64> currentMemoryUsage();
+};
+
+/**
+ * Measures a pass from construction till destruction.
+ * Does nothing if no statistics object is given.
+ */
+class PassMeasurement {
+    Statistics *statistics_;
+    std::size_t pass_;
+    QElapsedTimer timer_;
+    boost::optional<qint64> memoryUsage_;
+    Statistics::Counters counters_;
+
+    friend class FunctionMeasurement;
+
+public:
+    /**
+     * Constructor.
+     *
+     * \param statistics Pointer to the statistics. Can be nullptr.
+     * \param name Name of the pass.
+     */
+    PassMeasurement(Statistics *statistics, const char *name);
+
+    /**
+     * Destructor. Records the measurements.
+     */
+    ~PassMeasurement();
+
+    /**
+     * \return True if the measurements are recorded.
+     */
+    bool enabled() const { return statistics_ != nullptr; }
+
+    /**
+     * Adds a counter to the pass record.
+     *
+     * \param name Name of the counter.
+     * \param value Value of the counter.
+     */
+    void addCounter(const char *name, qint64 value) {
+        if (enabled()) {
+            counters_.push_back(std::make_pair(QString::fromLatin1(name), value));
+        }
+    }
+};
+
+/**
+ * Measures a pass on a single function from construction till destruction.
+ * Does nothing if the pass is not measured.
+ */
+class FunctionMeasurement {
+    Statistics *statistics_;
+    std::size_t pass_;
+    const ir::Function *function_;
+    QElapsedTimer timer_;
+    Statistics::Counters counters_;
+
+public:
+    /**
+     * Constructor.
+     *
+     * \param pass Measurement of the pass the function is analyzed by.
+     * \param function Valid pointer to the function.
+     */
+    FunctionMeasurement(const PassMeasurement &pass, const ir::Function *function);
+
+    /**
+     * Destructor. Records the measurements.
+     */
+    ~FunctionMeasurement();
+
+    /**
+     * \return True if the measurements are recorded.
+     */
+    bool enabled() const { return statistics_ != nullptr; }
+
+    /**
+     * Adds a counter to the function record.
+     *
+     * \param name Name of the counter.
+     * \param value Value of the counter.
+     */
+    void addCounter(const char *name, qint64 value) {
+        if (enabled()) {
+            counters_.push_back(std::make_pair(QString::fromLatin1(name), value));
+        }
+    }
+};
+
+} // namespace core
+} // namespace nc
+
+/* vim:set et sts=4 sw=4: */
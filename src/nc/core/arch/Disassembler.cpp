@@ -19,6 +19,10 @@ namespace core {
 namespace arch {
 
 void Disassembler::disassemble(const image::Image *image, const image::ByteSource *source, ByteAddr begin, ByteAddr end, InstructionCallback callback, const CancellationToken &canceled) {
+    disassembleUntil(image, source, begin, end, std::move(callback), [](ByteAddr) { return false; }, canceled);
+}
+
+ByteAddr Disassembler::disassembleUntil(const image::Image *image, const image::ByteSource *source, ByteAddr begin, ByteAddr end, InstructionCallback callback, const std::function<bool(ByteAddr)> &stop, const CancellationToken &canceled) {
     assert(source != nullptr);
     assert(begin <= end);
 
@@ -29,17 +33,29 @@ void Disassembler::disassemble(const image::Image *image, const image::ByteSourc
     auto bufferBegin = begin;
     auto bufferEnd = begin;
 
-    for (ByteAddr pc = begin; pc < end; canceled.poll()) {
+    ByteAddr pc = begin;
+
+    /* First relocation at or after pc. */
+    const image::Relocation *nextRelocation = image->getNextRelocation(pc);
+
+    for (; pc < end; canceled.poll()) {
+        if (stop(pc)) {
+            return pc;
+        }
+
         if (pc + maxInstructionSize > bufferEnd && bufferEnd < end) {
             bufferBegin = pc;
             bufferEnd = bufferBegin + source->readBytes(pc, buffer.get(), std::min(bufferSize, end - pc));
         }
 
-        const image::Relocation* reloc = image->getRelocation(pc);
+        if (nextRelocation && nextRelocation->address() < pc) {
+            nextRelocation = image->getNextRelocation(pc);
+        }
+
         // If a relocation starts at a particular address it does make sense for there to be an instruction
         // there as well so skip over it
-        if (reloc) {
-            pc += reloc->size();
+        if (nextRelocation && nextRelocation->address() == pc) {
+            pc += nextRelocation->size();
             continue;
         }
 
@@ -53,6 +69,8 @@ void Disassembler::disassemble(const image::Image *image, const image::ByteSourc
             ++pc;
         }
     }
+
+    return pc;
 }
 
 std::shared_ptr<Instruction> Disassembler::disassembleSingleInstruction(ByteAddr pc, const image::ByteSource *source) {
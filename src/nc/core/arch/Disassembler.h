@@ -63,6 +63,23 @@ public:
      */
     virtual void disassemble(const image::Image *image, const image::ByteSource *source, ByteAddr begin, ByteAddr end, InstructionCallback callback, const CancellationToken &canceled);
 
+    /**
+     * Disassembles instructions in the given range of addresses the same way
+     * disassemble() does, but stops as soon as the sweep reaches an address
+     * for which the given predicate returns true.
+     *
+     * \param source Valid pointer to a byte source.
+     * \param begin First address in the range.
+     * \param end First address past the range.
+     * \param callback Function being called for each disassembled instruction.
+     * \param stop Predicate checked for every address the sweep reaches, including begin.
+     * \param canceled Cancellation token.
+     *
+     * \return The address where the sweep stopped: either the first address
+     *         satisfying the predicate, or an address not less than end.
+     */
+    ByteAddr disassembleUntil(const image::Image *image, const image::ByteSource *source, ByteAddr begin, ByteAddr end, InstructionCallback callback, const std::function<bool(ByteAddr)> &stop, const CancellationToken &canceled);
+
     /**
      * Disassembles a single instruction.
      *
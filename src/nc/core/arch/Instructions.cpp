@@ -24,6 +24,8 @@
 
 #include "Instructions.h"
 
+#include <algorithm>
+
 #include <QTextStream>
 
 #include <nc/common/Foreach.h>
@@ -32,37 +34,139 @@ namespace nc {
 namespace core {
 namespace arch {
 
-const std::shared_ptr<const Instruction> &Instructions::getCovering(ByteAddr addr) const {
-    auto i = address2instruction_.lower_bound(addr);
+namespace {
+
+/** Maximal size of a chunk. */
+const std::size_t MAX_CHUNK_SIZE = 1024;
+
+/**
+ * \return A null pointer to an instruction.
+ */
+const std::shared_ptr<const Instruction> &null() {
+    static const std::shared_ptr<const Instruction> result;
+    return result;
+}
+
+/**
+ * Compares the address of an instruction with the given address.
+ */
+bool startsBefore(const std::shared_ptr<const Instruction> &instruction, ByteAddr addr) {
+    return instruction->addr() < addr;
+}
+
+} // anonymous namespace
+
+std::size_t Instructions::findChunk(ByteAddr addr) const {
+    auto i = std::upper_bound(chunkAddresses_.begin(), chunkAddresses_.end(), addr);
+    return i == chunkAddresses_.begin() ? 0 : i - chunkAddresses_.begin() - 1;
+}
 
-    if (i != address2instruction_.end() &&
-        i->second->addr() <= addr && addr < i->second->endAddr())
-    {
-        return i->second;
+Instructions::Chunk &Instructions::getMutableChunk(std::size_t chunkIndex) {
+    auto &chunk = chunks_[chunkIndex];
+    if (chunk.use_count() > 1) {
+        chunk = std::make_shared<Chunk>(*chunk);
+    }
+    return *chunk;
+}
+
+const std::shared_ptr<const Instruction> &Instructions::get(ByteAddr addr) const {
+    if (chunks_.empty()) {
+        return null();
+    }
+
+    const auto &chunk = *chunks_[findChunk(addr)];
+    auto i = std::lower_bound(chunk.begin(), chunk.end(), addr, startsBefore);
+
+    if (i != chunk.end() && (*i)->addr() == addr) {
+        return *i;
     } else {
-        static const std::shared_ptr<const Instruction> null;
-        return null;
+        return null();
     }
 }
 
+const std::shared_ptr<const Instruction> &Instructions::getCovering(ByteAddr addr) const {
+    if (chunks_.empty()) {
+        return null();
+    }
+
+    const auto &chunk = *chunks_[findChunk(addr)];
+    auto i = std::lower_bound(chunk.begin(), chunk.end(), addr + 1, startsBefore);
+
+    if (i != chunk.begin()) {
+        --i;
+        if ((*i)->addr() <= addr && addr < (*i)->endAddr()) {
+            return *i;
+        }
+    }
+    return null();
+}
+
 bool Instructions::add(std::shared_ptr<const Instruction> instruction) {
     assert(instruction != nullptr);
 
-    auto &existing = address2instruction_[instruction->addr()];
-    if (!existing) {
-        existing = instruction;
+    auto addr = instruction->addr();
+
+    /*
+     * Instructions are usually added in the order of addresses.
+     */
+    if (chunks_.empty() || (addr > chunks_.back()->back()->addr() && chunks_.back()->size() >= MAX_CHUNK_SIZE)) {
+        auto chunk = std::make_shared<Chunk>();
+        chunk->reserve(MAX_CHUNK_SIZE);
+        chunk->push_back(std::move(instruction));
+        chunks_.push_back(std::move(chunk));
+        chunkAddresses_.push_back(addr);
+        ++size_;
         return true;
-    } else {
+    }
+
+    auto chunkIndex = findChunk(addr);
+    const auto &sharedChunk = *chunks_[chunkIndex];
+    auto position = std::lower_bound(sharedChunk.begin(), sharedChunk.end(), addr, startsBefore);
+
+    if (position != sharedChunk.end() && (*position)->addr() == addr) {
         return false;
     }
+
+    auto offset = position - sharedChunk.begin();
+    auto &chunk = getMutableChunk(chunkIndex);
+    chunk.insert(chunk.begin() + offset, std::move(instruction));
+    chunkAddresses_[chunkIndex] = chunk.front()->addr();
+    ++size_;
+
+    /*
+     * Split chunks that became too large.
+     */
+    if (chunk.size() >= 2 * MAX_CHUNK_SIZE) {
+        auto tail = std::make_shared<Chunk>(chunk.begin() + MAX_CHUNK_SIZE, chunk.end());
+        chunk.erase(chunk.begin() + MAX_CHUNK_SIZE, chunk.end());
+
+        chunkAddresses_.insert(chunkAddresses_.begin() + chunkIndex + 1, tail->front()->addr());
+        chunks_.insert(chunks_.begin() + chunkIndex + 1, std::move(tail));
+    }
+
+    return true;
 }
 
 bool Instructions::remove(const Instruction *instruction) {
-    if (get(instruction->addr()).get() == instruction) {
-        return address2instruction_.erase(instruction->addr());
-    } else {
+    assert(instruction != nullptr);
+
+    if (get(instruction->addr()).get() != instruction) {
         return false;
     }
+
+    auto chunkIndex = findChunk(instruction->addr());
+    auto &chunk = getMutableChunk(chunkIndex);
+    chunk.erase(std::lower_bound(chunk.begin(), chunk.end(), instruction->addr(), startsBefore));
+    --size_;
+
+    if (chunk.empty()) {
+        chunks_.erase(chunks_.begin() + chunkIndex);
+        chunkAddresses_.erase(chunkAddresses_.begin() + chunkIndex);
+    } else {
+        chunkAddresses_[chunkIndex] = chunk.front()->addr();
+    }
+
+    return true;
 }
 
 void Instructions::print(QTextStream &out, PrintCallback<const Instruction *> *callback) const {
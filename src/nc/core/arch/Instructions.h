@@ -25,13 +25,13 @@
 
 #include <nc/config.h>
 
-#include <map>
 #include <memory> /* std::shared_ptr */
+#include <vector>
 
-#include <boost/range/adaptor/map.hpp>
+#include <boost/iterator/iterator_facade.hpp>
+#include <boost/range/iterator_range.hpp>
 
 #include <nc/common/PrintCallback.h>
-#include <nc/common/Range.h> /* nc::find */
 
 #include "Instruction.h"
 
@@ -41,22 +41,79 @@ class Instruction;
 
 /**
  * Class representing a set of instructions.
+ *
+ * Instructions are kept in sorted arrays of limited size (chunks).
+ * Copies of a set share the chunks, and a chunk is copied only when
+ * a set modifies it. Therefore, copying a set is cheap, and so is
+ * adding a few instructions to a copy of a large set.
+ *
+ * Each instruction is still a separate object. Storing them column-wise
+ * is left for later, see "Compact Instruction Storage" in doc/todo.asciidoc.
  */
 class Instructions {
-    /** Type of mapping of addresses to instruction. */
-    typedef std::map<ByteAddr, std::shared_ptr<const Instruction>> AddressInstructionMap;
+    /** Sorted array of instructions. */
+    typedef std::vector<std::shared_ptr<const Instruction>> Chunk;
+
+    /** Chunks in the order of addresses. None of them is empty. */
+    std::vector<std::shared_ptr<Chunk>> chunks_;
 
-    /** Mapping of addresses to instructions. */
-    AddressInstructionMap address2instruction_;
+    /** Address of the first instruction in each chunk. */
+    std::vector<ByteAddr> chunkAddresses_;
+
+    /** Number of instructions in the set. */
+    std::size_t size_;
 
 public:
+    /**
+     * Iterator over the instructions, in the order of their addresses.
+     */
+    class ConstIterator: public boost::iterator_facade<
+        ConstIterator, const std::shared_ptr<const Instruction>, boost::forward_traversal_tag>
+    {
+        friend class boost::iterator_core_access;
+
+        const std::vector<std::shared_ptr<Chunk>> *chunks_;
+        std::size_t chunkIndex_;
+        std::size_t index_;
+
+    public:
+        ConstIterator(): chunks_(nullptr), chunkIndex_(0), index_(0) {}
+
+        ConstIterator(const std::vector<std::shared_ptr<Chunk>> *chunks, std::size_t chunkIndex):
+            chunks_(chunks), chunkIndex_(chunkIndex), index_(0)
+        {}
+
+    private:
+        void increment() {
+            if (++index_ == (*chunks_)[chunkIndex_]->size()) {
+                ++chunkIndex_;
+                index_ = 0;
+            }
+        }
+
+        bool equal(const ConstIterator &that) const {
+            return chunkIndex_ == that.chunkIndex_ && index_ == that.index_;
+        }
+
+        const std::shared_ptr<const Instruction> &dereference() const {
+            return (*(*chunks_)[chunkIndex_])[index_];
+        }
+    };
+
     /** Type for the sorted range of instructions. */
-    typedef boost::select_second_const_range<AddressInstructionMap> InstructionsRange;
+    typedef boost::iterator_range<ConstIterator> InstructionsRange;
+
+    /**
+     * Constructs an empty set of instructions.
+     */
+    Instructions(): size_(0) {}
 
     /**
      * \return Range of instructions sorted by their addresses in ascending order.
      */
-    InstructionsRange all() const { return address2instruction_ | boost::adaptors::map_values; }
+    InstructionsRange all() const {
+        return InstructionsRange(ConstIterator(&chunks_, 0), ConstIterator(&chunks_, chunks_.size()));
+    }
 
     /**
      * \param[in] addr Address.
@@ -64,7 +121,7 @@ public:
      * \return Pointer to the instruction starting at the given address.
      *         Can be nullptr, if there is no such instructions.
      */
-    const std::shared_ptr<const Instruction> &get(ByteAddr addr) const { return nc::find(address2instruction_, addr); }
+    const std::shared_ptr<const Instruction> &get(ByteAddr addr) const;
 
     /**
      * \param[in] addr Address.
@@ -95,7 +152,7 @@ public:
     /**
      * \return Number of instructions in the set.
      */
-    std::size_t size() const { return address2instruction_.size(); }
+    std::size_t size() const { return size_; }
 
     /**
      * \return True if the set is empty, false is otherwise.
@@ -109,6 +166,23 @@ public:
      * \param callback Pointer to the print callback. Can be nullptr.
      */
     void print(QTextStream &out, PrintCallback<const Instruction *> *callback = nullptr) const;
+
+private:
+    /**
+     * \param[in] addr Address.
+     *
+     * \return Index of the last chunk starting not after the given address,
+     *         or 0 if there is no such chunk.
+     */
+    std::size_t findChunk(ByteAddr addr) const;
+
+    /**
+     * \param[in] chunkIndex Index of a chunk.
+     *
+     * \return Reference to the chunk that is not shared with other sets
+     *         and can be modified. The chunk is copied if necessary.
+     */
+    Chunk &getMutableChunk(std::size_t chunkIndex);
 };
 
 }}} // namespace nc::core::arch
@@ -0,0 +1,142 @@
+/* The file is part of Snowman decompiler. */
+/* See doc/licenses.asciidoc for the licensing information. */
+
+#include "AddressSpace.h"
+
+#include <algorithm>
+#include <iterator>
+#include <map>
+
+#include <QAtomicInt>
+
+#include <nc/common/Foreach.h>
+
+#include "Section.h"
+
+namespace nc {
+namespace core {
+namespace image {
+
+namespace {
+
+/** Logarithm of the page size. */
+const int PAGE_BITS = 12;
+
+/** Maximal number of pages in the page table. */
+const std::size_t MAX_PAGES = 1 << 18;
+
+QAtomicInt nextId(1);
+
+/**
+ * Interval found by the last lookup in the current thread.
+ */
+struct LastHit {
+    int id; ///< Identifier of the index.
+    const AddressSpace::Interval *interval; ///< Found interval.
+};
+
+NC_THREAD_LOCAL LastHit lastHit = { 0, nullptr };
+
+} // anonymous namespace
+
+AddressSpace::AddressSpace(const std::vector<const Section *> &sections):
+    pagesComplete_(true), id_(nextId.fetchAndAddRelaxed(1))
+{
+    /* Intervals by their beginnings. Earlier sections occupy the addresses first. */
+    std::map<ByteAddr, Interval> intervals;
+
+    foreach (const Section *section, sections) {
+        if (!section->isAllocated() || section->size() <= 0) {
+            continue;
+        }
+
+        ByteAddr addr = section->addr();
+        ByteAddr end = section->endAddr();
+
+        auto i = intervals.upper_bound(addr);
+        if (i != intervals.begin()) {
+            auto previous = std::prev(i);
+            if (previous->second.end > addr) {
+                addr = previous->second.end;
+            }
+        }
+
+        while (addr < end) {
+            ByteAddr gapEnd = (i == intervals.end()) ? end : std::min(end, i->first);
+            if (addr < gapEnd) {
+                Interval interval = { addr, gapEnd, section };
+                intervals.insert(i, std::make_pair(addr, interval));
+            }
+            if (i == intervals.end()) {
+                break;
+            }
+            addr = i->second.end;
+            ++i;
+        }
+    }
+
+    intervals_.reserve(intervals.size());
+    foreach (const auto &item, intervals) {
+        intervals_.push_back(item.second);
+    }
+
+    std::size_t pageCount = 0;
+    foreach (const Interval &interval, intervals_) {
+        pageCount += ((interval.end - 1) >> PAGE_BITS) - (interval.begin >> PAGE_BITS) + 1;
+        if (pageCount > MAX_PAGES) {
+            pagesComplete_ = false;
+            break;
+        }
+    }
+
+    if (pagesComplete_) {
+        for (std::size_t index = 0; index < intervals_.size(); ++index) {
+            const Interval &interval = intervals_[index];
+            for (ByteAddr page = interval.begin >> PAGE_BITS; page <= (interval.end - 1) >> PAGE_BITS; ++page) {
+                pages_.insert(std::make_pair(page, index));
+            }
+        }
+    }
+}
+
+const AddressSpace::Interval *AddressSpace::getInterval(ByteAddr addr) const {
+    if (lastHit.id == id_ && lastHit.interval->begin <= addr && addr < lastHit.interval->end) {
+        return lastHit.interval;
+    }
+
+    auto result = findInterval(addr);
+    if (result) {
+        lastHit.id = id_;
+        lastHit.interval = result;
+    }
+    return result;
+}
+
+const AddressSpace::Interval *AddressSpace::findInterval(ByteAddr addr) const {
+    if (pagesComplete_) {
+        auto i = pages_.find(addr >> PAGE_BITS);
+        if (i == pages_.end()) {
+            return nullptr;
+        }
+        for (std::size_t index = i->second; index < intervals_.size() && intervals_[index].begin <= addr; ++index) {
+            if (addr < intervals_[index].end) {
+                return &intervals_[index];
+            }
+        }
+        return nullptr;
+    }
+
+    auto i = std::upper_bound(intervals_.begin(), intervals_.end(), addr,
+        [](ByteAddr addr, const Interval &interval) { return addr < interval.begin; });
+    if (i == intervals_.begin()) {
+        return nullptr;
+    }
+    --i;
+    return addr < i->end ? &*i : nullptr;
+}
+
+} // namespace image
+} // namespace core
+} // namespace nc
+
+/* vim:set et sts=4 sw=4: */
@@ -0,0 +1,95 @@
+/* The file is part of Snowman decompiler. */
+/* See doc/licenses.asciidoc for the licensing information. */
+
+#pragma once
+
+#include <nc/config.h>
+
+#include <vector>
+
+#include <boost/unordered_map.hpp>
+
+#include <nc/common/Types.h>
+
+namespace nc {
+namespace core {
+namespace image {
+
+class Section;
+
+/**
+ * Immutable index mapping addresses to the allocated sections containing them.
+ *
+ * The address space is split into disjoint intervals, each belonging to
+ * a single section. Where sections overlap, the section added earlier wins,
+ * as in a linear scan over the sections. Lookups go through a page-granular
+ * table (when the address space is not too large), falling back to a binary
+ * search over the sorted intervals. Each thread additionally remembers
+ * the interval it found last.
+ *
+ * Lookups can be executed concurrently.
+ */
+class AddressSpace {
+public:
+    /**
+     * A range of addresses belonging to one section.
+     */
+    struct Interval {
+        ByteAddr begin; ///< First address of the interval.
+        ByteAddr end; ///< First address past the interval.
+        const Section *section; ///< Valid pointer to the section.
+    };
+
+private:
+    /** Disjoint intervals sorted by address. */
+    std::vector<Interval> intervals_;
+
+    /** Mapping from a page number to the index of the first interval intersecting the page. */
+    boost::unordered_map<ByteAddr, std::size_t> pages_;
+
+    /** Whether the page table covers all the intervals. */
+    bool pagesComplete_;
+
+    /** Unique identifier of the index, used for validating the per-thread cache. */
+    int id_;
+
+public:
+    /**
+     * Builds the index.
+     *
+     * \param sections Sections in the order of their addition to the image.
+     *                 Sections that are not allocated are ignored.
+     */
+    explicit AddressSpace(const std::vector<const Section *> &sections);
+
+    /**
+     * \return Disjoint intervals sorted by address.
+     */
+    const std::vector<Interval> &intervals() const { return intervals_; }
+
+    /**
+     * \param addr Address.
+     *
+     * \return Pointer to the interval containing the address. Can be nullptr.
+     */
+    const Interval *getInterval(ByteAddr addr) const;
+
+    /**
+     * \param addr Address.
+     *
+     * \return Pointer to the section containing the address. Can be nullptr.
+     */
+    const Section *getSection(ByteAddr addr) const {
+        auto interval = getInterval(addr);
+        return interval ? interval->section : nullptr;
+    }
+
+private:
+    const Interval *findInterval(ByteAddr addr) const;
+};
+
+} // namespace image
+} // namespace core
+} // namespace nc
+
+/* vim:set et sts=4 sw=4: */
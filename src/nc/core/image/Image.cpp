@@ -24,6 +24,10 @@
 
 #include "Image.h"
 
+#include <algorithm>
+
+#include <QMutexLocker>
+
 #include <nc/common/Foreach.h>
 #include <nc/common/Range.h>
 #include <nc/common/make_unique.h>
@@ -31,6 +35,7 @@
 #include <nc/core/image/Image.h>
 #include <nc/core/mangling/DefaultDemangler.h>
 
+#include "AddressSpace.h"
 #include "Relocation.h"
 #include "Section.h"
 
@@ -45,15 +50,22 @@ Image::~Image() {}
 void Image::addSection(std::unique_ptr<Section> section) {
     assert(section != nullptr);
     sections_.push_back(std::move(section));
+    addressSpaceValid_.fetchAndStoreOrdered(0);
 }
 
 const Section *Image::getSectionContainingAddress(ByteAddr addr) const {
-    foreach (auto section, sections()) {
-        if (section->isAllocated() && section->containsAddress(addr)) {
-            return section;
+    return addressSpace().getSection(addr);
+}
+
+const AddressSpace &Image::addressSpace() const {
+    if (!addressSpaceValid_.fetchAndAddOrdered(0)) {
+        QMutexLocker locker(&indexMutex_);
+        if (!addressSpaceValid_.fetchAndAddOrdered(0)) {
+            addressSpace_ = std::make_unique<AddressSpace>(sections());
+            addressSpaceValid_.fetchAndStoreOrdered(1);
         }
     }
-    return nullptr;
+    return *addressSpace_;
 }
 
 const Section *Image::getSectionByName(const QString &name) const {
@@ -66,11 +78,24 @@ const Section *Image::getSectionByName(const QString &name) const {
 }
 
 ByteSize Image::readBytes(ByteAddr addr, void *buf, ByteSize size) const {
-    if (const Section *section = getSectionContainingAddress(addr)) {
-        return section->readBytes(addr, buf, size);
-    } else {
-        return 0;
+    const AddressSpace &addressSpace = this->addressSpace();
+
+    ByteSize result = 0;
+    while (result < size) {
+        auto interval = addressSpace.getInterval(addr + result);
+        if (!interval) {
+            break;
+        }
+
+        ByteSize chunkSize = std::min(size - result, interval->end - (addr + result));
+        ByteSize readSize = interval->section->readBytes(addr + result, static_cast<char *>(buf) + result, chunkSize);
+
+        result += readSize;
+        if (readSize < chunkSize) {
+            break;
+        }
     }
+    return result;
 }
 
 const Symbol *Image::addSymbol(std::unique_ptr<Symbol> symbol) {
@@ -94,6 +119,7 @@ const Relocation *Image::addRelocation(std::unique_ptr<Relocation> relocation) {
 
     relocations_.push_back(std::move(relocation));
     address2relocation_[result->address()] = result;
+    sortedRelocationsValid_.fetchAndStoreOrdered(0);
 
     return result;
 }
@@ -102,6 +128,25 @@ const Relocation *Image::getRelocation(ByteAddr address) const {
     return nc::find(address2relocation_, address);
 }
 
+const Relocation *Image::getNextRelocation(ByteAddr address) const {
+    if (!sortedRelocationsValid_.fetchAndAddOrdered(0)) {
+        QMutexLocker locker(&indexMutex_);
+        if (!sortedRelocationsValid_.fetchAndAddOrdered(0)) {
+            sortedRelocations_.clear();
+            foreach (const auto &item, address2relocation_) {
+                sortedRelocations_.push_back(item.second);
+            }
+            std::sort(sortedRelocations_.begin(), sortedRelocations_.end(),
+                [](const Relocation *a, const Relocation *b) { return a->address() < b->address(); });
+            sortedRelocationsValid_.fetchAndStoreOrdered(1);
+        }
+    }
+
+    auto i = std::lower_bound(sortedRelocations_.begin(), sortedRelocations_.end(), address,
+        [](const Relocation *relocation, ByteAddr address) { return relocation->address() < address; });
+    return i != sortedRelocations_.end() ? *i : nullptr;
+}
+
 void Image::setDemangler(std::unique_ptr<mangling::Demangler> demangler) {
     assert(demangler != nullptr);
 
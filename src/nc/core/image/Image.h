@@ -30,6 +30,8 @@
 
 #include <boost/unordered_map.hpp>
 
+#include <QAtomicInt>
+#include <QMutex>
 #include <QString>
 
 #include "ByteSource.h"
@@ -48,6 +50,7 @@ namespace mangling {
 
 namespace image {
 
+class AddressSpace;
 class Section;
 class Relocation;
 
@@ -64,6 +67,12 @@ class Image: public ByteSource {
     std::unique_ptr<mangling::Demangler> demangler_; ///< Demangler.
     boost::optional<ByteAddr> entrypoint_; ///< Entrypoint of image.
 
+    mutable QMutex indexMutex_; ///< Mutex protecting the construction of the indices below.
+    mutable QAtomicInt addressSpaceValid_; ///< Whether addressSpace_ is up to date.
+    mutable std::unique_ptr<AddressSpace> addressSpace_; ///< Index of the allocated sections.
+    mutable QAtomicInt sortedRelocationsValid_; ///< Whether sortedRelocations_ is up to date.
+    mutable std::vector<const Relocation *> sortedRelocations_; ///< Relocations sorted by address.
+
 public:
     /**
      * Constructor.
@@ -114,6 +123,13 @@ public:
      */
     const Section *getSectionContainingAddress(ByteAddr addr) const;
 
+    /**
+     * \return Index of the allocated sections of the image.
+     *          The index is rebuilt on the first use after adding a section.
+     *          Sections must not be modified after being added to the image.
+     */
+    const AddressSpace &addressSpace() const;
+
     /**
      * \param[in] name Section name.
      *
@@ -123,8 +139,10 @@ public:
     const Section *getSectionByName(const QString &name) const;
 
     /**
-     * Reads a sequence of bytes from the section containing
-     * the given address and allocated during program execution.
+     * Reads a sequence of bytes from the sections allocated during
+     * program execution. The read continues into the adjacent section
+     * when the end of a section is reached, and stops at the first
+     * address not belonging to any allocated section.
      */
     ByteSize readBytes(ByteAddr addr, void *buf, ByteSize size) const override;
 
@@ -169,6 +187,21 @@ public:
      */
     const Relocation *getRelocation(ByteAddr address) const;
 
+    /**
+     * \param address Virtual address.
+     *
+     * \return Pointer to the relocation with the smallest address
+     *         greater than or equal to the given one. Can be nullptr.
+     */
+    const Relocation *getNextRelocation(ByteAddr address) const;
+
+    /**
+     * \return List of all relocations.
+     */
+    const std::vector<const Relocation *> &relocations() const {
+        return reinterpret_cast<const std::vector<const Relocation *> &>(relocations_);
+    }
+
     /**
      * \return Valid pointer to a demangler.
      */
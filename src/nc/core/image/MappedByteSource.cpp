@@ -0,0 +1,47 @@
+/* The file is part of Snowman decompiler. */
+/* See doc/licenses.asciidoc for the licensing information. */
+
+#include "MappedByteSource.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cstring>
+
+#include "MappedFile.h"
+#include "Section.h"
+
+namespace nc {
+namespace core {
+namespace image {
+
+MappedByteSource::MappedByteSource(std::shared_ptr<const MappedFile> file, const Section *section, ByteSize offset, ByteSize size):
+    file_(std::move(file)), section_(section), offset_(offset), size_(size)
+{
+    assert(file_ != nullptr);
+    assert(section_ != nullptr);
+    assert(file_->contains(offset_, size_));
+}
+
+ByteSize MappedByteSource::readBytes(ByteAddr addr, void *buf, ByteSize size) const {
+    auto offset = addr - section_->addr();
+
+    if (offset < 0 || size <= 0) {
+        return 0;
+    }
+
+    auto copiedSize = std::max<ByteSize>(std::min(size, size_ - offset), 0);
+    if (copiedSize > 0) {
+        memcpy(buf, file_->data() + offset_ + offset, copiedSize);
+    }
+    if (copiedSize < size) {
+        memset(static_cast<char *>(buf) + copiedSize, 0, size - copiedSize);
+    }
+
+    return size;
+}
+
+} // namespace image
+} // namespace core
+} // namespace nc
+
+/* vim:set et sts=4 sw=4: */
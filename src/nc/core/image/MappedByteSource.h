@@ -0,0 +1,49 @@
+/* The file is part of Snowman decompiler. */
+/* See doc/licenses.asciidoc for the licensing information. */
+
+#pragma once
+
+#include <nc/config.h>
+
+#include <memory>
+
+#include "ByteSource.h"
+
+namespace nc {
+namespace core {
+namespace image {
+
+class MappedFile;
+class Section;
+
+/**
+ * Byte source reading the contents of a section directly from a memory-mapped file.
+ */
+class MappedByteSource: public ByteSource {
+    std::shared_ptr<const MappedFile> file_; ///< Mapped file.
+    const Section *section_; ///< Section whose contents are provided.
+    ByteSize offset_; ///< Offset of the section's contents in the file.
+    ByteSize size_; ///< Size of the section's contents in the file.
+
+public:
+    /**
+     * Constructor.
+     *
+     * \param file Valid pointer to the mapped file.
+     * \param section Valid pointer to the section. The section's address
+     *                is consulted on every read, so it can still change.
+     * \param offset Offset of the section's contents in the file.
+     * \param size Size of the section's contents in the file.
+     *             The range must lie within the file. Bytes of the section
+     *             beyond this size read as zeroes.
+     */
+    MappedByteSource(std::shared_ptr<const MappedFile> file, const Section *section, ByteSize offset, ByteSize size);
+
+    ByteSize readBytes(ByteAddr addr, void *buf, ByteSize size) const override;
+};
+
+} // namespace image
+} // namespace core
+} // namespace nc
+
+/* vim:set et sts=4 sw=4: */
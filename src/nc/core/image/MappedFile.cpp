@@ -0,0 +1,51 @@
+/* The file is part of Snowman decompiler. */
+/* See doc/licenses.asciidoc for the licensing information. */
+
+#include "MappedFile.h"
+
+#include <cassert>
+
+#include <QIODevice>
+
+namespace nc {
+namespace core {
+namespace image {
+
+MappedFile::MappedFile(const QString &fileName):
+    file_(fileName), data_(nullptr), size_(0)
+{
+    if (file_.open(QIODevice::ReadOnly)) {
+        size_ = file_.size();
+        if (size_ > 0) {
+            data_ = reinterpret_cast<const char *>(file_.map(0, size_));
+        }
+    }
+}
+
+MappedFile::~MappedFile() {
+    if (data_) {
+        file_.unmap(reinterpret_cast<uchar *>(const_cast<char *>(data_)));
+    }
+}
+
+std::shared_ptr<const MappedFile> MappedFile::map(QIODevice *device) {
+    assert(device != nullptr);
+
+    auto file = qobject_cast<QFile *>(device);
+    if (!file || file->isSequential() || file->fileName().isEmpty()) {
+        return nullptr;
+    }
+
+    std::shared_ptr<MappedFile> result(new MappedFile(file->fileName()));
+    if (!result->data_ || result->size_ != file->size()) {
+        return nullptr;
+    }
+
+    return result;
+}
+
+} // namespace image
+} // namespace core
+} // namespace nc
+
+/* vim:set et sts=4 sw=4: */
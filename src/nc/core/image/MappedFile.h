@@ -0,0 +1,82 @@
+/* The file is part of Snowman decompiler. */
+/* See doc/licenses.asciidoc for the licensing information. */
+
+#pragma once
+
+#include <nc/config.h>
+
+#include <memory>
+
+#include <QFile>
+
+#include <nc/common/Types.h>
+
+QT_BEGIN_NAMESPACE
+class QIODevice;
+QT_END_NAMESPACE
+
+namespace nc {
+namespace core {
+namespace image {
+
+/**
+ * Read-only memory mapping of a whole file.
+ *
+ * Pages of the file are brought in by the operating system on first access,
+ * so mapping even a huge file costs neither heap memory nor I/O up front.
+ */
+class MappedFile {
+    QFile file_; ///< Mapped file.
+    const char *data_; ///< Pointer to the beginning of the mapping.
+    ByteSize size_; ///< Size of the mapping.
+
+    /**
+     * Constructor.
+     *
+     * \param fileName Name of the file to map.
+     */
+    MappedFile(const QString &fileName);
+
+public:
+    /**
+     * Destructor. Unmaps the file.
+     */
+    ~MappedFile();
+
+    /**
+     * Maps the file an IO device reads from.
+     *
+     * \param device Valid pointer to an IO device.
+     *
+     * \return Pointer to the mapping, or nullptr if the device is not a plain
+     *         file or mapping it failed. In this case, the data must be read
+     *         from the device as usual.
+     */
+    static std::shared_ptr<const MappedFile> map(QIODevice *device);
+
+    /**
+     * \return Pointer to the beginning of the file contents.
+     */
+    const char *data() const { return data_; }
+
+    /**
+     * \return Size of the file.
+     */
+    ByteSize size() const { return size_; }
+
+    /**
+     * \param offset Offset in the file.
+     * \param size Size of the range.
+     *
+     * \return True if the given range lies completely within the file.
+     */
+    bool contains(ByteSize offset, ByteSize size) const {
+        return 0 <= offset && 0 <= size && offset <= size_ && size <= size_ - offset;
+    }
+};
+
+} // namespace image
+} // namespace core
+} // namespace nc
+
+/* vim:set et sts=4 sw=4: */
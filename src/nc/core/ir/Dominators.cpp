@@ -3,6 +3,9 @@
 
 #include "Dominators.h"
 
+#include <algorithm>
+#include <limits>
+
 #include <nc/common/CancellationToken.h>
 #include <nc/common/Foreach.h>
 
@@ -13,56 +16,145 @@ namespace nc {
 namespace core {
 namespace ir {
 
+namespace {
+
+const std::size_t UNDEFINED = std::numeric_limits<std::size_t>::max();
+
+} // anonymous namespace
+
 Dominators::Dominators(const CFG &cfg, const CancellationToken &canceled) {
     /*
-     * Each node dominates itself.
+     * Depth-first search computing the postorder of basic blocks.
+     * Basic blocks without predecessors are visited first; the remaining
+     * unvisited basic blocks (unreachable cycles) start new searches.
      */
+    std::vector<const BasicBlock *> postorder;
+    std::vector<const BasicBlock *> roots;
+    boost::unordered_map<const BasicBlock *, bool> visited;
+    std::vector<std::pair<const BasicBlock *, std::size_t>> stack;
+
+    auto visit = [&](const BasicBlock *root) {
+        if (visited[root]) {
+            return;
+        }
+        visited[root] = true;
+        roots.push_back(root);
+        stack.push_back(std::make_pair(root, 0));
+
+        while (!stack.empty()) {
+            auto &top = stack.back();
+            const auto &successors = cfg.getSuccessors(top.first);
+            if (top.second < successors.size()) {
+                auto successor = successors[top.second++];
+                if (!visited[successor]) {
+                    visited[successor] = true;
+                    stack.push_back(std::make_pair(successor, 0));
+                }
+            } else {
+                postorder.push_back(top.first);
+                stack.pop_back();
+            }
+        }
+    };
+
     foreach (auto basicBlock, cfg.basicBlocks()) {
-        dominators_[basicBlock].push_back(basicBlock);
+        if (cfg.getPredecessors(basicBlock).empty()) {
+            visit(basicBlock);
+        }
+    }
+    foreach (auto basicBlock, cfg.basicBlocks()) {
+        visit(basicBlock);
+    }
+
+    /*
+     * Number basic blocks in reverse postorder, starting from 1.
+     * Index 0 is reserved for the virtual root.
+     */
+    basicBlocks_.reserve(postorder.size() + 1);
+    basicBlocks_.push_back(nullptr);
+    basicBlocks_.insert(basicBlocks_.end(), postorder.rbegin(), postorder.rend());
+
+    indices_.reserve(postorder.size());
+    for (std::size_t i = 1; i < basicBlocks_.size(); ++i) {
+        indices_[basicBlocks_[i]] = i;
     }
 
     /*
-     * Recompute dominator sets until fixpoint.
+     * Compute immediate dominators until fixpoint.
      */
+    idoms_.assign(basicBlocks_.size(), UNDEFINED);
+    idoms_[0] = 0;
+    foreach (auto root, roots) {
+        idoms_[indices_[root]] = 0;
+    }
+
+    auto intersect = [this](std::size_t a, std::size_t b) -> std::size_t {
+        while (a != b) {
+            while (a > b) {
+                a = idoms_[a];
+            }
+            while (b > a) {
+                b = idoms_[b];
+            }
+        }
+        return a;
+    };
+
     bool changed;
     do {
         changed = false;
 
-        foreach (auto basicBlock, cfg.basicBlocks()) {
-            const auto &predecessors = cfg.getPredecessors(basicBlock);
+        for (std::size_t i = 1; i < basicBlocks_.size(); ++i) {
+            if (idoms_[i] == 0) {
+                continue;
+            }
 
-            if (!predecessors.empty()) {
-                boost::unordered_map<const BasicBlock *, std::size_t> intersection;
-                foreach (auto predecessor, predecessors) {
-                    foreach (auto predDominator, dominators_[predecessor]) {
-                        ++intersection[predDominator];
-                    }
+            std::size_t newIdom = UNDEFINED;
+            foreach (auto predecessor, cfg.getPredecessors(basicBlocks_[i])) {
+                auto j = indices_[predecessor];
+                if (idoms_[j] != UNDEFINED) {
+                    newIdom = newIdom == UNDEFINED ? j : intersect(newIdom, j);
                 }
-                intersection.erase(basicBlock);
+            }
 
-                std::vector<const BasicBlock *> newDominators;
-                foreach (const auto &pair, intersection) {
-                    if (pair.second == predecessors.size()) {
-                        newDominators.push_back(pair.first);
-                    }
-                }
-                newDominators.push_back(basicBlock);
-
-                auto &oldDominators = dominators_[basicBlock];
-                /* Sets grow monotonically, so we can just compare sizes. */
-                if (newDominators.size() != oldDominators.size()) {
-                    assert(newDominators.size() > oldDominators.size());
-                    oldDominators = std::move(newDominators);
-                    changed = true;
-                }
+            assert(newIdom != UNDEFINED);
+            if (idoms_[i] != newIdom) {
+                idoms_[i] = newIdom;
+                changed = true;
             }
         }
 
         canceled.poll();
     } while (changed);
 
-    foreach (auto &pair, dominators_) {
-        std::sort(pair.second.begin(), pair.second.end());
+    /*
+     * Number the nodes of the dominator tree in preorder and postorder.
+     */
+    std::vector<std::vector<std::size_t>> children(basicBlocks_.size());
+    for (std::size_t i = 1; i < basicBlocks_.size(); ++i) {
+        children[idoms_[i]].push_back(i);
+    }
+
+    preorder_.resize(basicBlocks_.size());
+    postorder_.resize(basicBlocks_.size());
+
+    std::size_t preorderNumber = 0;
+    std::size_t postorderNumber = 0;
+    std::vector<std::pair<std::size_t, std::size_t>> treeStack;
+
+    preorder_[0] = preorderNumber++;
+    treeStack.push_back(std::make_pair(0, 0));
+
+    while (!treeStack.empty()) {
+        auto &top = treeStack.back();
+        if (top.second < children[top.first].size()) {
+            auto child = children[top.first][top.second++];
+            preorder_[child] = preorderNumber++;
+            treeStack.push_back(std::make_pair(child, 0));
+        } else {
+            postorder_[top.first] = postorderNumber++;
+            treeStack.pop_back();
+        }
     }
 }
 
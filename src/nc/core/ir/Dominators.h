@@ -5,6 +5,7 @@
 
 #include <nc/config.h>
 
+#include <cassert>
 #include <vector>
 
 #include <boost/unordered_map.hpp>
@@ -22,16 +23,37 @@ class BasicBlock;
 class CFG;
 
 /**
- * Dominator sets.
+ * Dominator tree.
+ *
+ * The tree gives the usual dominance relation: in particular, a basic
+ * block before a cycle dominates the basic blocks in and after it,
+ * if all the paths to them pass through it.
+ *
+ * Basic blocks having no predecessors (and, for the parts of the graph not
+ * reachable from them, the first basic block of each such part) are treated
+ * as children of a virtual root node. Therefore, they dominate only the basic
+ * blocks reachable exclusively through them.
  */
 class Dominators {
-    /** Mapping from a basic block to the set of its dominators. */
-    boost::unordered_map<const BasicBlock *, std::vector<const BasicBlock *>> dominators_;
+    /** Mapping from a basic block to its index in the arrays below. */
+    boost::unordered_map<const BasicBlock *, std::size_t> indices_;
+
+    /** Basic blocks in reverse postorder, preceded by the virtual root (nullptr). */
+    std::vector<const BasicBlock *> basicBlocks_;
+
+    /** Index of the immediate dominator of each basic block. */
+    std::vector<std::size_t> idoms_;
+
+    /** Preorder numbers of basic blocks in the dominator tree. */
+    std::vector<std::size_t> preorder_;
+
+    /** Postorder numbers of basic blocks in the dominator tree. */
+    std::vector<std::size_t> postorder_;
 
 public:
     /**
-     * Constructs dominator sets from the control flow graph.
-     * Uses classic iterative algorithm for that.
+     * Constructs the dominator tree from the control flow graph.
+     * Uses the algorithm of Cooper, Harvey, and Kennedy for that.
      *
      * \param cfg Control flow graph.
      * \param canceled Cancellation token.
@@ -41,12 +63,11 @@ public:
     /**
      * \param basicBlock Valid pointer to a basic block.
      *
-     * \return The set of dominators of this basic block.
+     * \return Pointer to the immediate dominator of the basic block.
+     *         Can be nullptr if the basic block is a root of the dominator tree.
      */
-    const std::vector<const BasicBlock *> &getDominators(const BasicBlock *basicBlock) const {
-        assert(basicBlock != nullptr);
-        assert(nc::contains(dominators_, basicBlock));
-        return nc::find(dominators_, basicBlock);
+    const BasicBlock *getImmediateDominator(const BasicBlock *basicBlock) const {
+        return basicBlocks_[idoms_[getIndex(basicBlock)]];
     }
 
     /**
@@ -56,13 +77,21 @@ public:
      * \return True of dominating dominates dominated.
      */
     bool isDominating(const BasicBlock *dominating, const BasicBlock *dominated) const {
-        assert(dominating != nullptr);
-        assert(nc::contains(dominators_, dominating));
-        assert(dominated != nullptr);
-        assert(nc::contains(dominators_, dominated));
+        auto i = getIndex(dominating);
+        auto j = getIndex(dominated);
+        return preorder_[i] <= preorder_[j] && postorder_[j] <= postorder_[i];
+    }
 
-        const auto &dominators = getDominators(dominated);
-        return std::binary_search(dominators.begin(), dominators.end(), dominating);
+private:
+    /**
+     * \param basicBlock Valid pointer to a basic block.
+     *
+     * \return Index of the basic block.
+     */
+    std::size_t getIndex(const BasicBlock *basicBlock) const {
+        assert(basicBlock != nullptr);
+        assert(nc::contains(indices_, basicBlock));
+        return nc::find(indices_, basicBlock);
     }
 };
 
@@ -37,7 +37,7 @@ namespace nc {
 namespace core {
 namespace ir {
 
-Function::Function(): entry_(nullptr) {}
+Function::Function(): entry_(nullptr), termCount_(0) {}
 
 Function::~Function() {}
 
@@ -46,6 +46,16 @@ void Function::addBasicBlock(std::unique_ptr<BasicBlock> basicBlock) {
     basicBlocks_.push_back(std::move(basicBlock));
 }
 
+std::size_t Function::getTermIndex(const Term *term) const {
+    assert(term != nullptr);
+
+    if (term->index_ == Term::NO_INDEX) {
+        assert(termCount_ < Term::NO_INDEX);
+        term->index_ = static_cast<Term::Index>(termCount_++);
+    }
+    return term->index_;
+}
+
 bool Function::isEmpty() const {
     foreach (auto basicBlock, basicBlocks()) {
         if (!basicBlock->statements().empty()) {
@@ -30,6 +30,7 @@
 
 #include <boost/noncopyable.hpp>
 
+#include <nc/common/Arena.h>
 #include <nc/common/Printable.h>
 #include <nc/common/ilist.h>
 
@@ -38,6 +39,7 @@ namespace core {
 namespace ir {
 
 class BasicBlock;
+class Term;
 
 /**
  * Intermediate representation of a function.
@@ -47,8 +49,10 @@ public:
     typedef nc::ilist<BasicBlock> BasicBlocks;
 
 private:
+    Arena arena_; ///< Arena for the statements and terms of the function.
     BasicBlock *entry_; ///< Entry basic block.
     BasicBlocks basicBlocks_; ///< All basic blocks of the function.
+    mutable std::size_t termCount_; ///< Number of terms having been assigned an index.
 
 public:
     /**
@@ -61,6 +65,11 @@ public:
      */
     ~Function();
 
+    /**
+     * \return Arena from which the statements and terms of the function are to be allocated.
+     */
+    Arena &arena() { return arena_; }
+
     /**
      * \return Pointer to the entry basic block. Can be nullptr.
      */
@@ -101,6 +110,25 @@ public:
      */
     void addBasicBlock(std::unique_ptr<BasicBlock> basicBlock);
 
+    /**
+     * Returns the index of a term of this function, assigning the next
+     * free index to the term if it does not have one yet. Therefore, the
+     * indices of the terms of a function are small and contiguous.
+     *
+     * Assigning an index does not change the function logically, however,
+     * it must not happen concurrently for the same function.
+     *
+     * \param term Valid pointer to a term belonging to a statement of this function.
+     *
+     * \return Index of the term.
+     */
+    std::size_t getTermIndex(const Term *term) const;
+
+    /**
+     * \return Number of terms having been assigned an index.
+     */
+    std::size_t termCount() const { return termCount_; }
+
     /**
      * \return True iff this function has no statements in its basic blocks.
      */
@@ -0,0 +1,463 @@
+/* The file is part of Snowman decompiler. */
+/* See doc/licenses.asciidoc for the licensing information. */
+
+#include "FunctionCache.h"
+
+#include <algorithm>
+
+#include <QCryptographicHash>
+#include <QDataStream>
+#include <QTextStream>
+
+#include <nc/common/DiskCache.h>
+#include <nc/common/Foreach.h>
+#include <nc/common/Range.h>
+#include <nc/common/Version.h>
+#include <nc/core/arch/Architecture.h>
+#include <nc/core/arch/Instruction.h>
+#include <nc/core/image/Image.h>
+#include <nc/core/image/Relocation.h>
+#include <nc/core/image/Symbol.h>
+#include <nc/core/ir/BasicBlock.h>
+#include <nc/core/ir/CFG.h>
+#include <nc/core/ir/Function.h>
+#include <nc/core/ir/Functions.h>
+#include <nc/core/ir/Jump.h>
+#include <nc/core/ir/Statements.h>
+#include <nc/core/ir/Terms.h>
+#include <nc/core/ir/calling/CalleeId.h>
+#include <nc/core/ir/calling/Convention.h>
+#include <nc/core/ir/calling/Hooks.h>
+
+namespace nc {
+namespace core {
+namespace ir {
+
+namespace {
+
+/**
+ * Version of the format of the cached data.
+ * Must be incremented whenever the analyses or the format change.
+ */
+const int FORMAT_VERSION = 1;
+
+void getConstants(const Term *term, std::vector<ConstantValue> &result) {
+    if (auto constant = term->asConstant()) {
+        result.push_back(constant->value().value());
+    }
+    term->callOnChildren([&result](const Term *child) { getConstants(child, result); });
+}
+
+void getConstants(const JumpTarget &target, std::vector<ConstantValue> &result) {
+    if (target.address()) {
+        getConstants(target.address(), result);
+    }
+    if (target.table()) {
+        foreach (const auto &entry, *target.table()) {
+            result.push_back(entry.address());
+        }
+    }
+}
+
+/**
+ * \param statement Valid pointer to a statement.
+ *
+ * \return Values of the constants in the statement, in a fixed order.
+ */
+std::vector<ConstantValue> getConstants(const Statement *statement) {
+    std::vector<ConstantValue> result;
+
+    if (auto assignment = statement->asAssignment()) {
+        getConstants(assignment->left(), result);
+        getConstants(assignment->right(), result);
+    } else if (auto jump = statement->asJump()) {
+        if (jump->condition()) {
+            getConstants(jump->condition(), result);
+        }
+        getConstants(jump->thenTarget(), result);
+        getConstants(jump->elseTarget(), result);
+    } else if (auto call = statement->asCall()) {
+        getConstants(call->target(), result);
+    } else if (auto touch = statement->asTouch()) {
+        getConstants(touch->term(), result);
+    }
+
+    return result;
+}
+
+/**
+ * Replaces all little-endian encodings of the value in the given bytes by zeros.
+ *
+ * \param bytes Bytes.
+ * \param value Value.
+ * \param size Size of the encoding in bytes.
+ */
+void mask(QByteArray &bytes, ConstantValue value, int size) {
+    QByteArray pattern(size, 0);
+    for (int i = 0; i < size; ++i) {
+        pattern[i] = static_cast<char>(value >> (i * CHAR_BIT));
+    }
+
+    for (int i = bytes.indexOf(pattern); i != -1; i = bytes.indexOf(pattern, i + size)) {
+        std::fill(bytes.data() + i, bytes.data() + i + size, 0);
+    }
+}
+
+/**
+ * \param image Executable image.
+ * \param function Valid pointer to a function.
+ * \param hooks Hooks manager.
+ *
+ * \return Key of the function, or an empty array if the function cannot be cached.
+ */
+QByteArray computeKey(const image::Image &image, const Function *function, const calling::Hooks &hooks) {
+    if (!function->entry() || !function->entry()->address()) {
+        return QByteArray();
+    }
+
+    ByteAddr entryAddr = *function->entry()->address();
+
+    std::vector<const arch::Instruction *> instructions;
+    boost::unordered_map<const arch::Instruction *, std::vector<ConstantValue>> instruction2constants;
+
+    foreach (const BasicBlock *basicBlock, function->basicBlocks()) {
+        foreach (const Statement *statement, basicBlock->statements()) {
+            if (auto instruction = statement->instruction()) {
+                instructions.push_back(instruction);
+
+                auto &constants = instruction2constants[instruction];
+                auto statementConstants = getConstants(statement);
+                constants.insert(constants.end(), statementConstants.begin(), statementConstants.end());
+            }
+        }
+    }
+
+    if (instructions.empty()) {
+        return QByteArray();
+    }
+
+    std::sort(instructions.begin(), instructions.end(),
+        [](const arch::Instruction *a, const arch::Instruction *b) { return a->addr() < b->addr(); });
+    instructions.erase(std::unique(instructions.begin(), instructions.end()), instructions.end());
+
+    ByteAddr beginAddr = instructions.front()->addr();
+    ByteAddr endAddr = beginAddr;
+    foreach (const arch::Instruction *instruction, instructions) {
+        endAddr = std::max(endAddr, instruction->endAddr());
+    }
+
+    QString string;
+    QTextStream out(&string);
+
+    auto printOffset = [&](const BasicBlock *basicBlock) {
+        if (basicBlock->address()) {
+            out << ' ' << (*basicBlock->address() - entryAddr);
+        } else {
+            out << " ?";
+        }
+    };
+
+    /*
+     * Addresses are replaced by what they point to, so that
+     * the key does not change when the code is moved.
+     */
+    auto printIdentity = [&](ConstantValue value) {
+        auto addr = static_cast<ByteAddr>(value);
+        if (beginAddr <= addr && addr < endAddr) {
+            out << " local " << (addr - entryAddr);
+        } else if (auto symbol = image.getSymbol(value)) {
+            out << " symbol " << symbol->name();
+        } else {
+            out << " address " << value;
+        }
+    };
+
+    out << "function " << FORMAT_VERSION << ' ' << nc::version << endl;
+    out << "architecture " << image.platform().architecture()->name() << endl;
+
+    if (auto convention = hooks.getConvention(calling::getCalleeId(function))) {
+        out << "convention " << convention->name() << endl;
+    }
+
+    CFG cfg(function->basicBlocks());
+    foreach (const BasicBlock *basicBlock, function->basicBlocks()) {
+        out << "block";
+        printOffset(basicBlock);
+        out << " ->";
+        foreach (const BasicBlock *successor, cfg.getSuccessors(basicBlock)) {
+            printOffset(successor);
+        }
+        out << endl;
+    }
+
+    foreach (const arch::Instruction *instruction, instructions) {
+        QByteArray bytes(instruction->size(), 0);
+        image.readBytes(instruction->addr(), bytes.data(), instruction->size());
+
+        out << "instruction " << (instruction->addr() - entryAddr) << ' ' << instruction->size();
+
+        for (auto relocation = image.getNextRelocation(instruction->addr());
+             relocation && relocation->address() < instruction->endAddr();
+             relocation = image.getNextRelocation(relocation->address() + 1))
+        {
+            ByteSize offset = relocation->address() - instruction->addr();
+            out << " relocation " << offset << ' ' << relocation->symbol()->name() << '+' << relocation->addend();
+            std::fill(bytes.data() + offset, bytes.data() + std::min<ByteSize>(offset + relocation->size(), instruction->size()), 0);
+        }
+
+        /* Absolute and instruction-relative encodings of addresses are masked. */
+        foreach (ConstantValue value, nc::find(instruction2constants, instruction)) {
+            if (image.getSectionContainingAddress(static_cast<ByteAddr>(value))) {
+                printIdentity(value);
+                mask(bytes, value, 8);
+                mask(bytes, value, 4);
+                mask(bytes, value - instruction->endAddr(), 4);
+            }
+        }
+
+        out << ' ' << bytes.toHex() << endl;
+    }
+
+    out.flush();
+
+    return QCryptographicHash::hash(string.toUtf8(), QCryptographicHash::Sha1);
+}
+
+void save(QDataStream &out, const MemoryLocation &location) {
+    out << static_cast<bool>(location) << static_cast<qint32>(location.domain())
+        << static_cast<qint64>(location.addr()) << static_cast<qint64>(location.size());
+}
+
+bool load(QDataStream &in, MemoryLocation &location) {
+    bool valid;
+    qint32 domain;
+    qint64 addr, size;
+
+    in >> valid >> domain >> addr >> size;
+
+    if (!valid) {
+        location = MemoryLocation();
+    } else if (size > 0) {
+        location = MemoryLocation(domain, addr, size);
+    } else {
+        return false;
+    }
+    return in.status() == QDataStream::Ok;
+}
+
+} // anonymous namespace
+
+FunctionCache::FunctionCache(const DiskCache *storage):
+    storage_(storage), hits_(0)
+{}
+
+FunctionCache::~FunctionCache() {}
+
+void FunctionCache::load(const image::Image &image, const Functions &functions, const calling::Hooks &hooks) {
+    foreach (const auto &functionAndEntry, entries_) {
+        if (hasResults(functionAndEntry.second)) {
+            records_[functionAndEntry.second.key] = serialize(functionAndEntry.second);
+        }
+    }
+    entries_.clear();
+    hits_ = 0;
+
+    foreach (const Function *function, functions.list()) {
+        QByteArray key = computeKey(image, function, hooks);
+        if (key.isEmpty()) {
+            continue;
+        }
+
+        Entry &entry = entries_[function];
+        entry.key = key;
+
+        boost::optional<QByteArray> data;
+        auto i = records_.find(key);
+        if (i != records_.end()) {
+            data = i->second;
+        } else if (storage_) {
+            data = storage_->load(key);
+        }
+
+        if (!data) {
+            continue;
+        }
+
+        if (deserialize(*data, entry)) {
+            ++hits_;
+        } else {
+            entry = Entry();
+            entry.key = key;
+        }
+    }
+}
+
+const FunctionCache::Signature *FunctionCache::getSignature(const Function *function) const {
+    auto entry = getEntry(function);
+    return entry && entry->signature ? entry->signature.get_ptr() : nullptr;
+}
+
+void FunctionCache::setSignature(const Function *function, Signature signature) {
+    if (auto entry = getEntry(function)) {
+        entry->signature = std::move(signature);
+        entry->modified = true;
+    }
+}
+
+const cflow::Reductions *FunctionCache::getReductions(const Function *function) const {
+    auto entry = getEntry(function);
+    return entry && entry->reductions ? entry->reductions.get_ptr() : nullptr;
+}
+
+void FunctionCache::setReductions(const Function *function, cflow::Reductions reductions) {
+    assert(reductions.complete());
+
+    if (auto entry = getEntry(function)) {
+        entry->reductions = std::move(reductions);
+        entry->modified = true;
+    }
+}
+
+QByteArray FunctionCache::getDefinition(const Function *function) const {
+    auto entry = getEntry(function);
+    return entry ? entry->definition : QByteArray();
+}
+
+void FunctionCache::setDefinition(const Function *function, QByteArray definition) {
+    if (auto entry = getEntry(function)) {
+        entry->definition = std::move(definition);
+        entry->modified = true;
+    }
+}
+
+void FunctionCache::store() {
+    if (!storage_) {
+        return;
+    }
+
+    foreach (auto &functionAndEntry, entries_) {
+        Entry &entry = functionAndEntry.second;
+        if (entry.modified) {
+            storage_->store(entry.key, serialize(entry));
+            entry.modified = false;
+        }
+    }
+}
+
+void FunctionCache::saveResults(QDataStream &out) const {
+    std::map<QByteArray, QByteArray> records = records_;
+    foreach (const auto &functionAndEntry, entries_) {
+        if (hasResults(functionAndEntry.second)) {
+            records[functionAndEntry.second.key] = serialize(functionAndEntry.second);
+        }
+    }
+
+    out << static_cast<qint32>(FORMAT_VERSION) << static_cast<quint32>(records.size());
+    foreach (const auto &keyAndData, records) {
+        out << keyAndData.first << keyAndData.second;
+    }
+}
+
+bool FunctionCache::loadResults(QDataStream &in) {
+    qint32 formatVersion;
+    quint32 count;
+    in >> formatVersion >> count;
+
+    for (quint32 i = 0; i < count && in.status() == QDataStream::Ok; ++i) {
+        QByteArray key, data;
+        in >> key >> data;
+
+        /* Results of another version are skipped, but must still be read. */
+        if (formatVersion == FORMAT_VERSION) {
+            records_[key] = data;
+        }
+    }
+
+    return in.status() == QDataStream::Ok;
+}
+
+QByteArray FunctionCache::serialize(const Entry &entry) {
+    QByteArray data;
+    QDataStream out(&data, QIODevice::WriteOnly);
+
+    out << static_cast<bool>(entry.signature);
+    if (entry.signature) {
+        out << static_cast<quint32>(entry.signature->arguments.size());
+        foreach (const auto &argument, entry.signature->arguments) {
+            ir::save(out, argument);
+        }
+        ir::save(out, entry.signature->returnValue);
+    }
+
+    out << static_cast<bool>(entry.reductions);
+    if (entry.reductions) {
+        entry.reductions->save(out);
+    }
+
+    out << entry.definition;
+
+    return data;
+}
+
+bool FunctionCache::deserialize(const QByteArray &data, Entry &entry) {
+    QDataStream in(data);
+
+    bool hasSignature;
+    in >> hasSignature;
+    if (hasSignature) {
+        Signature signature;
+
+        quint32 count;
+        in >> count;
+        for (quint32 i = 0; i < count && in.status() == QDataStream::Ok; ++i) {
+            MemoryLocation argument;
+            if (!ir::load(in, argument) || !argument) {
+                return false;
+            }
+            signature.arguments.push_back(argument);
+        }
+        if (!ir::load(in, signature.returnValue)) {
+            return false;
+        }
+
+        entry.signature = std::move(signature);
+    }
+
+    bool hasReductions;
+    in >> hasReductions;
+    if (hasReductions) {
+        cflow::Reductions reductions;
+        if (!reductions.load(in)) {
+            return false;
+        }
+        entry.reductions = std::move(reductions);
+    }
+
+    in >> entry.definition;
+
+    return in.status() == QDataStream::Ok;
+}
+
+bool FunctionCache::hasResults(const Entry &entry) {
+    return entry.signature || entry.reductions || !entry.definition.isEmpty();
+}
+
+FunctionCache::Entry *FunctionCache::getEntry(const Function *function) {
+    assert(function != nullptr);
+
+    auto i = entries_.find(function);
+    return i != entries_.end() ? &i->second : nullptr;
+}
+
+const FunctionCache::Entry *FunctionCache::getEntry(const Function *function) const {
+    assert(function != nullptr);
+
+    auto i = entries_.find(function);
+    return i != entries_.end() ? &i->second : nullptr;
+}
+
+} // namespace ir
+} // namespace core
+} // namespace nc
+
+/* vim:set et sts=4 sw=4: */
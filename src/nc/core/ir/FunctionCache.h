@@ -0,0 +1,247 @@
+/* The file is part of Snowman decompiler. */
+/* See doc/licenses.asciidoc for the licensing information. */
+
+#pragma once
+
+#include <nc/config.h>
+
+#include <map>
+#include <vector>
+
+#include <QByteArray>
+#include <QDataStream>
+
+#include <boost/noncopyable.hpp>
+#include <boost/optional.hpp>
+#include <boost/unordered_map.hpp>
+
+#include <nc/core/ir/MemoryLocation.h>
+#include <nc/core/ir/cflow/Reductions.h>
+
+namespace nc {
+
+class DiskCache;
+
+namespace core {
+
+namespace image {
+    class Image;
+}
+
+namespace ir {
+
+class Function;
+class Functions;
+
+namespace calling {
+    class Hooks;
+}
+
+/**
+ * Cache of per-function analysis results, shared between runs.
+ *
+ * The results of a function are stored under a hash of its code only:
+ * instruction bytes and basic blocks relative to the function's entry,
+ * with embedded addresses replaced by the identities of what they point
+ * to (the function itself, a symbol, or an absolute address). Therefore,
+ * the key does not depend on the results of any analysis and can be
+ * computed right after the functions are created. The results are then
+ * used instead of running the corresponding analyses:
+ *
+ * - the arguments and the return value of the function
+ *   are used by the signature reconstruction as is;
+ * - the reductions performed by the structural analysis are replayed;
+ * - the generated definition is reused if everything else
+ *   it depends on is unchanged (see cgen::DefinitionCache).
+ *
+ * Without a storage, the results are only kept in memory: they are reused
+ * when the same functions are analyzed again, and can be saved as a part
+ * of a session (see saveResults()).
+ *
+ * The set of cached functions is fixed by load(). After that, the results
+ * of different functions can be read and written from different threads.
+ */
+class FunctionCache: boost::noncopyable {
+public:
+    /**
+     * Arguments and return value of a function.
+     */
+    struct Signature {
+        std::vector<MemoryLocation> arguments; ///< Formal arguments.
+        MemoryLocation returnValue; ///< Return value location. Can be invalid.
+    };
+
+private:
+    /**
+     * Cached results of a single function.
+     */
+    struct Entry {
+        QByteArray key; ///< Key of the function.
+        boost::optional<Signature> signature; ///< Signature of the function.
+        boost::optional<cflow::Reductions> reductions; ///< Reductions of the structural analysis.
+        QByteArray definition; ///< Data of cgen::DefinitionCache.
+        bool modified; ///< Whether the results must be stored.
+
+        Entry(): modified(false) {}
+    };
+
+    /** Storage of the cached data. Can be nullptr. */
+    const DiskCache *storage_;
+
+    /** Serialized results kept in memory, by keys. */
+    std::map<QByteArray, QByteArray> records_;
+
+    /** Entries of the functions that can be cached. */
+    boost::unordered_map<const Function *, Entry> entries_;
+
+    /** Number of functions whose results were found. */
+    std::size_t hits_;
+
+public:
+    /**
+     * Constructor.
+     *
+     * \param storage Pointer to the storage of the cached data.
+     *                Can be nullptr, in which case the results are kept in memory only.
+     */
+    explicit FunctionCache(const DiskCache *storage);
+
+    /**
+     * Destructor.
+     */
+    ~FunctionCache();
+
+    /**
+     * Computes the keys of the given functions and loads their results
+     * from memory or from the storage. The results of the functions
+     * passed to the previous call are kept in memory.
+     *
+     * \param image Executable image.
+     * \param functions Functions.
+     * \param hooks Hooks manager with calling conventions detected.
+     */
+    void load(const image::Image &image, const Functions &functions, const calling::Hooks &hooks);
+
+    /**
+     * \return Number of functions that can be cached.
+     */
+    std::size_t size() const { return entries_.size(); }
+
+    /**
+     * \return Number of functions whose results were found in memory or in the storage.
+     */
+    std::size_t hits() const { return hits_; }
+
+    /**
+     * \param function Valid pointer to a function.
+     *
+     * \return Pointer to the cached signature of the function. Can be nullptr.
+     */
+    const Signature *getSignature(const Function *function) const;
+
+    /**
+     * Sets the signature of a function, if the function can be cached.
+     *
+     * \param function Valid pointer to a function.
+     * \param signature Signature.
+     */
+    void setSignature(const Function *function, Signature signature);
+
+    /**
+     * \param function Valid pointer to a function.
+     *
+     * \return Pointer to the cached reductions of the structural analysis
+     *         of the function. Can be nullptr.
+     */
+    const cflow::Reductions *getReductions(const Function *function) const;
+
+    /**
+     * Sets the reductions of the structural analysis of a function, if the function can be cached.
+     *
+     * \param function Valid pointer to a function.
+     * \param reductions Complete recording of the reductions.
+     */
+    void setReductions(const Function *function, cflow::Reductions reductions);
+
+    /**
+     * \param function Valid pointer to a function.
+     *
+     * \return Cached data of the function's definition. Empty if there are none.
+     */
+    QByteArray getDefinition(const Function *function) const;
+
+    /**
+     * Sets the data of a function's definition, if the function can be cached.
+     *
+     * \param function Valid pointer to a function.
+     * \param definition Data.
+     */
+    void setDefinition(const Function *function, QByteArray definition);
+
+    /**
+     * Writes the results that have changed since load() to the storage, if there is one.
+     */
+    void store();
+
+    /**
+     * Writes all the results kept in memory to a stream, e.g. a session file.
+     *
+     * \param out Stream.
+     */
+    void saveResults(QDataStream &out) const;
+
+    /**
+     * Reads results written by saveResults() into memory.
+     * They are used by the next call to load().
+     *
+     * \param in Stream.
+     *
+     * \return True on success, false if the data are malformed.
+     */
+    bool loadResults(QDataStream &in);
+
+private:
+    /**
+     * \param entry Entry.
+     *
+     * \return Serialized results of the entry.
+     */
+    static QByteArray serialize(const Entry &entry);
+
+    /**
+     * Reads the results of an entry.
+     *
+     * \param data Serialized results.
+     * \param entry Entry without results.
+     *
+     * \return True on success, false if the data are malformed.
+     */
+    static bool deserialize(const QByteArray &data, Entry &entry);
+
+    /**
+     * \param entry Entry.
+     *
+     * \return True if the entry has any results.
+     */
+    static bool hasResults(const Entry &entry);
+
+    /**
+     * \param function Valid pointer to a function.
+     *
+     * \return Pointer to the entry of the function, or nullptr if it cannot be cached.
+     */
+    Entry *getEntry(const Function *function);
+
+    /**
+     * \param function Valid pointer to a function.
+     *
+     * \return Pointer to the entry of the function, or nullptr if it cannot be cached.
+     */
+    const Entry *getEntry(const Function *function) const;
+};
+
+} // namespace ir
+} // namespace core
+} // namespace nc
+
+/* vim:set et sts=4 sw=4: */
@@ -27,6 +27,7 @@
 #include <boost/range/adaptor/map.hpp>
 #include <boost/unordered_set.hpp>
 
+#include <nc/common/Arena.h>
 #include <nc/common/Foreach.h>
 #include <nc/common/Range.h>
 
@@ -133,7 +134,8 @@ std::unique_ptr<Function> FunctionsGenerator::makeFunction(const std::vector<con
     /* Create a new function. */
     std::unique_ptr<Function> function(new Function);
 
-    /* Clone basic blocks into it. */
+    /* Clone basic blocks into it, keeping the function's statements close together in memory. */
+    Arena::Scope scope(function->arena());
     auto clones = cloneIntoFunction(basicBlocks, function.get());
 
     /* Set the entry basic block. */
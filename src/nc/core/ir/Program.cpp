@@ -29,6 +29,9 @@
 
 #include <QTextStream>
 
+#include <boost/unordered_map.hpp>
+#include <boost/unordered_set.hpp>
+
 #include <nc/common/Foreach.h>
 #include <nc/common/Range.h> /* For nc::find. */
 #include <nc/common/make_unique.h>
@@ -36,6 +39,7 @@
 #include <nc/core/arch/Instruction.h>
 
 #include "CFG.h"
+#include "Jump.h"
 #include "Statement.h"
 
 namespace nc {
@@ -128,6 +132,83 @@ BasicBlock *Program::takeOwnership(std::unique_ptr<BasicBlock> basicBlock) {
     return result;
 }
 
+void Program::append(Program &that) {
+    /* Blocks of that program merged into existing blocks of this one. */
+    boost::unordered_map<const BasicBlock *, BasicBlock *> replacements;
+    std::vector<std::unique_ptr<BasicBlock>> mergedBlocks;
+
+    std::vector<BasicBlock *> movedBlocks;
+    boost::unordered_set<const BasicBlock *> isMoved;
+
+    while (!that.basicBlocks_.empty()) {
+        std::unique_ptr<BasicBlock> basicBlock = that.basicBlocks_.pop_front();
+
+        BasicBlock *existing = nullptr;
+        if (basicBlock->address()) {
+            ByteAddr address = *basicBlock->address();
+
+            /*
+             * There can be an empty block created at the address as a direct
+             * successor of an instruction lifted here. Otherwise, when lifting
+             * into this program, getBasicBlockForInstruction() would have
+             * appended the instruction at the address to the block of this
+             * program covering the previous address.
+             */
+            existing = getBasicBlockStartingAt(address);
+            if (!existing) {
+                auto previous = getBasicBlockCovering(address - 1);
+                if (previous && !nc::contains(isMoved, previous)) {
+                    existing = previous;
+                }
+            }
+        }
+
+        if (existing) {
+            removeRange(existing);
+            while (!basicBlock->statements().empty()) {
+                existing->pushBack(basicBlock->erase(basicBlock->statements().front()));
+            }
+            existing->setSuccessorAddress(basicBlock->successorAddress());
+            addRange(existing);
+
+            replacements[basicBlock.get()] = existing;
+            movedBlocks.push_back(existing);
+            isMoved.insert(existing);
+            mergedBlocks.push_back(std::move(basicBlock));
+        } else {
+            bool memoryBound = basicBlock->address().is_initialized();
+            BasicBlock *result = takeOwnership(std::move(basicBlock));
+            if (memoryBound) {
+                addRange(result);
+            }
+            movedBlocks.push_back(result);
+            isMoved.insert(result);
+        }
+    }
+    that.range2basicBlock_.clear();
+    that.start2basicBlock_.clear();
+
+    if (!replacements.empty()) {
+        auto replace = [&](JumpTarget &target) {
+            if (auto replacement = nc::find(replacements, target.basicBlock())) {
+                target.setBasicBlock(replacement);
+            }
+        };
+
+        foreach (BasicBlock *basicBlock, movedBlocks) {
+            foreach (Statement *statement, basicBlock->statements()) {
+                if (auto jump = statement->as<Jump>()) {
+                    replace(jump->thenTarget());
+                    replace(jump->elseTarget());
+                }
+            }
+        }
+    }
+
+    calledAddresses_.insert(that.calledAddresses_.begin(), that.calledAddresses_.end());
+    that.calledAddresses_.clear();
+}
+
 void Program::print(QTextStream &out) const {
     out << "digraph Program" << this << " {" << endl;
     out << CFG(basicBlocks());
@@ -29,6 +29,7 @@
 #include <boost/unordered_map.hpp>
 #include <boost/unordered_set.hpp>
 
+#include <nc/common/Arena.h>
 #include <nc/common/Printable.h>
 #include <nc/common/Range.h> /* nc::contains */
 #include <nc/common/RangeClass.h>
@@ -61,6 +62,7 @@ private:
         }
     };
 
+    Arena arena_; ///< Arena for the statements and terms of the program.
     BasicBlocks basicBlocks_; ///< Basic blocks.
     std::map<AddrRange, BasicBlock *, ToTheLeft> range2basicBlock_; ///< Mapping of a range of addresses to the basic block covering the range.
     boost::unordered_map<ByteAddr, BasicBlock *> start2basicBlock_; ///< Mapping of an address to the basic block at this address.
@@ -77,6 +79,11 @@ public:
      */
     ~Program();
 
+    /**
+     * \return Arena from which the statements and terms of the program are to be allocated.
+     */
+    Arena &arena() { return arena_; }
+
     /**
      * \return All basic blocks of the program.
      *
@@ -149,6 +156,16 @@ public:
      */
     bool isCalledAddress(ByteAddr addr) const { return nc::contains(calledAddresses_, addr); }
 
+    /**
+     * Moves the basic blocks and called addresses of the given program into
+     * this one. The given program must have been created by lifting instructions
+     * located after all the instructions lifted into this program. The result
+     * is the same as if these instructions were lifted into this program.
+     *
+     * \param[in,out] that Program to take the contents of. Left empty.
+     */
+    void append(Program &that);
+
     /**
      * Prints the graph into a stream in DOT format.
      *
@@ -32,6 +32,7 @@
 
 #include <QString>
 
+#include <nc/common/Arena.h>
 #include <nc/common/Printable.h>
 #include <nc/common/Subclass.h>
 #include <nc/common/ilist.h>
@@ -57,11 +58,15 @@ class Touch;
 
 /**
  * Base class for different kinds of statements of intermediate representation.
+ *
+ * Statements are allocated from the current nc::Arena, if any.
  */
 class Statement: public Printable, public nc::ilist_item, boost::noncopyable {
     NC_BASE_CLASS(Statement, kind)
 
 public:
+    NC_ARENA_ALLOCATED
+
     /**
      * Statement kind.
      */
@@ -26,10 +26,12 @@
 #include <nc/config.h>
 
 #include <cassert>
+#include <cstdint>
 #include <memory>
 
 #include <boost/noncopyable.hpp>
 
+#include <nc/common/Arena.h>
 #include <nc/common/Printable.h>
 #include <nc/common/Subclass.h>
 #include <nc/common/Types.h>
@@ -51,11 +53,17 @@ class Statement;
 
 /**
  * Base class for different kinds of expressions of intermediate representation.
+ *
+ * Terms are allocated from the current nc::Arena, if any.
  */
 class Term: public Printable, boost::noncopyable {
     NC_BASE_CLASS(Term, kind)
 
+    friend class Function;
+
 public:
+    NC_ARENA_ALLOCATED
+
     /**
      * Term kind.
      */
@@ -76,9 +84,20 @@ public:
         WRITE,     ///< Term is written.
     };
 
+    /**
+     * Type of a term's index within its function.
+     */
+    typedef std::uint32_t Index;
+
+    /**
+     * Value of the index of a term that has not been assigned an index yet.
+     */
+    static const Index NO_INDEX = static_cast<Index>(-1);
+
 private:
     const Statement *statement_; ///< Statement that this term belongs to.
     SmallBitSize size_; ///< Size of this term's value in bits.
+    mutable Index index_; ///< Index of this term within its function.
 
 public:
     /**
@@ -88,7 +107,7 @@ public:
      * \param[in] size Size of this term's value in bits.
      */
     Term(int kind, SmallBitSize size):
-        kind_(kind), statement_(nullptr), size_(size)
+        kind_(kind), statement_(nullptr), size_(size), index_(NO_INDEX)
     {
         assert(size != 0);
     }
@@ -112,6 +131,14 @@ public:
      */
     void setStatement(const Statement *statement);
 
+    /**
+     * \return Index of this term within its function, or NO_INDEX if not assigned yet.
+     *
+     * Indices are assigned by Function::getTermIndex() and are dense,
+     * which allows to store information about terms in arrays.
+     */
+    Index index() const { return index_; }
+
     /**
      * \return Term's access type.
      */
@@ -45,6 +45,8 @@ CallHook::CallHook(const Convention *convention, const CallSignature *signature,
 {
     assert(convention != nullptr);
 
+    Arena::Scope scope(patch_.arena());
+
     auto &statements = patch_.statements();
 
     if (convention->stackPointer()) {
@@ -41,6 +41,8 @@ namespace calling {
 EntryHook::EntryHook(const Convention *convention, const FunctionSignature *signature) {
     assert(convention != nullptr);
 
+    Arena::Scope scope(patch_.arena());
+
     auto &statements = patch_.statements();
 
     if (convention->stackPointer()) {
@@ -26,6 +26,8 @@
 
 #include <cassert>
 
+#include <QMutexLocker>
+
 #include <nc/common/Foreach.h>
 #include <nc/common/Range.h>
 #include <nc/common/make_unique.h>
@@ -52,7 +54,7 @@ namespace ir {
 namespace calling {
 
 Hooks::Hooks(const Conventions &conventions, const Signatures &signatures):
-    conventions_(conventions), signatures_(signatures)
+    conventions_(conventions), signatures_(signatures), mutex_(QMutex::Recursive)
 {}
 
 Hooks::~Hooks() {}
@@ -61,6 +63,9 @@ const Convention *Hooks::getConvention(const CalleeId &calleeId) const {
     if (!calleeId) {
         return nullptr;
     }
+
+    QMutexLocker locker(&mutex_);
+
     if (auto result = conventions_.getConvention(calleeId)) {
         return result;
     } else {
@@ -72,18 +77,24 @@ const Convention *Hooks::getConvention(const CalleeId &calleeId) const {
 const EntryHook *Hooks::getEntryHook(const Function *function) const {
     assert(function != nullptr);
 
+    QMutexLocker locker(&mutex_);
+
     return nc::find(lastEntryHooks_, function);
 }
 
 const CallHook *Hooks::getCallHook(const Call *call) const {
     assert(call != nullptr);
 
+    QMutexLocker locker(&mutex_);
+
     return nc::find(lastCallHooks_, call);
 }
 
 const ReturnHook *Hooks::getReturnHook(const Jump *jump) const {
     assert(jump != nullptr);
 
+    QMutexLocker locker(&mutex_);
+
     return nc::find(lastReturnHooks_, jump);
 }
 
@@ -91,6 +102,8 @@ void Hooks::instrument(Function *function, const dflow::Dataflow *dataflow) {
     assert(function != nullptr);
     assert(dataflow != nullptr);
 
+    QMutexLocker locker(&mutex_);
+
     deinstrument(function);
 
     if (function->entry()) {
@@ -121,6 +134,8 @@ void Hooks::instrument(Function *function, const dflow::Dataflow *dataflow) {
 void Hooks::deinstrument(Function *function) {
     assert(function != nullptr);
 
+    QMutexLocker locker(&mutex_);
+
     if (auto callback = nc::find(function2callback_, function)) {
         deinstrumentEntry(function);
         callback->basicBlock()->erase(callback);
@@ -147,6 +162,8 @@ void Hooks::deinstrument(Function *function) {
 }
 
 void Hooks::instrumentEntry(Function *function) {
+    QMutexLocker locker(&mutex_);
+
     auto convention = getConvention(getCalleeId(function));
     auto signature = signatures_.getSignature(function).get();
     auto &entryHook = entryHooks_[std::make_tuple(function, convention, signature)];
@@ -170,6 +187,8 @@ void Hooks::instrumentEntry(Function *function) {
 }
 
 void Hooks::deinstrumentEntry(Function *function) {
+    QMutexLocker locker(&mutex_);
+
     auto &lastEntryHook = lastEntryHooks_[function];
 
     if (lastEntryHook) {
@@ -179,6 +198,8 @@ void Hooks::deinstrumentEntry(Function *function) {
 }
 
 void Hooks::instrumentCall(Call *call, const dflow::Dataflow &dataflow) {
+    QMutexLocker locker(&mutex_);
+
     auto calleeId = getCalleeId(call, dataflow);
     auto convention = getConvention(calleeId);
     auto signature = signatures_.getSignature(call).get();
@@ -204,6 +225,8 @@ void Hooks::instrumentCall(Call *call, const dflow::Dataflow &dataflow) {
 }
 
 void Hooks::deinstrumentCall(Call *call) {
+    QMutexLocker locker(&mutex_);
+
     auto &lastCallHook = lastCallHooks_[call];
 
     if (lastCallHook) {
@@ -213,6 +236,8 @@ void Hooks::deinstrumentCall(Call *call) {
 }
 
 void Hooks::instrumentReturn(Jump *jump) {
+    QMutexLocker locker(&mutex_);
+
     auto function = jump->basicBlock()->function();
     auto convention = getConvention(getCalleeId(function));
     auto signature = signatures_.getSignature(function).get();
@@ -237,6 +262,8 @@ void Hooks::instrumentReturn(Jump *jump) {
 }
 
 void Hooks::deinstrumentReturn(Jump *jump) {
+    QMutexLocker locker(&mutex_);
+
     auto &lastReturnHook = lastReturnHooks_[jump];
 
     if (lastReturnHook) {
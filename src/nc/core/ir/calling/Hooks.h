@@ -38,6 +38,8 @@
 #include <boost/optional.hpp>
 #include <boost/unordered_map.hpp>
 
+#include <QMutex>
+
 #include <nc/common/Types.h>
 
 #include "CalleeId.h"
@@ -114,6 +116,12 @@ private:
     /** Mapping from a return jump to the last return hook used for instrumenting it. */
     boost::unordered_map<const Jump *, ReturnHook *> lastReturnHooks_;
 
+    /**
+     * Mutex protecting the mappings above and the conventions.
+     * Hooks of different functions can be executed concurrently.
+     */
+    mutable QMutex mutex_;
+
 public:
     /**
      * Constructor.
@@ -7,6 +7,7 @@
 
 #include <vector>
 
+#include <nc/common/Arena.h>
 #include <nc/common/ilist.h>
 
 namespace nc {
@@ -22,12 +23,18 @@ namespace calling {
  * after a given statement and removed later.
  */
 class Patch {
+    Arena arena_;
     nc::ilist<Statement> statements_;
     std::vector<Statement *> insertedStatements_;
 
 public:
     ~Patch();
 
+    /**
+     * \return Arena from which the statements of the patch are to be allocated.
+     */
+    Arena &arena() { return arena_; }
+
     /**
      * \return Statements of the patch.
      */
@@ -41,6 +41,8 @@ namespace calling {
 ReturnHook::ReturnHook(const Convention *convention, const FunctionSignature *signature) {
     assert(convention != nullptr);
 
+    Arena::Scope scope(patch_.arena());
+
     auto &statements = patch_.statements();
 
     auto addReturnValueRead = [&](std::unique_ptr<Term> term) {
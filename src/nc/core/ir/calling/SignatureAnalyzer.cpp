@@ -3,7 +3,9 @@
 
 #include "SignatureAnalyzer.h"
 
+#include <algorithm>
 #include <cstdint> /* uintptr_t */
+#include <set>
 
 #include <boost/range/adaptor/map.hpp>
 
@@ -44,6 +46,23 @@ SignatureAnalyzer::SignatureAnalyzer(Signatures &signatures, const dflow::Datafl
 
 SignatureAnalyzer::~SignatureAnalyzer() {}
 
+void SignatureAnalyzer::setKnownSignature(const CalleeId &calleeId, std::vector<MemoryLocation> arguments,
+                                          const MemoryLocation &returnValue) {
+    assert(calleeId);
+
+    id2arguments_[calleeId] = std::move(arguments);
+    id2returnValue_[calleeId] = returnValue;
+    knownIds_.insert(calleeId);
+}
+
+const std::vector<MemoryLocation> &SignatureAnalyzer::getArguments(const CalleeId &calleeId) const {
+    return nc::find(id2arguments_, calleeId);
+}
+
+const MemoryLocation &SignatureAnalyzer::getReturnValue(const CalleeId &calleeId) const {
+    return nc::find(id2returnValue_, calleeId);
+}
+
 void SignatureAnalyzer::analyze() {
     computeMappings();
     computeUses();
@@ -92,29 +111,201 @@ void SignatureAnalyzer::computeUses() {
     }
 }
 
+namespace {
+
+/**
+ * Numbers strongly connected components of a graph, so that every
+ * component gets a greater number than the components reachable from it.
+ * Uses an iterative version of Tarjan's algorithm.
+ *
+ * \param nodes Nodes of the graph.
+ * \param getSuccessors Function returning a const reference to the vector of successors of a node.
+ *
+ * \return Mapping from a node to the number of its component.
+ */
+template<class Node, class GetSuccessors>
+boost::unordered_map<Node, std::size_t> numberComponents(const std::vector<Node> &nodes, const GetSuccessors &getSuccessors) {
+    struct State {
+        std::size_t index;
+        std::size_t lowlink;
+        bool onStack;
+    };
+
+    struct Frame {
+        Node node;
+        const std::vector<Node> *successors;
+        std::size_t next;
+    };
+
+    boost::unordered_map<Node, State> states;
+    boost::unordered_map<Node, std::size_t> result;
+    std::vector<Node> stack;
+    std::vector<Frame> frames;
+    std::size_t nextIndex = 0;
+    std::size_t nextComponent = 0;
+
+    auto visit = [&](const Node &node) {
+        State state = { nextIndex, nextIndex, true };
+        ++nextIndex;
+        states[node] = state;
+        stack.push_back(node);
+        Frame frame = { node, &getSuccessors(node), 0 };
+        frames.push_back(frame);
+    };
+
+    foreach (const Node &root, nodes) {
+        if (states.find(root) != states.end()) {
+            continue;
+        }
+
+        visit(root);
+
+        while (!frames.empty()) {
+            Frame &frame = frames.back();
+
+            if (frame.next < frame.successors->size()) {
+                const Node &successor = (*frame.successors)[frame.next++];
+
+                auto i = states.find(successor);
+                if (i == states.end()) {
+                    visit(successor);
+                } else if (i->second.onStack) {
+                    State &state = states[frame.node];
+                    state.lowlink = std::min(state.lowlink, i->second.index);
+                }
+            } else {
+                Node node = frame.node;
+                frames.pop_back();
+
+                const State &state = states[node];
+                if (state.lowlink == state.index) {
+                    Node member;
+                    do {
+                        member = stack.back();
+                        stack.pop_back();
+                        states[member].onStack = false;
+                        result[member] = nextComponent;
+                    } while (member != node);
+                    ++nextComponent;
+                }
+
+                if (!frames.empty()) {
+                    State &parentState = states[frames.back().node];
+                    parentState.lowlink = std::min(parentState.lowlink, states[node].lowlink);
+                }
+            }
+        }
+    }
+
+    return result;
+}
+
+/**
+ * Maximal number of times the arguments and the return value
+ * of a single callee id are recomputed.
+ */
+const int MAX_RECOMPUTATIONS = 8;
+
+} // anonymous namespace
+
 void SignatureAnalyzer::computeArgumentsAndReturnValues() {
-    int niterations = 0;
+    /*
+     * Arguments and return values of a callee id depend mostly on those of
+     * the callee ids it calls. Therefore, callee ids are processed bottom-up
+     * in the order of strongly connected components of the call graph, and
+     * a callee id is only processed again when something it depends on changes.
+     */
+    std::vector<CalleeId> calleeIds;
+    boost::unordered_map<CalleeId, std::vector<CalleeId>> id2calleeIds;
+
+    foreach (const auto &idAndReferrers, id2referrers_) {
+        calleeIds.push_back(idAndReferrers.first);
+        foreach (auto call, idAndReferrers.second.calls) {
+            id2calleeIds[getCalleeId(call->basicBlock()->function())].push_back(idAndReferrers.first);
+        }
+    }
+
+    auto components = numberComponents(calleeIds, [&](const CalleeId &calleeId) -> const std::vector<CalleeId> & {
+        return nc::find(id2calleeIds, calleeId);
+    });
 
-    bool changed;
-    do {
-        changed = false;
+    std::stable_sort(calleeIds.begin(), calleeIds.end(), [&](const CalleeId &a, const CalleeId &b) {
+        return components[a] < components[b];
+    });
 
-        foreach (const CalleeId &calleeId, id2referrers_ | boost::adaptors::map_keys) {
-            if (computeArguments(calleeId)) {
-                changed = true;
+    /* Positions of callee ids in the bottom-up order. */
+    boost::unordered_map<CalleeId, std::size_t> id2position;
+    std::set<std::size_t> worklist;
+
+    for (std::size_t i = 0; i < calleeIds.size(); ++i) {
+        /* Known signatures are never recomputed. */
+        if (!nc::contains(knownIds_, calleeIds[i])) {
+            id2position[calleeIds[i]] = i;
+            worklist.insert(i);
+        }
+    }
+
+    auto enqueue = [&](const CalleeId &calleeId) {
+        auto i = id2position.find(calleeId);
+        if (i != id2position.end()) {
+            worklist.insert(i->second);
+        }
+    };
+
+    /*
+     * Return value location of a callee id affects the speculative
+     * return value terms in the functions calling it and in its own
+     * functions, and everything computed from these functions.
+     */
+    auto enqueueDependentOnFunction = [&](const Function *function) {
+        enqueue(getCalleeId(function));
+
+        const auto &dataflow = *dataflows_.at(function);
+        foreach (auto call, nc::find(function2calls_, function)) {
+            enqueue(getCalleeId(call, dataflow));
+        }
+    };
+
+    std::vector<int> recomputations(calleeIds.size());
+    std::size_t ngaveUp = 0;
+
+    while (!worklist.empty()) {
+        std::size_t position = *worklist.begin();
+        worklist.erase(worklist.begin());
+
+        if (++recomputations[position] > MAX_RECOMPUTATIONS) {
+            if (recomputations[position] == MAX_RECOMPUTATIONS + 1) {
+                ++ngaveUp;
             }
-            if (computeReturnValue(calleeId)) {
-                changed = true;
+            continue;
+        }
+
+        const CalleeId &calleeId = calleeIds[position];
+        const auto &referrers = nc::find(id2referrers_, calleeId);
+
+        if (computeArguments(calleeId)) {
+            /* Arguments of a callee id are used when computing the arguments of its callers. */
+            foreach (auto call, referrers.calls) {
+                enqueue(getCalleeId(call->basicBlock()->function()));
             }
         }
 
-        if (++niterations > 3) {
-            log_.warning(tr("Fixpoint was not reached after %1 iterations while reconstructing arguments. Giving up.").arg(niterations));
-            break;
+        if (computeReturnValue(calleeId)) {
+            foreach (auto call, referrers.calls) {
+                enqueueDependentOnFunction(call->basicBlock()->function());
+            }
+            foreach (auto function, referrers.functions) {
+                enqueueDependentOnFunction(function);
+            }
         }
 
         canceled_.poll();
-    } while (changed);
+    }
+
+    if (ngaveUp) {
+        log_.warning(tr("Fixpoint was not reached for %1 callee ids after %2 recomputations while reconstructing arguments. Giving up.")
+            .arg(ngaveUp).arg(MAX_RECOMPUTATIONS));
+    }
 }
 
 namespace {
@@ -343,9 +534,8 @@ std::vector<MemoryLocation> SignatureAnalyzer::getUndefinedUses(const Function *
      * can be passed, and nobody defines this memory location, this
      * location is likely to be actually used for passing an argument.
      */
-    foreach (const auto &termAndLocation, dataflow.term2location()) {
-        auto term = termAndLocation.first;
-        const auto &memoryLocation = termAndLocation.second;
+    foreach (auto term, dataflow.terms()) {
+        const auto &memoryLocation = dataflow.getMemoryLocation(term);
 
         if (memoryLocation && term->isRead() && dataflow.getDefinitions(term).empty() && intersect(term, memoryLocation)) {
             result.push_back(memoryLocation);
@@ -10,6 +10,7 @@
 #include <QCoreApplication>
 
 #include <boost/unordered_map.hpp>
+#include <boost/unordered_set.hpp>
 
 #include <nc/common/CancellationToken.h>
 #include <nc/common/LogToken.h>
@@ -88,6 +89,9 @@ class SignatureAnalyzer {
     /** Mapping from a callee id to the estimated return value location. */
     boost::unordered_map<CalleeId, MemoryLocation> id2returnValue_;
 
+    /** Callee ids whose arguments and return values are known in advance. */
+    boost::unordered_set<CalleeId> knownIds_;
+
 public:
     /**
      * Constructor.
@@ -107,8 +111,34 @@ public:
      */
     ~SignatureAnalyzer();
 
+    /**
+     * Sets the arguments and the return value of a callee id, e.g. the ones
+     * reconstructed earlier for a function with identical code.
+     * They are used as is and not recomputed by analyze().
+     *
+     * \param calleeId Valid callee id.
+     * \param arguments Formal arguments.
+     * \param returnValue Return value location. Can be invalid.
+     */
+    void setKnownSignature(const CalleeId &calleeId, std::vector<MemoryLocation> arguments, const MemoryLocation &returnValue);
+
     void analyze();
 
+    /**
+     * \param calleeId Valid callee id.
+     *
+     * eturn Formal arguments of the callee id computed by analyze().
+     */
+    const std::vector<MemoryLocation> &getArguments(const CalleeId &calleeId) const;
+
+    /**
+     * \param calleeId Valid callee id.
+     *
+     * eturn Return value location of the callee id computed by analyze().
+     *         Can be invalid.
+     */
+    const MemoryLocation &getReturnValue(const CalleeId &calleeId) const;
+
 private:
     /**
      * Precomputes various useful mappings.
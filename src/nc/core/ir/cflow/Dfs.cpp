@@ -24,6 +24,8 @@
 
 #include "Dfs.h"
 
+#include <algorithm>
+
 #include <nc/common/Foreach.h>
 #include <nc/common/Range.h>
 #include <nc/common/Unreachable.h>
@@ -36,7 +38,9 @@ namespace core {
 namespace ir {
 namespace cflow {
 
-Dfs::Dfs(const cflow::Region *region) {
+Dfs::Dfs(const cflow::Region *region):
+    region_(region), hasHoles_(false), stale_(false)
+{
     assert(region != nullptr);
 
     preordering_.reserve(region->nodes().size());
@@ -56,12 +60,14 @@ void Dfs::visit(cflow::Node *node) {
     assert(find(node2color_, node) == WHITE);
 
     node2color_[node] = GRAY;
+    node2indices_[node].first = preordering_.size();
     preordering_.push_back(node);
 
     foreach (cflow::Edge *edge, node->outEdges()) {
         switch (find(node2color_, edge->head())) {
         case WHITE:
             edge2type_[edge] = FORWARD;
+            node2parent_[edge->head()] = node;
             visit(edge->head());
             break;
         case GRAY:
@@ -76,9 +82,108 @@ void Dfs::visit(cflow::Node *node) {
     }
 
     node2color_[node] = BLACK;
+    node2indices_[node].second = postordering_.size();
     postordering_.push_back(node);
 }
 
+void Dfs::collapse(Region *subregion) {
+    assert(subregion != nullptr);
+    assert(subregion->parent() == region_);
+
+    if (stale_) {
+        return;
+    }
+
+    /*
+     * Returns the node of the searched region containing the given node.
+     */
+    auto getTopNode = [this](Node *node) -> Node * {
+        while (node != nullptr && node->parent() != region_) {
+            node = node->parent();
+        }
+        return node;
+    };
+
+    /*
+     * The subregion could have been structured further after its insertion
+     * (e.g. a loop body), so look for the searched nodes inside nested regions.
+     */
+    Node *entry = subregion->entry();
+    while (!nc::contains(node2indices_, entry)) {
+        entry = entry->as<Region>()->entry();
+    }
+
+    std::vector<Node *> nodes;
+    std::vector<const Region *> queue(1, subregion);
+    while (!queue.empty()) {
+        const Region *region = queue.back();
+        queue.pop_back();
+
+        foreach (Node *node, region->nodes()) {
+            if (nc::contains(node2indices_, node)) {
+                nodes.push_back(node);
+            } else {
+                queue.push_back(node->as<Region>());
+            }
+        }
+    }
+
+    /*
+     * Every node but the entry must have been discovered from within the subregion.
+     */
+    foreach (Node *node, nodes) {
+        if (node != entry && getTopNode(nc::find(node2parent_, node)) != subregion) {
+            stale_ = true;
+            return;
+        }
+    }
+
+    /*
+     * Such a subregion is a subtree of the search tree. Contracting it
+     * gives a valid search tree and preserves the types of the edges
+     * between the remaining nodes.
+     */
+    auto indices = nc::find(node2indices_, entry);
+
+    foreach (Node *node, nodes) {
+        if (node != entry) {
+            auto nodeIndices = nc::find(node2indices_, node);
+            preordering_[nodeIndices.first] = nullptr;
+            postordering_[nodeIndices.second] = nullptr;
+            node2indices_.erase(node);
+            hasHoles_ = true;
+        }
+    }
+
+    preordering_[indices.first] = subregion;
+    postordering_[indices.second] = subregion;
+
+    node2indices_[subregion] = indices;
+    node2color_[subregion] = BLACK;
+    if (Node *parent = nc::find(node2parent_, entry)) {
+        node2parent_[subregion] = parent;
+    }
+}
+
+void Dfs::compact() {
+    if (!hasHoles_) {
+        return;
+    }
+
+    auto isNull = [](const Node *node) { return node == nullptr; };
+    preordering_.erase(std::remove_if(preordering_.begin(), preordering_.end(), isNull), preordering_.end());
+    postordering_.erase(std::remove_if(postordering_.begin(), postordering_.end(), isNull), postordering_.end());
+
+    for (std::size_t i = 0; i < preordering_.size(); ++i) {
+        node2indices_[preordering_[i]].first = i;
+    }
+    for (std::size_t i = 0; i < postordering_.size(); ++i) {
+        node2indices_[postordering_[i]].second = i;
+    }
+
+    hasHoles_ = false;
+}
+
 } // namespace cflow
 } // namespace ir
 } // namespace core
@@ -63,6 +63,9 @@ public:
     };
 
 private:
+    /** The region being searched. */
+    const Region *region_;
+
     /** List of region nodes in the order of discovery. */
     std::vector<Node *> preordering_;
 
@@ -75,6 +78,18 @@ private:
     /** Mapping from an edge to its type. */
     boost::unordered_map<const Edge *, EdgeType> edge2type_;
 
+    /** Mapping from a node to its parent in the depth-first search tree. */
+    boost::unordered_map<const Node *, Node *> node2parent_;
+
+    /** Mapping from a node to its indices in the preordering and postordering. */
+    boost::unordered_map<const Node *, std::pair<std::size_t, std::size_t>> node2indices_;
+
+    /** Whether the orderings contain nullptr entries left by collapse(). */
+    bool hasHoles_;
+
+    /** Whether the results are no longer valid for the region. */
+    bool stale_;
+
 public:
 
     /**
@@ -111,6 +126,33 @@ public:
      */
     EdgeType getEdgeType(const Edge *edge) const { return nc::find(edge2type_, edge, UNKNOWN); }
 
+    /**
+     * Updates the search results after the nodes of the subregion have been
+     * moved into it by the structural analysis. If the nodes of the subregion
+     * form a subtree of the depth-first search tree rooted at the subregion's
+     * entry, the subregion takes the place of its entry in the orderings,
+     * the other nodes are replaced by nullptr entries (until compact() is called),
+     * and the types of all remaining edges stay valid. Otherwise, the results
+     * are marked stale and the search must be redone.
+     *
+     * The orderings are not reallocated, so references to them stay valid.
+     *
+     * \param subregion Valid pointer to a subregion that has just been inserted
+     *                  into the searched region.
+     */
+    void collapse(Region *subregion);
+
+    /**
+     * Removes nullptr entries left by collapse() from the orderings.
+     */
+    void compact();
+
+    /**
+     * \return True if the results must be recomputed, because a collapsed
+     *         subregion did not form a subtree of the depth-first search tree.
+     */
+    bool stale() const { return stale_; }
+
 private:
 
     /**
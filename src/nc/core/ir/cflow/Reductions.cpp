@@ -0,0 +1,251 @@
+/* The file is part of Snowman decompiler. */
+/* See doc/licenses.asciidoc for the licensing information. */
+
+#include "Reductions.h"
+
+#include <algorithm>
+
+#include <nc/common/Foreach.h>
+
+#include <nc/core/arch/Instruction.h>
+#include <nc/core/ir/BasicBlock.h>
+#include <nc/core/ir/Function.h>
+#include <nc/core/ir/Jump.h>
+#include <nc/core/ir/Statements.h>
+#include <nc/core/ir/Terms.h>
+
+namespace nc {
+namespace core {
+namespace ir {
+namespace cflow {
+
+namespace {
+
+void getTerms(const Term *term, std::vector<const Term *> &result) {
+    result.push_back(term);
+
+    switch (term->kind()) {
+        case Term::DEREFERENCE:
+            getTerms(term->asDereference()->address(), result);
+            break;
+        case Term::UNARY_OPERATOR:
+            getTerms(term->asUnaryOperator()->operand(), result);
+            break;
+        case Term::BINARY_OPERATOR:
+            getTerms(term->asBinaryOperator()->left(), result);
+            getTerms(term->asBinaryOperator()->right(), result);
+            break;
+    }
+}
+
+/**
+ * \param statement Valid pointer to a statement.
+ *
+ * \return Terms of the statement in preorder.
+ */
+std::vector<const Term *> getTerms(const Statement *statement) {
+    std::vector<const Term *> result;
+
+    if (auto assignment = statement->asAssignment()) {
+        getTerms(assignment->left(), result);
+        getTerms(assignment->right(), result);
+    } else if (auto jump = statement->asJump()) {
+        if (jump->condition()) {
+            getTerms(jump->condition(), result);
+        }
+        if (jump->thenTarget().address()) {
+            getTerms(jump->thenTarget().address(), result);
+        }
+        if (jump->elseTarget().address()) {
+            getTerms(jump->elseTarget().address(), result);
+        }
+    } else if (auto call = statement->asCall()) {
+        getTerms(call->target(), result);
+    } else if (auto touch = statement->asTouch()) {
+        getTerms(touch->term(), result);
+    }
+
+    return result;
+}
+
+void save(QDataStream &out, const boost::optional<ByteAddr> &offset) {
+    out << static_cast<bool>(offset) << static_cast<qint64>(offset ? *offset : 0);
+}
+
+void load(QDataStream &in, boost::optional<ByteAddr> &offset) {
+    bool present;
+    qint64 value;
+    in >> present >> value;
+
+    if (present) {
+        offset = value;
+    } else {
+        offset = boost::none;
+    }
+}
+
+} // anonymous namespace
+
+void Reductions::save(QDataStream &out) const {
+    assert(complete());
+
+    out << static_cast<quint32>(list_.size());
+
+    foreach (const auto &reduction, list_) {
+        out << static_cast<qint32>(reduction.kind) << static_cast<quint32>(reduction.region)
+            << static_cast<qint32>(reduction.regionKind) << static_cast<qint64>(reduction.entry);
+
+        out << static_cast<quint32>(reduction.nodes.size());
+        foreach (ByteAddr node, reduction.nodes) {
+            out << static_cast<qint64>(node);
+        }
+
+        cflow::save(out, reduction.exitBasicBlock);
+
+        if (reduction.kind == Reduction::INSERT && reduction.regionKind == Region::SWITCH) {
+            out << static_cast<qint64>(reduction.switchNode)
+                << static_cast<qint64>(reduction.switchTerm.instruction)
+                << static_cast<quint32>(reduction.switchTerm.statement)
+                << static_cast<quint32>(reduction.switchTerm.term)
+                << static_cast<quint64>(reduction.jumpTableSize);
+            cflow::save(out, reduction.boundsCheckNode);
+            cflow::save(out, reduction.defaultBasicBlock);
+        }
+    }
+}
+
+bool Reductions::load(QDataStream &in) {
+    list_.clear();
+    complete_ = true;
+
+    quint32 count;
+    in >> count;
+
+    for (quint32 i = 0; i < count && in.status() == QDataStream::Ok; ++i) {
+        qint32 kind, regionKind;
+        quint32 region, nodeCount;
+        qint64 entry;
+
+        in >> kind >> region >> regionKind >> entry >> nodeCount;
+
+        if (in.status() != QDataStream::Ok ||
+            (kind != Reduction::INSERT && kind != Reduction::LOOP) ||
+            regionKind < Region::UNKNOWN || regionKind > Region::SWITCH ||
+            region > list_.size())
+        {
+            return false;
+        }
+
+        Reduction reduction(static_cast<Reduction::Kind>(kind), region, static_cast<Region::RegionKind>(regionKind));
+        reduction.entry = entry;
+
+        for (quint32 j = 0; j < nodeCount && in.status() == QDataStream::Ok; ++j) {
+            qint64 node;
+            in >> node;
+            reduction.nodes.push_back(node);
+        }
+
+        cflow::load(in, reduction.exitBasicBlock);
+
+        if (reduction.kind == Reduction::INSERT && reduction.regionKind == Region::SWITCH) {
+            qint64 switchNode, instruction;
+            quint32 statement, term;
+            quint64 jumpTableSize;
+
+            in >> switchNode >> instruction >> statement >> term >> jumpTableSize;
+
+            reduction.switchNode = switchNode;
+            reduction.switchTerm.instruction = instruction;
+            reduction.switchTerm.statement = statement;
+            reduction.switchTerm.term = term;
+            reduction.jumpTableSize = jumpTableSize;
+
+            cflow::load(in, reduction.boundsCheckNode);
+            cflow::load(in, reduction.defaultBasicBlock);
+        }
+
+        list_.push_back(std::move(reduction));
+    }
+
+    return in.status() == QDataStream::Ok;
+}
+
+boost::optional<ByteAddr> Reductions::getOffset(const BasicBlock *basicBlock) {
+    assert(basicBlock != nullptr);
+    assert(basicBlock->function() != nullptr);
+
+    auto entry = basicBlock->function()->entry();
+    if (!basicBlock->address() || !entry || !entry->address()) {
+        return boost::none;
+    }
+
+    return *basicBlock->address() - *entry->address();
+}
+
+boost::optional<Reductions::TermPosition> Reductions::getPosition(const Term *term) {
+    assert(term != nullptr);
+
+    auto statement = term->statement();
+    if (!statement || !statement->instruction() || !statement->basicBlock()) {
+        return boost::none;
+    }
+
+    auto function = statement->basicBlock()->function();
+    if (!function || !function->entry() || !function->entry()->address()) {
+        return boost::none;
+    }
+
+    TermPosition result;
+    result.instruction = statement->instruction()->addr() - *function->entry()->address();
+
+    auto terms = getTerms(statement);
+    auto i = std::find(terms.begin(), terms.end(), term);
+    if (i == terms.end()) {
+        return boost::none;
+    }
+    result.term = i - terms.begin();
+
+    foreach (const BasicBlock *basicBlock, function->basicBlocks()) {
+        foreach (const Statement *other, basicBlock->statements()) {
+            if (other == statement) {
+                return result;
+            }
+            if (other->instruction() == statement->instruction()) {
+                ++result.statement;
+            }
+        }
+    }
+
+    return boost::none;
+}
+
+const Term *Reductions::getTerm(const Function *function, const TermPosition &position) {
+    assert(function != nullptr);
+
+    if (!function->entry() || !function->entry()->address()) {
+        return nullptr;
+    }
+
+    ByteAddr addr = *function->entry()->address() + position.instruction;
+    std::size_t statementNumber = 0;
+
+    foreach (const BasicBlock *basicBlock, function->basicBlocks()) {
+        foreach (const Statement *statement, basicBlock->statements()) {
+            if (statement->instruction() && statement->instruction()->addr() == addr) {
+                if (statementNumber++ == position.statement) {
+                    auto terms = getTerms(statement);
+                    return position.term < terms.size() ? terms[position.term] : nullptr;
+                }
+            }
+        }
+    }
+
+    return nullptr;
+}
+
+} // namespace cflow
+} // namespace ir
+} // namespace core
+} // namespace nc
+
+/* vim:set et sts=4 sw=4: */
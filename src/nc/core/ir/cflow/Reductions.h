@@ -0,0 +1,165 @@
+/* The file is part of Snowman decompiler. */
+/* See doc/licenses.asciidoc for the licensing information. */
+
+#pragma once
+
+#include <nc/config.h>
+
+#include <vector>
+
+#include <QDataStream>
+
+#include <boost/optional.hpp>
+
+#include <nc/common/Types.h>
+
+#include "Region.h"
+
+namespace nc {
+namespace core {
+namespace ir {
+
+class BasicBlock;
+class Function;
+class Term;
+
+namespace cflow {
+
+/**
+ * Reductions performed by the structural analysis of a function, in the
+ * order of their application.
+ *
+ * Basic blocks are identified by their offsets from the entry of the
+ * function, and terms by their positions in the instructions of the
+ * function. Therefore, the reductions can be replayed on the graph of
+ * an identical function located at a different address.
+ *
+ * \see StructureAnalyzer::setRecording()
+ * \see StructureAnalyzer::replay()
+ */
+class Reductions {
+public:
+    /**
+     * Position of a term in the instructions of a function.
+     */
+    struct TermPosition {
+        ByteAddr instruction; ///< Offset of the instruction from the function's entry.
+        std::size_t statement; ///< Number of the statement among the statements generated for the instruction.
+        std::size_t term; ///< Number of the term in the preorder traversal of the statement's terms.
+
+        TermPosition(): instruction(0), statement(0), term(0) {}
+    };
+
+    /**
+     * A single reduction.
+     */
+    struct Reduction {
+        enum Kind {
+            INSERT, ///< A new region was inserted into a region.
+            LOOP    ///< Kind, condition node and exit of a loop region were set.
+        };
+
+        Kind kind; ///< Kind of the reduction.
+
+        /**
+         * Number of the region the new region was inserted into, or of the loop region:
+         * zero for the root region, i for the region inserted by the i-th INSERT reduction.
+         */
+        std::size_t region;
+
+        Region::RegionKind regionKind; ///< Kind of the new region or of the loop.
+        ByteAddr entry; ///< Entry basic block of the entry node of the new region, or of the condition node of the loop.
+        std::vector<ByteAddr> nodes; ///< Entry basic blocks of the nodes of the new region, in their order.
+        boost::optional<ByteAddr> exitBasicBlock; ///< Exit basic block of the region.
+
+        ByteAddr switchNode; ///< Basic block of the switch node of a switch.
+        TermPosition switchTerm; ///< Position of the switch term of a switch.
+        std::size_t jumpTableSize; ///< Number of entries in the jump table of a switch.
+        boost::optional<ByteAddr> boundsCheckNode; ///< Basic block of the bounds check node of a switch.
+        boost::optional<ByteAddr> defaultBasicBlock; ///< Default basic block of a switch.
+
+        Reduction(Kind kind, std::size_t region, Region::RegionKind regionKind):
+            kind(kind), region(region), regionKind(regionKind), entry(0), switchNode(0), jumpTableSize(0)
+        {}
+    };
+
+private:
+    /** Reductions in the order of their application. */
+    std::vector<Reduction> list_;
+
+    /** False if some reduction could not be recorded. */
+    bool complete_;
+
+public:
+    /**
+     * Constructor.
+     */
+    Reductions(): complete_(true) {}
+
+    /**
+     * \return Reductions in the order of their application.
+     */
+    std::vector<Reduction> &list() { return list_; }
+
+    /**
+     * \return Reductions in the order of their application.
+     */
+    const std::vector<Reduction> &list() const { return list_; }
+
+    /**
+     * \return True if all the reductions of the analysis have been recorded.
+     */
+    bool complete() const { return complete_; }
+
+    /**
+     * Marks the recording as incomplete, because a reduction could not be expressed.
+     */
+    void setIncomplete() { complete_ = false; }
+
+    /**
+     * Writes the reductions to a stream.
+     *
+     * \param out Stream.
+     */
+    void save(QDataStream &out) const;
+
+    /**
+     * Reads the reductions from a stream.
+     *
+     * \param in Stream.
+     *
+     * \return True on success, false if the data are malformed.
+     */
+    bool load(QDataStream &in);
+
+    /**
+     * \param basicBlock Valid pointer to a basic block of a function.
+     *
+     * \return Offset of the basic block from the entry of its function,
+     *         or boost::none if any of them has no address.
+     */
+    static boost::optional<ByteAddr> getOffset(const BasicBlock *basicBlock);
+
+    /**
+     * \param term Valid pointer to a term of a function.
+     *
+     * \return Position of the term, or boost::none if its statement
+     *         was not generated for an instruction.
+     */
+    static boost::optional<TermPosition> getPosition(const Term *term);
+
+    /**
+     * \param function Valid pointer to a function.
+     * \param position Position of a term.
+     *
+     * \return Pointer to the term at the given position. Can be nullptr.
+     */
+    static const Term *getTerm(const Function *function, const TermPosition &position);
+};
+
+} // namespace cflow
+} // namespace ir
+} // namespace core
+} // namespace nc
+
+/* vim:set et sts=4 sw=4: */
@@ -34,6 +34,7 @@
 #include <nc/common/make_unique.h>
 
 #include <nc/core/ir/BasicBlock.h>
+#include <nc/core/ir/Function.h>
 #include <nc/core/ir/Jump.h>
 #include <nc/core/ir/dflow/Utils.h>
 #include <nc/core/ir/misc/ArrayAccess.h>
@@ -45,6 +46,7 @@
 #include "Edge.h"
 #include "Graph.h"
 #include "LoopExplorer.h"
+#include "Reductions.h"
 #include "Switch.h"
 
 namespace nc {
@@ -53,10 +55,145 @@ namespace ir {
 namespace cflow {
 
 void StructureAnalyzer::analyze() {
+    if (recording_) {
+        region2number_.clear();
+        region2number_[graph_.root()] = 0;
+    }
+
     analyze(graph_.root());
 }
 
+bool StructureAnalyzer::replay(const Reductions &reductions) {
+    const Node *rootEntry = graph_.root()->entry();
+    if (!rootEntry || !rootEntry->getEntryBasicBlock()) {
+        return reductions.list().empty();
+    }
+
+    const Function *function = rootEntry->getEntryBasicBlock()->function();
+
+    boost::unordered_map<ByteAddr, const BasicBlock *> offset2basicBlock;
+    foreach (const BasicBlock *basicBlock, function->basicBlocks()) {
+        if (auto offset = Reductions::getOffset(basicBlock)) {
+            offset2basicBlock[*offset] = basicBlock;
+        }
+    }
+
+    /* Root region and the regions inserted so far, in the order of insertion. */
+    std::vector<Region *> regions(1, graph_.root());
+
+    foreach (const auto &reduction, reductions.list()) {
+        if (reduction.region >= regions.size()) {
+            return false;
+        }
+        Region *region = regions[reduction.region];
+
+        /* Nodes of a region have distinct entry basic blocks. */
+        auto getNode = [region](ByteAddr offset) -> Node * {
+            foreach (Node *node, region->nodes()) {
+                auto nodeOffset = getOffset(node);
+                if (nodeOffset && *nodeOffset == offset) {
+                    return node;
+                }
+            }
+            return nullptr;
+        };
+
+        const BasicBlock *exitBasicBlock = nullptr;
+        if (reduction.exitBasicBlock) {
+            exitBasicBlock = nc::find(offset2basicBlock, *reduction.exitBasicBlock);
+            if (!exitBasicBlock) {
+                return false;
+            }
+        }
+
+        if (reduction.kind == Reductions::Reduction::LOOP) {
+            Node *condition = getNode(reduction.entry);
+            if (!condition) {
+                return false;
+            }
+
+            region->setRegionKind(reduction.regionKind);
+            region->setLoopCondition(condition);
+            region->setExitBasicBlock(exitBasicBlock);
+            continue;
+        }
+
+        std::unique_ptr<Region> subregion;
+
+        if (reduction.regionKind == Region::SWITCH) {
+            Node *switchNode = getNode(reduction.switchNode);
+            const Term *switchTerm = Reductions::getTerm(function, reduction.switchTerm);
+            if (!switchNode || !switchNode->as<BasicNode>() || !switchTerm) {
+                return false;
+            }
+
+            auto witch = std::make_unique<Switch>(switchNode->as<BasicNode>(), switchTerm, reduction.jumpTableSize);
+
+            if (reduction.boundsCheckNode) {
+                Node *boundsCheckNode = getNode(*reduction.boundsCheckNode);
+                if (!boundsCheckNode || !boundsCheckNode->as<BasicNode>()) {
+                    return false;
+                }
+                witch->setBoundsCheckNode(boundsCheckNode->as<BasicNode>());
+            }
+
+            if (reduction.defaultBasicBlock) {
+                const BasicBlock *defaultBasicBlock = nc::find(offset2basicBlock, *reduction.defaultBasicBlock);
+                if (!defaultBasicBlock) {
+                    return false;
+                }
+                witch->setDefaultBasicBlock(defaultBasicBlock);
+            }
+
+            subregion = std::move(witch);
+        } else {
+            subregion = std::make_unique<Region>(reduction.regionKind);
+        }
+
+        Node *entry = getNode(reduction.entry);
+        if (!entry) {
+            return false;
+        }
+        subregion->setEntry(entry);
+
+        foreach (ByteAddr offset, reduction.nodes) {
+            Node *node = getNode(offset);
+            if (!node || nc::contains(subregion->nodes(), node)) {
+                return false;
+            }
+            subregion->nodes().push_back(node);
+        }
+
+        subregion->setExitBasicBlock(exitBasicBlock);
+
+        Region *inserted = insertSubregion(region, std::move(subregion));
+        if (!inserted) {
+            return false;
+        }
+        regions.push_back(inserted);
+
+        if (reduction.regionKind == Region::LOOP) {
+            /* Remove 'continue' edges, as reduceCyclic() does. */
+            std::vector<Edge *> continueEdges = entry->inEdges();
+            foreach (Edge *edge, continueEdges) {
+                edge->setTail(nullptr);
+                edge->setHead(nullptr);
+            }
+        }
+    }
+
+    return true;
+}
+
 void StructureAnalyzer::analyze(Region *region) {
+    if (incremental_) {
+        analyzeIncrementally(region);
+    } else {
+        analyzeRestarting(region);
+    }
+}
+
+void StructureAnalyzer::analyzeRestarting(Region *region) {
     bool changed;
 
     do {
@@ -122,6 +259,70 @@ void StructureAnalyzer::analyze(Region *region) {
     } while (changed);
 }
 
+void StructureAnalyzer::analyzeIncrementally(Region *region) {
+    /*
+     * Classify edges, sort nodes topologically.
+     */
+    auto dfs = std::make_unique<Dfs>(region);
+
+    /*
+     * Various kinds of regions, in the order of reduction priority.
+     */
+    const std::function<bool(Node *)> reductions[] = {
+        [this](Node *node) { return reduceCompoundCondition(node); },
+        [this, &dfs](Node *node) { return reduceCyclic(node, *dfs); },
+        [this](Node *node) { return reduceBlock(node); },
+        [this](Node *node) { return reduceConditional(node); },
+        [this](Node *node) { return reduceSwitch(node) || reduceHopelessConditional(node); }
+    };
+
+    bool changed;
+    do {
+        changed = false;
+
+        foreach (const auto &reduce, reductions) {
+            if (reduceAll(region, *dfs, reduce)) {
+                changed = true;
+                break;
+            }
+        }
+
+        if (dfs->stale()) {
+            dfs = std::make_unique<Dfs>(region);
+        } else {
+            dfs->compact();
+        }
+    } while (changed);
+}
+
+bool StructureAnalyzer::reduceAll(Region *region, Dfs &dfs, const std::function<bool(Node *)> &reduce) {
+    bool changed = false;
+
+    /* collapse() never reallocates the ordering, it only overwrites its entries. */
+    const auto &postordering = dfs.postordering();
+
+    for (std::size_t i = 0, size = postordering.size(); i < size && !dfs.stale(); ++i) {
+        Node *node = postordering[i];
+
+        /* Skip nodes reduced earlier during this pass. */
+        if (node == nullptr || node->parent() != region) {
+            continue;
+        }
+
+        if (reduce(node)) {
+            changed = true;
+
+            Node *subregion = node;
+            while (subregion->parent() != region) {
+                subregion = subregion->parent();
+            }
+            dfs.collapse(subregion->as<Region>());
+        }
+    }
+
+    return changed;
+}
+
 bool StructureAnalyzer::reduceBlock(Node *entry) {
     Node *uniquePredecessor = entry->uniquePredecessor();
 
@@ -353,6 +554,7 @@ bool StructureAnalyzer::reduceCyclic(Node *entry, const Dfs &dfs) {
             loop->setRegionKind(description.kind);
             loop->setLoopCondition(description.condition);
             loop->setExitBasicBlock(description.exitNode->getEntryBasicBlock());
+            recordLoop(loop);
             break;
         }
     }
@@ -638,7 +840,103 @@ Region *StructureAnalyzer::insertSubregion(Region *region, std::unique_ptr<Regio
         edge->setHead(nullptr);
     }
 
-    return graph_.addNode(std::move(subregion));
+    Region *result = graph_.addNode(std::move(subregion));
+    recordInsertion(region, result);
+
+    return result;
+}
+
+void StructureAnalyzer::recordInsertion(const Region *region, const Region *subregion) {
+    if (!recording_ || !recording_->complete()) {
+        return;
+    }
+
+    auto number = region2number_.find(region);
+    assert(number != region2number_.end());
+
+    Reductions::Reduction reduction(Reductions::Reduction::INSERT, number->second, static_cast<Region::RegionKind>(subregion->regionKind()));
+
+    bool complete = true;
+    auto getOffset = [&complete](const Node *node) -> ByteAddr {
+        auto result = StructureAnalyzer::getOffset(node);
+        complete = complete && result;
+        return result ? *result : 0;
+    };
+    auto getBasicBlockOffset = [&complete](const BasicBlock *basicBlock) -> boost::optional<ByteAddr> {
+        if (!basicBlock) {
+            return boost::none;
+        }
+        auto result = Reductions::getOffset(basicBlock);
+        complete = complete && result;
+        return result;
+    };
+
+    reduction.entry = getOffset(subregion->entry());
+    foreach (const Node *node, subregion->nodes()) {
+        reduction.nodes.push_back(getOffset(node));
+    }
+    reduction.exitBasicBlock = getBasicBlockOffset(subregion->exitBasicBlock());
+
+    if (auto witch = subregion->as<Switch>()) {
+        reduction.switchNode = getOffset(witch->switchNode());
+        if (auto position = Reductions::getPosition(witch->switchTerm())) {
+            reduction.switchTerm = *position;
+        } else {
+            complete = false;
+        }
+        reduction.jumpTableSize = witch->jumpTableSize();
+        if (witch->boundsCheckNode()) {
+            reduction.boundsCheckNode = getOffset(witch->boundsCheckNode());
+        }
+        reduction.defaultBasicBlock = getBasicBlockOffset(witch->defaultBasicBlock());
+    }
+
+    if (!complete) {
+        recording_->setIncomplete();
+        return;
+    }
+
+    std::size_t subregionNumber = region2number_.size();
+    region2number_[subregion] = subregionNumber;
+
+    recording_->list().push_back(std::move(reduction));
+}
+
+void StructureAnalyzer::recordLoop(const Region *loop) {
+    if (!recording_ || !recording_->complete()) {
+        return;
+    }
+
+    auto number = region2number_.find(loop);
+    assert(number != region2number_.end());
+
+    Reductions::Reduction reduction(Reductions::Reduction::LOOP, number->second, static_cast<Region::RegionKind>(loop->regionKind()));
+
+    auto condition = getOffset(loop->loopCondition());
+    if (!condition) {
+        recording_->setIncomplete();
+        return;
+    }
+    reduction.entry = *condition;
+
+    if (loop->exitBasicBlock()) {
+        reduction.exitBasicBlock = Reductions::getOffset(loop->exitBasicBlock());
+        if (!reduction.exitBasicBlock) {
+            recording_->setIncomplete();
+            return;
+        }
+    }
+
+    recording_->list().push_back(std::move(reduction));
+}
+
+boost::optional<ByteAddr> StructureAnalyzer::getOffset(const Node *node) {
+    assert(node != nullptr);
+
+    if (auto basicBlock = node->getEntryBasicBlock()) {
+        return Reductions::getOffset(basicBlock);
+    }
+    return boost::none;
 }
 
 } // namespace cflow
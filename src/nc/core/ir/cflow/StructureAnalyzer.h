@@ -25,8 +25,14 @@
 
 #include <nc/config.h>
 
+#include <functional>
 #include <memory>
 
+#include <boost/optional.hpp>
+#include <boost/unordered_map.hpp>
+
+#include <nc/common/Types.h>
+
 namespace nc {
 namespace core {
 namespace ir {
@@ -40,6 +46,7 @@ namespace cflow {
 class Dfs;
 class Graph;
 class Node;
+class Reductions;
 class Region;
 
 /**
@@ -52,22 +59,55 @@ class StructureAnalyzer {
     /** Dataflow information. */
     const dflow::Dataflow &dataflow_;
 
+    /** Whether to apply all reductions of a kind in a single pass. */
+    bool incremental_;
+
+    /** Recording of the reductions being performed. Can be nullptr. */
+    Reductions *recording_;
+
+    /** Numbers of the regions in the recording. */
+    boost::unordered_map<const Region *, std::size_t> region2number_;
+
 public:
     /**
      * Class constructor.
      *
      * \param graph Graph to analyze.
      * \param dataflow Dataflow information.
+     * \param incremental If true, all applicable reductions of a kind are
+     *                    performed in one postorder pass, and the depth-first
+     *                    search results are only updated locally around the
+     *                    reduced regions. Otherwise, the search is redone and
+     *                    the analysis restarted after every single reduction.
+     *                    The order of reductions differs between the two modes,
+     *                    so the resulting regions can differ, too.
      */
-    StructureAnalyzer(Graph &graph, const dflow::Dataflow &dataflow):
-        graph_(graph), dataflow_(dataflow)
+    StructureAnalyzer(Graph &graph, const dflow::Dataflow &dataflow, bool incremental = false):
+        graph_(graph), dataflow_(dataflow), incremental_(incremental), recording_(nullptr)
     {}
 
+    /**
+     * Sets the object recording the reductions performed by analyze().
+     *
+     * \param recording Pointer to an empty recording. Can be nullptr.
+     */
+    void setRecording(Reductions *recording) { recording_ = recording; }
+
     /**
      * Performs structural analysis on the graph.
      */
     void analyze();
 
+    /**
+     * Performs the given reductions on the graph instead of analyzing it.
+     *
+     * \param reductions Reductions recorded by the analysis of an identical function.
+     *
+     * \return True on success. False if the reductions do not match the graph,
+     *         in which case the graph is left partially reduced.
+     */
+    bool replay(const Reductions &reductions);
+
 private:
     /**
      * Runs structural analysis in the region.
@@ -76,6 +116,37 @@ private:
      */
     void analyze(Region *region);
 
+    /**
+     * Runs structural analysis in the region, restarting it from scratch
+     * after every reduction.
+     *
+     * \param[in] region Valid pointer to a region.
+     */
+    void analyzeRestarting(Region *region);
+
+    /**
+     * Runs structural analysis in the region, performing all applicable
+     * reductions of a kind in one pass and updating the depth-first search
+     * results locally.
+     *
+     * \param[in] region Valid pointer to a region.
+     */
+    void analyzeIncrementally(Region *region);
+
+    /**
+     * Tries to apply the reduction to every node of the region, in postorder.
+     * Nodes reduced during the pass are collapsed in the depth-first search results.
+     * The pass stops early if the search results become stale.
+     *
+     * \param[in] region Valid pointer to the region.
+     * \param dfs Depth-first search results for the region.
+     * \param reduce Reduction to try. Must return true if it reduced a region
+     *               with the given entry node.
+     *
+     * \return True if at least one region was reduced.
+     */
+    bool reduceAll(Region *region, Dfs &dfs, const std::function<bool(Node *)> &reduce);
+
     /**
      * Tries to reduce block region ending in the node.
      *
@@ -150,6 +221,28 @@ private:
      * \return Pointer to the subregion on success, nullptr on failure.
      */
     Region *insertSubregion(Region *region, std::unique_ptr<Region> subregion);
+
+    /**
+     * Records the insertion of a subregion, if there is a recording.
+     *
+     * \param region Valid pointer to the region.
+     * \param subregion Valid pointer to the subregion that has been inserted into it.
+     */
+    void recordInsertion(const Region *region, const Region *subregion);
+
+    /**
+     * Records the kind, the condition node, and the exit of a loop, if there is a recording.
+     *
+     * \param loop Valid pointer to the loop region.
+     */
+    void recordLoop(const Region *loop);
+
+    /**
+     * \param node Valid pointer to a node.
+     *
+     * \return Offset of the node's entry basic block from the function's entry, if known.
+     */
+    static boost::optional<ByteAddr> getOffset(const Node *node);
 };
 
 } // namespace cflow
@@ -24,8 +24,11 @@
 
 #include "CodeGenerator.h"
 
+#include <algorithm>
+
 #include <nc/common/CancellationToken.h>
 #include <nc/common/Foreach.h>
+#include <nc/common/Parallel.h>
 #include <nc/common/Range.h>
 #include <nc/common/make_unique.h>
 
@@ -33,6 +36,7 @@
 #include <nc/core/image/Image.h>
 #include <nc/core/image/Reader.h>
 #include <nc/core/image/Relocation.h>
+#include <nc/core/ir/BasicBlock.h>
 #include <nc/core/ir/Function.h>
 #include <nc/core/ir/Functions.h>
 #include <nc/core/ir/calling/Hooks.h>
@@ -41,11 +45,13 @@
 #include <nc/core/ir/types/Types.h>
 #include <nc/core/ir/vars/Variable.h>
 #include <nc/core/likec/FunctionDefinition.h>
+#include <nc/core/likec/FunctionIdentifier.h>
 #include <nc/core/likec/IntegerConstant.h>
 #include <nc/core/likec/StructType.h>
 #include <nc/core/likec/StructTypeDeclaration.h>
 #include <nc/core/likec/Tree.h>
 #include <nc/core/likec/Typecast.h>
+#include <nc/core/likec/VariableIdentifier.h>
 
 #include "DefinitionGenerator.h"
 #include "NameGenerator.h"
@@ -56,16 +62,366 @@ namespace ir {
 namespace cgen {
 
 void CodeGenerator::makeCompilationUnit() {
+    makeCompilationUnit(PrepareCallback(), DefinitionCallback());
+}
+
+bool CodeGenerator::isSelected(const Function *function) const {
+    assert(function != nullptr);
+
+    if (selectedFunctions_.empty()) {
+        return true;
+    }
+    return function->entry() && function->entry()->address() &&
+        nc::contains(selectedFunctions_, *function->entry()->address());
+}
+
+namespace {
+
+/**
+ * Number of functions whose definitions are generated in parallel before
+ * being merged into the compilation unit.
+ */
+const std::size_t FUNCTIONS_PER_BATCH = 256;
+
+/**
+ * Redirects the references in the subtree of a node to the replaced declarations.
+ *
+ * \param node Valid pointer to a node.
+ * \param functions Mapping from replaced function declarations to their replacements.
+ * \param variables Mapping from replaced variable declarations to their replacements.
+ */
+void relink(likec::TreeNode *node,
+    const boost::unordered_map<const likec::FunctionDeclaration *, likec::FunctionDeclaration *> &functions,
+    const boost::unordered_map<const likec::VariableDeclaration *, likec::VariableDeclaration *> &variables)
+{
+    if (auto expression = node->as<likec::Expression>()) {
+        if (auto identifier = expression->as<likec::FunctionIdentifier>()) {
+            if (auto declaration = nc::find(functions, identifier->declaration())) {
+                identifier->setDeclaration(declaration);
+            }
+        } else if (auto identifier = expression->as<likec::VariableIdentifier>()) {
+            if (auto declaration = nc::find(variables, identifier->declaration())) {
+                identifier->setDeclaration(declaration);
+            }
+        }
+    }
+
+    node->callOnChildren([&](likec::TreeNode *child) {
+        relink(child, functions, variables);
+    });
+}
+
+} // anonymous namespace
+
+/**
+ * Everything a function definition generated in parallel has added to the program.
+ *
+ * While a definition is generated in parallel, the declaration maps of
+ * CodeGenerator are only read: the definitions merged so far are visible,
+ * and the declarations created anew are kept here.
+ */
+struct CodeGenerator::Staging {
+    /**
+     * Creation of a top-level declaration of a struct type, global variable, or function.
+     * Exactly one of the pairs of pointers is not null.
+     */
+    struct Creation {
+        const types::Type *typeTraits; ///< Traits of the struct type.
+        likec::StructTypeDeclaration *structTypeDeclaration; ///< Declaration of the struct type.
+        const vars::Variable *variable; ///< Global variable.
+        likec::VariableDeclaration *variableDeclaration; ///< Declaration of the global variable.
+        const calling::FunctionSignature *signature; ///< Signature of the function.
+        likec::FunctionDeclaration *functionDeclaration; ///< Declaration of the function.
+        bool nested; ///< True if other declarations were created while creating this one.
+
+        Creation():
+            typeTraits(nullptr), structTypeDeclaration(nullptr), variable(nullptr), variableDeclaration(nullptr),
+            signature(nullptr), functionDeclaration(nullptr), nested(false)
+        {}
+    };
+
+    /** Function to generate the definition of. */
+    const Function *function;
+
+    /** Generated definition. */
+    std::unique_ptr<likec::FunctionDefinition> definition;
+
+    /** Created top-level declarations, in the order of their addition. */
+    std::vector<std::unique_ptr<likec::Declaration>> declarations;
+
+    /** Creations of the declarations, in the order of their beginning. */
+    std::vector<Creation> creations;
+
+    /** Indices of the creations in progress. */
+    std::vector<std::size_t> creationStack;
+
+    /** Types being translated to LikeC. */
+    std::vector<const ir::types::Type *> typeCreationStack;
+
+    /** Structural types created for IR types. */
+    boost::unordered_map<const ir::types::Type *, const likec::StructType *> traits2structType;
+
+    /** Created declarations of global variables. */
+    boost::unordered_map<const vars::Variable *, likec::VariableDeclaration *> variableDeclarations;
+
+    /** Created declarations of functions. */
+    boost::unordered_map<const calling::FunctionSignature *, likec::FunctionDeclaration *> signature2declaration;
+
+    explicit Staging(const Function *function): function(function) {}
+
+    /**
+     * Starts the creation of a declaration.
+     *
+     * \return Index of the creation.
+     */
+    std::size_t beginCreation() {
+        if (!creationStack.empty()) {
+            creations[creationStack.back()].nested = true;
+        }
+        creations.push_back(Creation());
+        creationStack.push_back(creations.size() - 1);
+        return creations.size() - 1;
+    }
+
+    /**
+     * Finishes the creation of a declaration started last.
+     *
+     * \return Reference to the creation.
+     */
+    Creation &endCreation() {
+        assert(!creationStack.empty());
+        auto &result = creations[creationStack.back()];
+        creationStack.pop_back();
+        return result;
+    }
+};
+
+CodeGenerator::Staging *&CodeGenerator::currentStaging() {
+    static NC_THREAD_LOCAL Staging *staging = nullptr;
+    return staging;
+}
+
+void CodeGenerator::makeCompilationUnit(const PrepareCallback &prepare, const DefinitionCallback &callback) {
     tree().setPointerSize(image().platform().architecture()->bitness());
     tree().setIntSize(image().platform().intSize());
     tree().setRoot(std::make_unique<likec::CompilationUnit>());
 
+    std::vector<const Function *> selected;
     foreach (const Function *function, functions().list()) {
-        makeFunctionDefinition(function);
-        cancellationToken().poll();
+        if (isSelected(function)) {
+            selected.push_back(function);
+        }
+    }
+
+    std::unique_ptr<DefinitionCache> definitionCache;
+    if (cache()) {
+        definitionCache = std::make_unique<DefinitionCache>(*this, *cache());
+    }
+
+    /* Number of top-level declarations already passed to the callback. */
+    std::size_t done = 0;
+
+    if (threadCount_ > 1 && !definitionCache) {
+        makeFunctionDefinitions(selected, prepare, callback, done);
+    } else {
+        foreach (const Function *function, selected) {
+            if (prepare) {
+                prepare(function);
+            }
+            if (definitionCache) {
+                definitionCache->makeFunctionDefinition(function);
+            } else {
+                makeFunctionDefinition(function);
+            }
+            cancellationToken().poll();
+
+            if (callback) {
+                passDeclarations(function, callback, definitionCache.get(), done);
+            }
+        }
+    }
+
+    if (!callback) {
+        tree().rewriteRoot();
+
+        if (definitionCache) {
+            definitionCache->storeGenerated();
+        }
+    }
+}
+
+void CodeGenerator::makeFunctionDefinitions(const std::vector<const Function *> &functions,
+    const PrepareCallback &prepare, const DefinitionCallback &callback, std::size_t &done)
+{
+    /*
+     * Struct types of the dropped stagings. The tree has interned
+     * pointer and array types referring to them by address.
+     */
+    std::vector<std::unique_ptr<likec::Declaration>> dropped;
+
+    for (std::size_t begin = 0; begin < functions.size(); begin += FUNCTIONS_PER_BATCH) {
+        std::size_t end = std::min(functions.size(), begin + FUNCTIONS_PER_BATCH);
+
+        std::vector<std::unique_ptr<Staging>> stagings;
+        stagings.reserve(end - begin);
+
+        for (std::size_t i = begin; i < end; ++i) {
+            if (prepare) {
+                prepare(functions[i]);
+            }
+            stagings.push_back(std::make_unique<Staging>(functions[i]));
+        }
+
+        parallelFor(stagings.size(), threadCount_, [&](std::size_t index) {
+            Staging &staging = *stagings[index];
+
+            currentStaging() = &staging;
+            try {
+                DefinitionGenerator generator(*this, staging.function, cancellationToken());
+                staging.definition = generator.createDefinition();
+            } catch (...) {
+                currentStaging() = nullptr;
+                throw;
+            }
+            currentStaging() = nullptr;
+
+            cancellationToken().poll();
+        });
+
+        for (std::size_t index = 0; index < stagings.size(); ++index) {
+            const Function *function = functions[begin + index];
+
+            if (!mergeStaging(*stagings[index])) {
+                foreach (auto &declaration, stagings[index]->declarations) {
+                    if (declaration->is<likec::StructTypeDeclaration>()) {
+                        dropped.push_back(std::move(declaration));
+                    }
+                }
+                makeFunctionDefinition(function);
+            }
+            stagings[index].reset();
+
+            if (callback) {
+                passDeclarations(function, callback, nullptr, done);
+            }
+        }
+    }
+}
+
+bool CodeGenerator::mergeStaging(Staging &staging) {
+    assert(staging.definition);
+    assert(staging.creationStack.empty());
+
+    /*
+     * A declaration created by a previously merged definition would not have
+     * been created by makeFunctionDefinition(): the existing one would have
+     * been used instead. This can be emulated by redirecting the references,
+     * unless the creation of the dropped declaration has caused the creation
+     * of other ones, or the dropped declaration is a struct type, whose members
+     * could have been translated differently.
+     */
+    boost::unordered_map<const likec::FunctionDeclaration *, likec::FunctionDeclaration *> functions;
+    boost::unordered_map<const likec::VariableDeclaration *, likec::VariableDeclaration *> variables;
+    boost::unordered_set<const likec::Declaration *> droppedDeclarations;
+
+    foreach (const auto &creation, staging.creations) {
+        if (creation.typeTraits) {
+            if (nc::contains(traits2structType_, creation.typeTraits)) {
+                return false;
+            }
+        } else if (creation.variable) {
+            if (auto existing = nc::find(variableDeclarations_, creation.variable)) {
+                if (creation.nested) {
+                    return false;
+                }
+                variables[creation.variableDeclaration] = existing;
+                droppedDeclarations.insert(creation.variableDeclaration);
+            }
+        } else {
+            assert(creation.signature != nullptr);
+            if (auto existing = nc::find(signature2declaration_, creation.signature)) {
+                if (creation.nested) {
+                    return false;
+                }
+                functions[creation.functionDeclaration] = existing;
+                droppedDeclarations.insert(creation.functionDeclaration);
+            }
+        }
+    }
+
+    /* Recursive calls refer to the first declaration of the function. */
+    auto signature = signatures().getSignature(staging.function).get();
+    if (auto existing = nc::find(signature2declaration_, signature)) {
+        functions[staging.definition.get()] = existing;
     }
 
-    tree().rewriteRoot();
+    foreach (const auto &creation, staging.creations) {
+        if (creation.typeTraits) {
+            creation.structTypeDeclaration->setIdentifier(QString("s%1").arg(traits2structType_.size()));
+            traits2structType_[creation.typeTraits] = creation.structTypeDeclaration->type();
+        } else if (creation.variable) {
+            if (!nc::contains(droppedDeclarations, creation.variableDeclaration)) {
+                variableDeclarations_[creation.variable] = creation.variableDeclaration;
+            }
+        } else {
+            if (!nc::contains(droppedDeclarations, creation.functionDeclaration)) {
+                setFunctionDeclaration(creation.signature, creation.functionDeclaration);
+            }
+        }
+    }
+
+    foreach (auto &declaration, staging.declarations) {
+        if (!nc::contains(droppedDeclarations, declaration.get())) {
+            if (!functions.empty() || !variables.empty()) {
+                relink(declaration.get(), functions, variables);
+            }
+            tree().root()->addDeclaration(std::move(declaration));
+        }
+    }
+
+    if (!functions.empty() || !variables.empty()) {
+        relink(staging.definition.get(), functions, variables);
+    }
+    setFunctionDeclaration(signature, staging.definition.get());
+    tree().root()->addDeclaration(std::move(staging.definition));
+
+    return true;
+}
+
+void CodeGenerator::passDeclarations(const Function *function, const DefinitionCallback &callback,
+    DefinitionCache *definitionCache, std::size_t &done)
+{
+    tree().rewriteDeclarations(done);
+
+    if (definitionCache) {
+        definitionCache->storeGenerated();
+    }
+
+    auto &declarations = tree().root()->declarations();
+
+    std::vector<const likec::Declaration *> newDeclarations;
+    newDeclarations.reserve(declarations.size() - done);
+    for (std::size_t i = done; i < declarations.size(); ++i) {
+        newDeclarations.push_back(declarations[i].get());
+    }
+
+    callback(function, newDeclarations);
+
+    for (std::size_t i = done; i < declarations.size(); ++i) {
+        if (auto definition = declarations[i]->as<likec::FunctionDefinition>()) {
+            definition->block() = std::make_unique<likec::Block>();
+            definition->labels().clear();
+        }
+    }
+    done = declarations.size();
+}
+
+void CodeGenerator::addDeclaration(std::unique_ptr<likec::Declaration> declaration) {
+    if (auto staging = currentStaging()) {
+        staging->declarations.push_back(std::move(declaration));
+    } else {
+        tree().root()->addDeclaration(std::move(declaration));
+    }
 }
 
 const likec::Type *CodeGenerator::makeType(const types::Type *typeTraits) {
@@ -74,7 +430,9 @@ const likec::Type *CodeGenerator::makeType(const types::Type *typeTraits) {
     if (!typeTraits) {
         return tree().makeVoidType();
     } else if (typeTraits->isPointer()) {
-        if (std::find(typeCreationStack_.begin(), typeCreationStack_.end(), typeTraits) != typeCreationStack_.end()) {
+        auto &typeCreationStack = currentStaging() ? currentStaging()->typeCreationStack : typeCreationStack_;
+
+        if (std::find(typeCreationStack.begin(), typeCreationStack.end(), typeTraits) != typeCreationStack.end()) {
             /* Circular dependency. */
             return tree().makePointerType(typeTraits->size(), tree().makeVoidType());
 #ifdef NC_STRUCT_RECOVERY
@@ -82,9 +440,9 @@ const likec::Type *CodeGenerator::makeType(const types::Type *typeTraits) {
             return tree().makePointerType(typeTraits->size(), structuralType);
 #endif
         } else {
-            typeCreationStack_.push_back(typeTraits);
+            typeCreationStack.push_back(typeTraits);
             const likec::Type *pointee = makeType(typeTraits->pointee());
-            typeCreationStack_.pop_back();
+            typeCreationStack.pop_back();
 
             return tree().makePointerType(typeTraits->size(), pointee);
         }
@@ -107,9 +465,18 @@ const likec::StructType *CodeGenerator::makeStructuralType(const types::Type *ty
         return nullptr;
     }
 
-    auto i = traits2structType_.find(typeTraits);
-    if (i != traits2structType_.end()) {
-        return i->second;
+    auto staging = currentStaging();
+
+    auto existing = nc::find(traits2structType_, typeTraits);
+    if (!existing && staging) {
+        existing = nc::find(staging->traits2structType, typeTraits);
+    }
+    if (existing) {
+        if (recording()) {
+            /* Names of struct types depend on the order of their creation. */
+            recording()->cacheable = false;
+        }
+        return existing;
     }
 
     bool isStruct = false;
@@ -130,10 +497,18 @@ const likec::StructType *CodeGenerator::makeStructuralType(const types::Type *ty
         return nullptr;
     }
 
+    /* In parallel mode, the final name is given by mergeStaging(). */
     auto typeDeclaration = std::make_unique<likec::StructTypeDeclaration>(QString("s%1").arg(traits2structType_.size()));
 
     likec::StructType *type = typeDeclaration->type();
-    traits2structType_[typeTraits] = type;
+    if (staging) {
+        auto &creation = staging->creations[staging->beginCreation()];
+        creation.typeTraits = typeTraits;
+        creation.structTypeDeclaration = typeDeclaration.get();
+        staging->traits2structType[typeTraits] = type;
+    } else {
+        traits2structType_[typeTraits] = type;
+    }
 
     foreach (auto offset, typeTraits->offsets()) {
         ByteSize offsetValue = offset.first;
@@ -154,7 +529,15 @@ const likec::StructType *CodeGenerator::makeStructuralType(const types::Type *ty
         }
     }
 
-    tree().root()->addDeclaration(std::move(typeDeclaration));
+    addDeclaration(std::move(typeDeclaration));
+
+    if (staging) {
+        staging->endCreation();
+    }
+
+    if (recording()) {
+        recording()->cacheable = false;
+    }
 
     return type;
 }
@@ -176,9 +559,17 @@ likec::VariableDeclaration *CodeGenerator::makeGlobalVariableDeclaration(const v
     assert(variable != nullptr);
     assert(variable->isGlobal());
 
-    if (auto result = nc::find(variableDeclarations_, variable)) {
-        return result;
-    } else {
+    auto staging = currentStaging();
+
+    auto result = nc::find(variableDeclarations_, variable);
+    if (!result && staging) {
+        result = nc::find(staging->variableDeclarations, variable);
+    }
+    if (!result) {
+        if (staging) {
+            staging->beginCreation();
+        }
+
         auto type = makeVariableType(variable);
         auto initialValue = makeInitialValue(variable->memoryLocation(), type);
         auto nameAndComment = nameGenerator().getGlobalVariableName(variable->memoryLocation());
@@ -190,11 +581,24 @@ likec::VariableDeclaration *CodeGenerator::makeGlobalVariableDeclaration(const v
         declaration->setComment(std::move(nameAndComment.comment()));
 
         result = declaration.get();
-        tree().root()->addDeclaration(std::move(declaration));
-        variableDeclarations_[variable] = result;
+        addDeclaration(std::move(declaration));
 
-        return result;
+        if (staging) {
+            auto &creation = staging->endCreation();
+            creation.variable = variable;
+            creation.variableDeclaration = result;
+            staging->variableDeclarations[variable] = result;
+        } else {
+            variableDeclarations_[variable] = result;
+        }
     }
+
+    if (recording()) {
+        recording()->dependencies.push_back(DefinitionCache::Dependency(
+            DefinitionCache::Dependency::GLOBAL_VARIABLE, 0, variable->memoryLocation(), result->identifier()));
+    }
+
+    return result;
 }
 
 std::unique_ptr<likec::Expression> CodeGenerator::makeInitialValue(const MemoryLocation &memoryLocation, const likec::Type *type) {
@@ -227,17 +631,38 @@ std::unique_ptr<likec::Expression> CodeGenerator::makeInitialValue(const MemoryL
 
 likec::FunctionDeclaration *CodeGenerator::makeFunctionDeclaration(ByteAddr addr) {
     auto signature = signatures().getSignature(addr).get();
-    if (!signature) {
-        return nullptr;
+
+    auto staging = currentStaging();
+
+    likec::FunctionDeclaration *result = nullptr;
+    if (signature) {
+        result = nc::find(signature2declaration_, signature);
+        if (!result && staging) {
+            result = nc::find(staging->signature2declaration, signature);
+        }
+        if (!result) {
+            if (staging) {
+                staging->beginCreation();
+            }
+
+            DeclarationGenerator generator(*this, calling::EntryAddress(addr), signature);
+            addDeclaration(generator.createDeclaration());
+            result = generator.declaration();
+
+            if (staging) {
+                auto &creation = staging->endCreation();
+                creation.signature = signature;
+                creation.functionDeclaration = result;
+            }
+        }
     }
 
-    if (auto declaration = nc::find(signature2declaration_, signature)) {
-        return declaration;
+    if (recording()) {
+        recording()->dependencies.push_back(DefinitionCache::Dependency(
+            DefinitionCache::Dependency::FUNCTION, addr, MemoryLocation(), result ? result->identifier() : QString()));
     }
 
-    DeclarationGenerator generator(*this, calling::EntryAddress(addr), signature);
-    tree().root()->addDeclaration(generator.createDeclaration());
-    return generator.declaration();
+    return result;
 }
 
 likec::FunctionDefinition *CodeGenerator::makeFunctionDefinition(const Function *function) {
@@ -250,6 +675,19 @@ void CodeGenerator::setFunctionDeclaration(const calling::FunctionSignature *sig
     assert(signature != nullptr);
     assert(declaration != nullptr);
 
+    if (auto staging = currentStaging()) {
+        auto currentDeclaration = nc::find(signature2declaration_, signature);
+        if (!currentDeclaration) {
+            currentDeclaration = nc::find(staging->signature2declaration, signature);
+        }
+        if (currentDeclaration == nullptr) {
+            staging->signature2declaration[signature] = declaration;
+        } else {
+            declaration->setFirstDeclaration(currentDeclaration);
+        }
+        return;
+    }
+
     auto &currentDeclaration = signature2declaration_[signature];
     if (currentDeclaration == nullptr) {
         currentDeclaration = declaration;
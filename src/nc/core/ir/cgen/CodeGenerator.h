@@ -25,13 +25,16 @@
 
 #include <nc/config.h>
 
+#include <functional>
 #include <vector>
 
 #include <boost/noncopyable.hpp>
 #include <boost/unordered_map.hpp>
+#include <boost/unordered_set.hpp>
 
 #include <nc/core/ir/MemoryLocation.h>
 
+#include "DefinitionCache.h"
 #include "NameGenerator.h"
 
 namespace nc {
@@ -45,6 +48,7 @@ namespace image {
 }
 
 namespace likec {
+    class Declaration;
     class FunctionDeclaration;
     class FunctionDefinition;
     class Expression;
@@ -57,6 +61,7 @@ namespace likec {
 namespace ir {
 
 class Function;
+class FunctionCache;
 class Functions;
 class Term;
 
@@ -120,6 +125,21 @@ class CodeGenerator: boost::noncopyable {
     /** Mapping of functions to their declarations. */
     boost::unordered_map<const calling::FunctionSignature *, likec::FunctionDeclaration *> signature2declaration_;
 
+    /** Persistent cache of per-function results, including function definitions. */
+    FunctionCache *cache_;
+
+    /** Dependencies of the function definition being generated. */
+    DefinitionCache::Recording *recording_;
+
+    /** Entry addresses of the functions to generate definitions of. Empty set means all. */
+    boost::unordered_set<ByteAddr> selectedFunctions_;
+
+    /** Maximal number of threads to use for generating function definitions. */
+    int threadCount_;
+
+    /** Declarations created in a thread while generating a function definition in parallel. */
+    struct Staging;
+
 public:
 
     /**
@@ -144,7 +164,8 @@ public:
     ):
         tree_(tree), image_(image), functions_(functions), hooks_(hooks), signatures_(signatures),
         dataflows_(dataflows), variables_(variables), graphs_(graphs), livenesses_(livenesses),
-        types_(types), cancellationToken_(cancellationToken), nameGenerator_(image)
+        types_(types), cancellationToken_(cancellationToken), nameGenerator_(image),
+        cache_(nullptr), recording_(nullptr), threadCount_(1)
     {}
 
     /**
@@ -204,11 +225,92 @@ public:
 
     const NameGenerator &nameGenerator() const { return nameGenerator_; }
 
+    /**
+     * Sets the persistent cache of per-function results, including function definitions.
+     *
+     * \param cache Pointer to the cache. Can be nullptr, which disables caching.
+     */
+    void setCache(FunctionCache *cache) { cache_ = cache; }
+
+    /**
+     * \return Pointer to the persistent cache of per-function results. Can be nullptr.
+     */
+    FunctionCache *cache() const { return cache_; }
+
+    /**
+     * Sets the object collecting the dependencies of the function definition being generated.
+     *
+     * \param recording Pointer to the recording. Can be nullptr.
+     */
+    void setRecording(DefinitionCache::Recording *recording) { recording_ = recording; }
+
+    /**
+     * \return Pointer to the object collecting the dependencies of the function definition
+     *         being generated. Can be nullptr.
+     */
+    DefinitionCache::Recording *recording() const { return recording_; }
+
+    /**
+     * Restricts makeCompilationUnit() to generating definitions of the functions
+     * with the given entry addresses. Other functions get declared when referenced.
+     *
+     * \param addresses Entry addresses. Empty vector means all functions.
+     */
+    void selectFunctions(const std::vector<ByteAddr> &addresses) {
+        selectedFunctions_.clear();
+        selectedFunctions_.insert(addresses.begin(), addresses.end());
+    }
+
+    /**
+     * \param function Valid pointer to a function.
+     *
+     * \return True if makeCompilationUnit() must generate a definition of the function.
+     */
+    bool isSelected(const Function *function) const;
+
+    /**
+     * Sets the maximal number of threads that may be used for generating
+     * function definitions. 1 means no concurrency. The generated code
+     * does not depend on the number of threads.
+     *
+     * Concurrent generation is not used together with the definition cache.
+     *
+     * \param threadCount Number of threads, must be positive.
+     */
+    void setThreadCount(int threadCount) { assert(threadCount > 0); threadCount_ = threadCount; }
+
     /**
      * Translates input program into LikeC compilation unit.
      */
     void makeCompilationUnit();
 
+    /**
+     * Callback receiving the top-level declarations generated for a function.
+     * The first argument is the function, the second one is the list of
+     * the (already simplified) declarations added to the compilation unit
+     * while generating the function's definition, in the order of addition.
+     */
+    typedef std::function<void(const Function *, const std::vector<const likec::Declaration *> &)> DefinitionCallback;
+
+    /**
+     * Callback preparing the information about a function, e.g. its structural
+     * graph, needed for generating the function's definition. Is called in the
+     * order of functions, from the calling thread, but, when generating in parallel,
+     * possibly before the definitions of several preceding functions are generated.
+     */
+    typedef std::function<void(const Function *)> PrepareCallback;
+
+    /**
+     * Translates input program into LikeC compilation unit function by function.
+     * After generating the definition of a function, passes the new top-level
+     * declarations to the given callback and releases the body of the definition.
+     * Declarations stay in the tree, as the code generated later may refer to them.
+     *
+     * \param prepare Callback to be called before generating each function's definition. Can be empty.
+     * \param callback Callback to be called after generating each function's definition.
+     */
+    void makeCompilationUnit(const PrepareCallback &prepare, const DefinitionCallback &callback);
+
     /**
      * Creates high-level type object from given type traits.
      *
@@ -279,6 +381,63 @@ public:
      * its own declaration, CodeGenerator already knows about it.
      */
     void setFunctionDeclaration(const calling::FunctionSignature *signature, likec::FunctionDeclaration *declaration);
+
+private:
+    /**
+     * Generates the definitions of the given functions in batches. Within a batch,
+     * the definitions are generated in parallel, each in its own staging, and
+     * then merged into the compilation unit one by one by mergeStaging().
+     *
+     * \param functions Functions to generate definitions of.
+     * \param prepare Callback to be called before generating each function's definition. Can be empty.
+     * \param callback Callback to be called after adding each function's definition. Can be empty.
+     * \param done Number of top-level declarations already passed to the callback.
+     */
+    void makeFunctionDefinitions(const std::vector<const Function *> &functions,
+        const PrepareCallback &prepare, const DefinitionCallback &callback, std::size_t &done);
+
+    /**
+     * Adds the declarations and the definition generated in a staging to the
+     * compilation unit, as if the definition had been generated by
+     * makeFunctionDefinition() right now: declarations already created by
+     * the previously merged definitions are dropped and the references to them
+     * are redirected to the existing ones, struct types are named in the order
+     * of their creation.
+     *
+     * \param staging Staging.
+     *
+     * \return True on success, false if the output of makeFunctionDefinition()
+     *         would differ in more than that. In the latter case, nothing is added.
+     */
+    bool mergeStaging(Staging &staging);
+
+    /**
+     * Passes the top-level declarations added after the given number
+     * of already passed ones to the callback and releases the bodies
+     * of the definitions among them.
+     *
+     * \param function Function whose definition has just been generated.
+     * \param callback Callback.
+     * \param definitionCache Pointer to the definition cache. Can be nullptr.
+     * \param done Number of top-level declarations already passed to the callback.
+     */
+    void passDeclarations(const Function *function, const DefinitionCallback &callback,
+        DefinitionCache *definitionCache, std::size_t &done);
+
+    /**
+     * Adds a top-level declaration to the compilation unit or, when generating
+     * a definition in parallel, to the staging of the current thread.
+     *
+     * \param declaration Valid pointer to the declaration.
+     */
+    void addDeclaration(std::unique_ptr<likec::Declaration> declaration);
+
+    /**
+     * \return Reference to the pointer to the staging of the function definition
+     *          being generated in parallel in the current thread. The pointer is nullptr
+     *          when definitions are not generated in parallel.
+     */
+    static Staging *&currentStaging();
 };
 
 } // namespace cgen
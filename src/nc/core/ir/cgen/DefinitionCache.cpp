@@ -0,0 +1,347 @@
+/* The file is part of Snowman decompiler. */
+/* See doc/licenses.asciidoc for the licensing information. */
+
+#include "DefinitionCache.h"
+
+#include <algorithm>
+
+#include <QCryptographicHash>
+#include <QDataStream>
+#include <QTextStream>
+
+#include <nc/common/Foreach.h>
+#include <nc/common/Range.h>
+#include <nc/common/make_unique.h>
+#include <nc/core/image/Image.h>
+#include <nc/core/image/Reader.h>
+#include <nc/core/ir/BasicBlock.h>
+#include <nc/core/ir/Function.h>
+#include <nc/core/ir/FunctionCache.h>
+#include <nc/core/ir/Statements.h>
+#include <nc/core/ir/Term.h>
+#include <nc/core/ir/calling/CallSignature.h>
+#include <nc/core/ir/calling/FunctionSignature.h>
+#include <nc/core/ir/calling/Signatures.h>
+#include <nc/core/ir/dflow/Dataflows.h>
+#include <nc/core/ir/dflow/Value.h>
+#include <nc/core/ir/liveness/Livenesses.h>
+#include <nc/core/ir/types/Type.h>
+#include <nc/core/ir/types/Types.h>
+#include <nc/core/ir/vars/Variable.h>
+#include <nc/core/ir/vars/Variables.h>
+#include <nc/core/likec/FunctionDeclaration.h>
+#include <nc/core/likec/FunctionDefinition.h>
+#include <nc/core/likec/Tree.h>
+#include <nc/core/likec/VerbatimDeclaration.h>
+
+#include "CodeGenerator.h"
+#include "DeclarationGenerator.h"
+
+namespace nc {
+namespace core {
+namespace ir {
+namespace cgen {
+
+namespace {
+
+/**
+ * Version of the format of the cached data.
+ * Must be incremented whenever the generated code changes.
+ */
+const int FORMAT_VERSION = 2;
+
+void printType(QTextStream &out, const types::Type *type, int depth) {
+    out << '{' << type->size();
+    if (type->isInteger()) {
+        out << " int";
+    }
+    if (type->isFloat()) {
+        out << " flt";
+    }
+    if (type->isSigned()) {
+        out << " sgn";
+    }
+    if (type->isUnsigned()) {
+        out << " unsgn";
+    }
+    if (type->factor()) {
+        out << " factor=" << type->factor();
+    }
+    if (type->isPointer()) {
+        out << " ptr";
+        if (type->pointee() && depth > 0) {
+            printType(out, type->pointee(), depth - 1);
+        }
+    }
+    out << '}';
+}
+
+void printTerms(QTextStream &out, const std::vector<std::shared_ptr<const Term>> &terms) {
+    foreach (const auto &term, terms) {
+        out << ' ' << *term;
+    }
+}
+
+} // anonymous namespace
+
+DefinitionCache::DefinitionCache(CodeGenerator &parent, FunctionCache &cache):
+    parent_(parent), cache_(cache)
+{}
+
+DefinitionCache::~DefinitionCache() {}
+
+bool DefinitionCache::makeFunctionDefinition(const Function *function) {
+    assert(function != nullptr);
+
+    QByteArray digest = computeDigest(function);
+    if (digest.isEmpty()) {
+        parent_.makeFunctionDefinition(function);
+        return false;
+    }
+
+    QByteArray data = cache_.getDefinition(function);
+    if (!data.isEmpty() && restore(function, data, digest)) {
+        return true;
+    }
+
+    Generated generated;
+    generated.function = function;
+    generated.digest = digest;
+
+    parent_.setRecording(&generated.recording);
+    generated.definition = parent_.makeFunctionDefinition(function);
+    parent_.setRecording(nullptr);
+
+    if (generated.recording.cacheable) {
+        generated_.push_back(std::move(generated));
+    }
+
+    return false;
+}
+
+void DefinitionCache::storeGenerated() {
+    foreach (const auto &generated, generated_) {
+        QString text;
+        QTextStream out(&text);
+        generated.definition->print(out);
+        out.flush();
+
+        QByteArray data;
+        QDataStream stream(&data, QIODevice::WriteOnly);
+
+        stream << generated.digest << text << static_cast<quint32>(generated.recording.dependencies.size());
+        foreach (const auto &dependency, generated.recording.dependencies) {
+            stream << static_cast<qint32>(dependency.kind) << static_cast<qint64>(dependency.addr)
+                   << static_cast<qint32>(dependency.location.domain())
+                   << static_cast<qint64>(dependency.location.addr())
+                   << static_cast<qint64>(dependency.location.size())
+                   << dependency.value;
+        }
+
+        cache_.setDefinition(generated.function, data);
+    }
+    generated_.clear();
+}
+
+QByteArray DefinitionCache::computeDigest(const Function *function) const {
+    /* Without an entry address, the name of the function is not stable between runs. */
+    if (!function->entry() || !function->entry()->address()) {
+        return QByteArray();
+    }
+
+    const dflow::Dataflow &dataflow = *parent_.dataflows().at(function);
+    const liveness::Liveness &liveness = *parent_.livenesses().at(function);
+
+    QString string;
+    QTextStream out(&string);
+
+    /* The code itself is covered by the key of the function in the FunctionCache. */
+    out << "definition " << FORMAT_VERSION << endl;
+    out << "entry " << *function->entry()->address() << endl;
+    out << "name " << parent_.nameGenerator().getFunctionName(function).name() << endl;
+
+    if (auto signature = parent_.signatures().getSignature(function)) {
+        out << "signature";
+        printTerms(out, signature->arguments());
+        if (signature->returnValue()) {
+            out << " -> " << *signature->returnValue();
+        }
+        if (signature->variadic()) {
+            out << " ...";
+        }
+        out << endl;
+    }
+
+    foreach (const BasicBlock *basicBlock, function->basicBlocks()) {
+        foreach (const Statement *statement, basicBlock->statements()) {
+            if (auto call = statement->asCall()) {
+                if (auto signature = parent_.signatures().getSignature(call)) {
+                    out << "call";
+                    printTerms(out, signature->arguments());
+                    if (signature->returnValue()) {
+                        out << " -> " << *signature->returnValue();
+                    }
+                    out << endl;
+                }
+            }
+        }
+    }
+
+    /*
+     * Results of the analyses. Terms are numbered in the order
+     * of dataflow analysis, which is deterministic.
+     */
+    std::vector<const Term *> terms = dataflow.terms();
+    terms.erase(std::remove_if(terms.begin(), terms.end(),
+        [](const Term *term) { return term->index() == Term::NO_INDEX; }), terms.end());
+    std::sort(terms.begin(), terms.end(),
+        [](const Term *a, const Term *b) { return a->index() < b->index(); });
+
+    foreach (const Term *term, terms) {
+        out << "term " << term->index() << ' ' << *term;
+
+        if (liveness.isLive(term)) {
+            out << " live";
+        }
+
+        if (auto value = dataflow.getValue(term)) {
+            out << " value " << value->abstractValue().zeroBits() << ' ' << value->abstractValue().oneBits();
+            if (value->isStackOffset()) {
+                out << " stack " << value->stackOffset();
+            }
+            if (value->isProduct()) {
+                out << " product";
+            }
+            if (value->isReturnAddress()) {
+                out << " retaddr";
+            }
+        }
+
+        const auto &location = dataflow.getMemoryLocation(term);
+        if (location) {
+            out << " location " << location;
+        }
+
+        if (auto variable = parent_.variables().getVariable(term)) {
+            out << (variable->isGlobal() ? " global " : " local ") << variable->memoryLocation();
+        }
+
+        out << " type ";
+        printType(out, parent_.types().getType(term), 2);
+
+        out << endl;
+    }
+
+    out.flush();
+
+    return QCryptographicHash::hash(string.toUtf8(), QCryptographicHash::Sha1);
+}
+
+bool DefinitionCache::restore(const Function *function, const QByteArray &data, const QByteArray &digest) {
+    QDataStream stream(data);
+
+    QByteArray storedDigest;
+    QString text;
+    quint32 count;
+    stream >> storedDigest >> text >> count;
+
+    if (stream.status() != QDataStream::Ok || storedDigest != digest) {
+        return false;
+    }
+
+    std::vector<Dependency> dependencies;
+    for (quint32 i = 0; i < count && stream.status() == QDataStream::Ok; ++i) {
+        qint32 kind, domain;
+        qint64 addr, locationAddr, locationSize;
+        QString value;
+
+        stream >> kind >> addr >> domain >> locationAddr >> locationSize >> value;
+
+        if (kind == Dependency::GLOBAL_VARIABLE) {
+            if (locationSize <= 0) {
+                return false;
+            }
+            dependencies.push_back(Dependency(Dependency::GLOBAL_VARIABLE, addr,
+                MemoryLocation(domain, locationAddr, locationSize), std::move(value)));
+        } else if (kind == Dependency::FUNCTION || kind == Dependency::STRING) {
+            dependencies.push_back(Dependency(static_cast<Dependency::Kind>(kind), addr,
+                MemoryLocation(), std::move(value)));
+        } else {
+            return false;
+        }
+    }
+
+    if (stream.status() != QDataStream::Ok) {
+        return false;
+    }
+
+    foreach (const auto &dependency, dependencies) {
+        if (!check(dependency)) {
+            return false;
+        }
+    }
+
+    /*
+     * Recreate the declaration first, so that recursive calls refer
+     * to the function itself, as they do in a generated definition.
+     */
+    DeclarationGenerator generator(parent_, calling::CalleeId(function), parent_.signatures().getSignature(function).get());
+    auto declaration = generator.createDeclaration();
+
+    foreach (const auto &dependency, dependencies) {
+        switch (dependency.kind) {
+            case Dependency::FUNCTION:
+                parent_.makeFunctionDeclaration(dependency.addr);
+                break;
+            case Dependency::GLOBAL_VARIABLE:
+                parent_.makeGlobalVariableDeclaration(getGlobalVariable(dependency.location));
+                break;
+            case Dependency::STRING:
+                break;
+        }
+    }
+
+    parent_.tree().root()->addDeclaration(
+        std::make_unique<likec::VerbatimDeclaration>(std::move(declaration), std::move(text)));
+
+    return true;
+}
+
+bool DefinitionCache::check(const Dependency &dependency) {
+    switch (dependency.kind) {
+        case Dependency::FUNCTION: {
+            if (!parent_.signatures().getSignature(dependency.addr)) {
+                return dependency.value.isEmpty();
+            }
+            return parent_.nameGenerator().getFunctionName(dependency.addr).name() == dependency.value;
+        }
+        case Dependency::GLOBAL_VARIABLE: {
+            if (!getGlobalVariable(dependency.location)) {
+                return false;
+            }
+            return parent_.nameGenerator().getGlobalVariableName(dependency.location).name() == dependency.value;
+        }
+        case Dependency::STRING: {
+            return image::Reader(&parent_.image()).readAsciizString(dependency.addr, 1024) == dependency.value;
+        }
+    }
+    return false;
+}
+
+const vars::Variable *DefinitionCache::getGlobalVariable(const MemoryLocation &location) {
+    if (globalVariables_.empty()) {
+        foreach (const vars::Variable *variable, parent_.variables().list()) {
+            if (variable->isGlobal()) {
+                globalVariables_[variable->memoryLocation()] = variable;
+            }
+        }
+    }
+    return nc::find(globalVariables_, location);
+}
+
+} // namespace cgen
+} // namespace ir
+} // namespace core
+} // namespace nc
+
+/* vim:set et sts=4 sw=4: */
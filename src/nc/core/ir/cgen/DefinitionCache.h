@@ -0,0 +1,175 @@
+/* The file is part of Snowman decompiler. */
+/* See doc/licenses.asciidoc for the licensing information. */
+
+#pragma once
+
+#include <nc/config.h>
+
+#include <memory>
+#include <vector>
+
+#include <QByteArray>
+#include <QString>
+
+#include <boost/noncopyable.hpp>
+#include <boost/unordered_map.hpp>
+
+#include <nc/common/Types.h>
+#include <nc/core/ir/MemoryLocation.h>
+
+namespace nc {
+namespace core {
+
+namespace likec {
+    class FunctionDefinition;
+}
+
+namespace ir {
+
+class Function;
+class FunctionCache;
+
+namespace vars {
+    class Variable;
+}
+
+namespace cgen {
+
+class CodeGenerator;
+
+/**
+ * Cache of the source text of generated function definitions.
+ *
+ * The text of a definition is stored in the function's entry of the
+ * FunctionCache, together with a digest of everything else the code
+ * generator looks at when generating it: the function's address and name,
+ * the results of the analyses of the function, and the signatures of the
+ * function and the functions it calls. The text is reused only if the
+ * digest is unchanged. Besides the text, the cache stores the facts about
+ * the rest of the program that the generation relied on (names of called
+ * functions and global variables, contents of referenced strings). When
+ * restoring a definition, these facts are checked, and the declarations
+ * of the functions and global variables are added to the tree in the same
+ * order as during the generation.
+ */
+class DefinitionCache: boost::noncopyable {
+public:
+    /**
+     * A fact about the rest of the program that a generated definition relies on.
+     */
+    struct Dependency {
+        enum Kind {
+            FUNCTION,           ///< Function at the given address has the given name, or no signature if the name is empty.
+            GLOBAL_VARIABLE,    ///< Global variable at the given location has the given name.
+            STRING              ///< Image contains the given string at the given address.
+        };
+
+        Kind kind; ///< Kind of the fact.
+        ByteAddr addr; ///< Address of the function or the string.
+        MemoryLocation location; ///< Memory location of the global variable.
+        QString value; ///< Expected name or contents.
+
+        Dependency(Kind kind, ByteAddr addr, MemoryLocation location, QString value):
+            kind(kind), addr(addr), location(location), value(std::move(value))
+        {}
+    };
+
+    /**
+     * Dependencies collected while generating a single definition.
+     */
+    struct Recording {
+        std::vector<Dependency> dependencies; ///< Dependencies in the order of their creation.
+        bool cacheable; ///< False if the definition relies on something not expressible by a dependency.
+
+        Recording(): cacheable(true) {}
+    };
+
+private:
+    CodeGenerator &parent_;
+    FunctionCache &cache_;
+
+    /** Definitions generated in this run, to be stored once the tree is finished. */
+    struct Generated {
+        const Function *function;
+        QByteArray digest;
+        Recording recording;
+        const likec::FunctionDefinition *definition;
+    };
+    std::vector<Generated> generated_;
+
+    /** Global variables by their memory locations. */
+    boost::unordered_map<MemoryLocation, const vars::Variable *> globalVariables_;
+
+public:
+    /**
+     * Constructor.
+     *
+     * \param parent Code generator.
+     * \param cache Cache of per-function results.
+     */
+    DefinitionCache(CodeGenerator &parent, FunctionCache &cache);
+
+    /**
+     * Destructor.
+     */
+    ~DefinitionCache();
+
+    /**
+     * Restores the definition of the given function from the cache,
+     * or generates it and remembers it for storing.
+     * In both cases, the definition is added to the compilation unit.
+     *
+     * \param function Valid pointer to a function.
+     *
+     * \return True if the definition was restored from the cache, false otherwise.
+     */
+    bool makeFunctionDefinition(const Function *function);
+
+    /**
+     * Puts the definitions generated so far into the cache of per-function
+     * results. Must be called after the tree has been finished.
+     */
+    void storeGenerated();
+
+private:
+    /**
+     * \param function Valid pointer to a function.
+     *
+     * \return Digest of everything the definition of the function depends on,
+     *         besides its code, or an empty array if the definition must not be cached.
+     */
+    QByteArray computeDigest(const Function *function) const;
+
+    /**
+     * Restores the definition of the given function from the cached data.
+     *
+     * \param function Valid pointer to a function.
+     * \param data Cached data.
+     * \param digest Digest of the function computed by computeDigest().
+     *
+     * \return True on success, false if the data are malformed or stale.
+     *         In the latter case, the tree is not modified.
+     */
+    bool restore(const Function *function, const QByteArray &data, const QByteArray &digest);
+
+    /**
+     * \param dependency Dependency.
+     *
+     * \return True if the dependency holds in the program being decompiled.
+     */
+    bool check(const Dependency &dependency);
+
+    /**
+     * \param location Memory location.
+     *
+     * \return Pointer to the global variable occupying exactly this location. Can be nullptr.
+     */
+    const vars::Variable *getGlobalVariable(const MemoryLocation &location);
+};
+
+} // namespace cgen
+} // namespace ir
+} // namespace core
+} // namespace nc
+
+/* vim:set et sts=4 sw=4: */
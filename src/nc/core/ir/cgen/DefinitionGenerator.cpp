@@ -1129,6 +1129,11 @@ std::unique_ptr<likec::Expression> DefinitionGenerator::makeConstant(const Term
 
         QString string = image::Reader(&parent().image()).readAsciizString(value.value(), 1024);
 
+        if (auto recording = parent().recording()) {
+            recording->dependencies.push_back(DefinitionCache::Dependency(
+                DefinitionCache::Dependency::STRING, value.value(), MemoryLocation(), string));
+        }
+
         if (!string.isEmpty() && isAscii(string)) {
             return std::make_unique<likec::String>(string);
         }
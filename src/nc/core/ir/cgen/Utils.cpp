@@ -78,15 +78,18 @@ boost::optional<bool> allOfBasicBlocksBetween(const BasicBlock *first, const Bas
     std::queue<const BasicBlock *> queue;
     boost::unordered_map<const BasicBlock *, Color> colors;
 
+    /*
+     * Color gray the basic blocks reachable from the first one.
+     * The search goes on past the second basic block, as control
+     * can come back to it via a cycle not passing the first one.
+     */
     queue.push(first);
     colors[first] = GRAY;
 
     while (!queue.empty()) {
         foreach (auto successor, cfg.getSuccessors(queue.front())) {
             if (nc::find(colors, successor) == WHITE) {
-                if (successor != second) {
-                    queue.push(successor);
-                }
+                queue.push(successor);
                 colors[successor] = GRAY;
             }
         }
@@ -97,8 +100,13 @@ boost::optional<bool> allOfBasicBlocksBetween(const BasicBlock *first, const Bas
         return boost::none;
     }
 
+    /*
+     * Color black and check the gray basic blocks from which the second
+     * one is reachable without passing the first one. The second basic
+     * block itself is checked only if it is met on the way back, i.e.
+     * lies on such a cycle.
+     */
     queue.push(second);
-    colors[second] = BLACK;
 
     while (!queue.empty()) {
         foreach (auto predecessor, cfg.getPredecessors(queue.front())) {
@@ -57,9 +57,12 @@ bool isDominating(const Statement *first, const Statement *second, const Dominat
  * \param[in] pred A predicate.
  *
  * \return True if the predicate holds for all basic blocks (excluding
- *         first and second) lying on all simple CFG paths from first to
- *         second, false if it does not, boost::none if there is no path
- *         from the first basic block to the second basic block.
+ *         first) lying on CFG paths from first to second that do not
+ *         pass through first again, false if it does not, boost::none
+ *         if there is no path from the first basic block to the second
+ *         basic block. The second basic block counts only if such a
+ *         path passes through it more than once, i.e. if it lies on
+ *         a cycle not containing the first basic block.
  */
 boost::optional<bool> allOfBasicBlocksBetween(const BasicBlock *first, const BasicBlock *second, const CFG &cfg,
                                               std::function<bool(const BasicBlock *)> pred);
@@ -71,9 +74,10 @@ boost::optional<bool> allOfBasicBlocksBetween(const BasicBlock *first, const Bas
  * \param[in] pred A predicate.
  *
  * \return True iff the predicate holds for all statements (except first
- *         and second) lying on all simple CFG paths from first to second,
- *         false if it does not, boost::none if there is no path from
- *         the first statement to the second statement in the CFG.
+ *         and second) lying on CFG paths from first to second that do not
+ *         pass through first again, false if it does not, boost::none if
+ *         there is no path from the first statement to the second statement
+ *         in the CFG.
  */
 boost::optional<bool> allOfStatementsBetween(const Statement *first, const Statement *second, const CFG &cfg,
                                              std::function<bool(const Statement *)> pred);
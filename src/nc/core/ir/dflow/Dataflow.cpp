@@ -24,7 +24,11 @@
 
 #include "Dataflow.h"
 
-#include "Value.h"
+#include <nc/common/Foreach.h>
+
+#include <nc/core/ir/BasicBlock.h>
+#include <nc/core/ir/Function.h>
+#include <nc/core/ir/Statement.h>
 
 namespace nc {
 namespace core {
@@ -42,17 +46,96 @@ Value *Dataflow::getValue(const Term *term) {
         term = source;
     }
 
-    auto &result = term2value_[term];
-    if (!result) {
-        result.reset(new Value(term->size()));
+    auto &value = getInfo(term).value;
+    if (!value) {
+        value = Value(term->size());
     }
-    return result.get();
+    return &*value;
 }
 
 const Value *Dataflow::getValue(const Term *term) const {
     return const_cast<Dataflow *>(this)->getValue(term);
 }
 
+const MemoryLocation &Dataflow::getMemoryLocation(const Term *term) const {
+    static const MemoryLocation invalidLocation;
+
+    auto info = findInfo(term);
+    return info ? info->location : invalidLocation;
+}
+
+const ReachingDefinitions &Dataflow::getDefinitions(const Term *term) const {
+    assert(term != nullptr);
+    assert(term->isRead());
+
+    static const ReachingDefinitions noDefinitions;
+
+    auto info = findInfo(term);
+    return info ? info->definitions : noDefinitions;
+}
+
+Dataflow::TermInfo &Dataflow::createInfo(const Term *term) {
+    assert(findInfo(term) == nullptr);
+
+    auto index = term->index();
+
+    /* Terms of functions get an index when they are seen for the first time. */
+    if (index == Term::NO_INDEX && term->statement() && term->statement()->basicBlock()) {
+        if (auto function = term->statement()->basicBlock()->function()) {
+            index = function->getTermIndex(term);
+        }
+    }
+
+    if (index != Term::NO_INDEX) {
+        if (index >= indexedInfos_.size()) {
+            indexedInfos_.resize(index + 1);
+        }
+        auto &info = indexedInfos_[index];
+        if (!info.term) {
+            info.term = term;
+            return info;
+        }
+    }
+
+    /* The term has no index or its slot is taken by a term of another function. */
+    auto &info = otherInfos_[term];
+    info.term = term;
+    return info;
+}
+
+std::vector<const Term *> Dataflow::terms() const {
+    std::vector<const Term *> result;
+    result.reserve(indexedInfos_.size() + otherInfos_.size());
+
+    foreach (const auto &info, indexedInfos_) {
+        if (info.term) {
+            result.push_back(info.term);
+        }
+    }
+    foreach (const auto &termAndInfo, otherInfos_) {
+        result.push_back(termAndInfo.first);
+    }
+
+    return result;
+}
+
+void Dataflow::removeTerms(const std::function<bool(const Term *)> &pred) {
+    foreach (auto &info, indexedInfos_) {
+        if (info.term && pred(info.term)) {
+            info = TermInfo();
+        }
+    }
+
+    auto i = otherInfos_.begin();
+    while (i != otherInfos_.end()) {
+        if (pred(i->first)) {
+            i = otherInfos_.erase(i);
+        } else {
+            ++i;
+        }
+    }
+}
+
 } // namespace dflow
 } // namespace ir
 } // namespace core
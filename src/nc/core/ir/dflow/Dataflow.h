@@ -25,8 +25,11 @@
 
 #include <nc/config.h>
 
-#include <memory>
+#include <deque>
+#include <functional>
+#include <vector>
 
+#include <boost/optional.hpp>
 #include <boost/unordered_map.hpp>
 
 #include <nc/common/Range.h>
@@ -35,26 +38,41 @@
 #include <nc/core/ir/Term.h>
 
 #include "ReachingDefinitions.h"
+#include "Value.h"
 
 namespace nc {
 namespace core {
 namespace ir {
-namespace dflow {
 
-class Value;
+class Statement;
+
+namespace dflow {
 
 /**
  * This class contains results of dataflow and constant propagation and folding analysis.
+ *
+ * Information about the terms of functions is stored in an array indexed
+ * by Term::index(). Terms not belonging to any function, e.g. terms of
+ * the program, are looked up in a hash table.
  */
 class Dataflow {
-    /** Mapping from a term to a description of its value. */
-    boost::unordered_map<const Term *, std::unique_ptr<Value>> term2value_;
+    /**
+     * Everything known about a term.
+     */
+    struct TermInfo {
+        const Term *term; ///< The term, or nullptr if the slot is free.
+        boost::optional<Value> value; ///< Description of the term's value.
+        MemoryLocation location; ///< Memory location of the term.
+        ReachingDefinitions definitions; ///< Definitions reaching the term.
+
+        TermInfo(): term(nullptr) {}
+    };
 
-    /** Mapping from a term to its memory location. */
-    boost::unordered_map<const Term *, MemoryLocation> term2location_;
+    /** Information about terms, indexed by the terms' indices. Deque keeps references valid on growth. */
+    std::deque<TermInfo> indexedInfos_;
 
-    /** Mapping from a term to the reaching definitions. */
-    boost::unordered_map<const Term *, ReachingDefinitions> term2definitions_;
+    /** Information about terms that cannot be stored in indexedInfos_. */
+    boost::unordered_map<const Term *, TermInfo> otherInfos_;
 
     /** Mapping from a statement to the reaching definitions. */
     boost::unordered_map<const Statement *, ReachingDefinitions> statement2definitions_;
@@ -88,26 +106,13 @@ public:
      */
     const Value *getValue(const Term *term) const;
 
-    /**
-     * \return Mapping from a term to the description of its value.
-     */
-    boost::unordered_map<const Term *, std::unique_ptr<Value>> &term2value() { return term2value_; }
-
-    /**
-     * \return Mapping from a term to the description of its value.
-     */
-    const boost::unordered_map<const Term *, std::unique_ptr<Value>> &term2value() const { return term2value_; }
-
     /**
      * \param[in] term Valid pointer to a term.
      *
      * \return Memory location occupied by the term. If no memory location is associated
      *         with this term, an invalid MemoryLocation object is returned.
      */
-    const ir::MemoryLocation &getMemoryLocation(const Term *term) const {
-        assert(term != nullptr);
-        return nc::find(term2location_, term);
-    }
+    const ir::MemoryLocation &getMemoryLocation(const Term *term) const;
 
     /**
      * Associates a memory location with given term.
@@ -119,19 +124,9 @@ public:
      */
     const MemoryLocation &setMemoryLocation(const Term *term, const MemoryLocation &memoryLocation) {
         assert(term != nullptr);
-        return (term2location_[term] = memoryLocation);
+        return (getInfo(term).location = memoryLocation);
     }
 
-    /**
-     * \return Mapping from a term to its memory location.
-     */
-    boost::unordered_map<const Term *, MemoryLocation> &term2location() { return term2location_; };
-
-    /**
-     * \return Mapping from a term to its memory location.
-     */
-    const boost::unordered_map<const Term *, MemoryLocation> &term2location() const { return term2location_; };
-
     /**
      * \param[in] term Valid pointer to a read term.
      *
@@ -140,7 +135,7 @@ public:
     ReachingDefinitions &getDefinitions(const Term *term) {
         assert(term != nullptr);
         assert(term->isRead());
-        return term2definitions_[term];
+        return getInfo(term).definitions;
     }
 
     /**
@@ -148,21 +143,7 @@ public:
      *
      * \return List of term's definitions. If not set before, it is empty.
      */
-    const ReachingDefinitions &getDefinitions(const Term *term) const {
-        assert(term != nullptr);
-        assert(term->isRead());
-        return nc::find(term2definitions_, term);
-    }
-
-    /**
-     * \return Mapping from a term to its reaching definitions.
-     */
-    boost::unordered_map<const Term *, ReachingDefinitions> &term2definitions() { return term2definitions_; }
-
-    /**
-     * \return Mapping from a term to its reaching definitions.
-     */
-    const boost::unordered_map<const Term *, ReachingDefinitions> &term2definitions() const { return term2definitions_; }
+    const ReachingDefinitions &getDefinitions(const Term *term) const;
 
     /**
      * \param[in] statement Valid pointer to a read statement.
@@ -183,6 +164,57 @@ public:
         assert(statement != nullptr);
         return nc::find(statement2definitions_, statement);
     }
+
+    /**
+     * \return All terms for which some information is stored.
+     */
+    std::vector<const Term *> terms() const;
+
+    /**
+     * Forgets everything about the terms satisfying the given predicate.
+     *
+     * \param pred Predicate.
+     */
+    void removeTerms(const std::function<bool(const Term *)> &pred);
+
+private:
+    /**
+     * \param term Valid pointer to a term.
+     *
+     * \return Pointer to the information about the term. Can be nullptr.
+     */
+    const TermInfo *findInfo(const Term *term) const {
+        assert(term != nullptr);
+
+        auto index = term->index();
+        if (index < indexedInfos_.size() && indexedInfos_[index].term == term) {
+            return &indexedInfos_[index];
+        }
+        if (otherInfos_.empty()) {
+            return nullptr;
+        }
+        auto i = otherInfos_.find(term);
+        return i != otherInfos_.end() ? &i->second : nullptr;
+    }
+
+    /**
+     * \param term Valid pointer to a term.
+     *
+     * \return Reference to the information about the term, created if necessary.
+     */
+    TermInfo &getInfo(const Term *term) {
+        if (auto info = findInfo(term)) {
+            return const_cast<TermInfo &>(*info);
+        }
+        return createInfo(term);
+    }
+
+    /**
+     * \param term Valid pointer to a term having no information about it yet.
+     *
+     * \return Reference to newly created information about the term.
+     */
+    TermInfo &createInfo(const Term *term);
 };
 
 } // namespace dflow
@@ -24,7 +24,11 @@
 
 #include "DataflowAnalyzer.h"
 
+#include <algorithm>
+#include <set>
+
 #include <boost/unordered_map.hpp>
+#include <boost/unordered_set.hpp>
 
 #include <nc/common/CancellationToken.h>
 #include <nc/common/Foreach.h>
@@ -48,18 +52,46 @@ namespace dflow {
 
 namespace {
 
-template<class Map, class Pred>
-void remove_if(Map &map, Pred pred) {
-    auto i = map.begin();
-    auto iend = map.end();
+/**
+ * \param cfg Control flow graph.
+ *
+ * \return Basic blocks of the graph in reverse postorder. Depth-first search
+ *         is started from the basic blocks in the order of their appearance
+ *         in the graph, so the entry (coming first) gets the smallest number.
+ */
+std::vector<const BasicBlock *> reversePostorder(const CFG &cfg) {
+    std::vector<const BasicBlock *> result;
+    boost::unordered_set<const BasicBlock *> visited;
+
+    /* Stack of basic blocks being visited and indices of their next successors to visit. */
+    std::vector<std::pair<const BasicBlock *, std::size_t>> stack;
+
+    foreach (const BasicBlock *root, cfg.basicBlocks()) {
+        if (!visited.insert(root).second) {
+            continue;
+        }
+
+        stack.push_back(std::make_pair(root, 0));
 
-    while (i != iend) {
-        if (pred(i->first)) {
-            i = map.erase(i);
-        } else {
-            ++i;
+        while (!stack.empty()) {
+            auto basicBlock = stack.back().first;
+            const auto &successors = cfg.getSuccessors(basicBlock);
+
+            if (stack.back().second < successors.size()) {
+                auto successor = successors[stack.back().second++];
+                if (visited.insert(successor).second) {
+                    stack.push_back(std::make_pair(successor, 0));
+                }
+            } else {
+                result.push_back(basicBlock);
+                stack.pop_back();
+            }
         }
     }
+
+    std::reverse(result.begin(), result.end());
+
+    return result;
 }
 
 } // anonymous namespace
@@ -72,75 +104,125 @@ void DataflowAnalyzer::analyze(const CFG &cfg) {
         return !dataflow().getMemoryLocation(term).covers(mloc);
     };
 
+    /* Basic blocks in reverse postorder. */
+    auto basicBlocks = reversePostorder(cfg);
+
+    /* Mapping of a basic block to its index in reverse postorder. */
+    boost::unordered_map<const BasicBlock *, std::size_t> indices;
+    for (std::size_t i = 0; i < basicBlocks.size(); ++i) {
+        indices[basicBlocks[i]] = i;
+    }
+
     /* Mapping of a basic block to the definitions reaching its end. */
     boost::unordered_map<const BasicBlock *, ReachingDefinitions> outDefinitions;
 
+    /* Indices of basic blocks waiting for execution. The smallest one is executed first. */
+    std::set<std::size_t> worklist;
+    for (std::size_t i = 0; i < basicBlocks.size(); ++i) {
+        worklist.insert(worklist.end(), i);
+    }
+
+    auto enqueue = [&](const BasicBlock *basicBlock) {
+        worklist.insert(nc::find(indices, basicBlock));
+    };
+
     /*
-     * Running abstract interpretation until reaching a fixpoint several times in a row.
+     * Do we loop infinitely? Give up when, on average, every basic block
+     * has been executed as many times as the old sweep-based loop allowed.
      */
-    int niterations = 0;
-    int nfixpoints = 0;
+    const std::size_t maxExecutions = 30 * basicBlocks.size();
 
-    while (nfixpoints++ < 3) {
-        /*
-         * Run abstract interpretation on all basic blocks.
-         */
-        foreach (auto basicBlock, cfg.basicBlocks()) {
-            ReachingDefinitions definitions;
+    definitionUses_.clear();
+    basicBlockExecutions_ = 0;
 
-            /* Merge reaching definitions from predecessors. */
-            foreach (const BasicBlock *predecessor, cfg.getPredecessors(basicBlock)) {
-                definitions.merge(outDefinitions[predecessor]);
-            }
+    while (!worklist.empty()) {
+        if (basicBlockExecutions_ >= maxExecutions) {
+            log_.warning(tr("%1: Fixpoint was not reached after %2 executions of %3 basic blocks.")
+                .arg(Q_FUNC_INFO).arg(basicBlockExecutions_).arg(basicBlocks.size()));
+            break;
+        }
 
-            /* Remove definitions that do not cover the memory location that they define. */
-            definitions.filterOut(notCovered);
+        auto basicBlock = basicBlocks[*worklist.begin()];
+        worklist.erase(worklist.begin());
 
-            /* Execute all the statements in the basic block. */
-            foreach (auto statement, basicBlock->statements()) {
-                execute(statement, definitions);
-            }
+        ReachingDefinitions definitions;
+
+        /* Merge reaching definitions from predecessors. */
+        foreach (const BasicBlock *predecessor, cfg.getPredecessors(basicBlock)) {
+            definitions.merge(outDefinitions[predecessor]);
+        }
+
+        /* Remove definitions that do not cover the memory location that they define. */
+        definitions.filterOut(notCovered);
+
+        /* Execute all the statements in the basic block. */
+        currentBasicBlock_ = basicBlock;
+        changed_ = false;
+        callbacksExecuted_ = false;
+
+        foreach (auto statement, basicBlock->statements()) {
+            execute(statement, definitions);
+        }
+
+        currentBasicBlock_ = nullptr;
+        ++basicBlockExecutions_;
+
+        /* Something has changed? Successors must see it. */
+        ReachingDefinitions &oldDefinitions(outDefinitions[basicBlock]);
+        if (oldDefinitions != definitions) {
+            oldDefinitions = std::move(definitions);
 
-            /* Something has changed? */
-            ReachingDefinitions &oldDefinitions(outDefinitions[basicBlock]);
-            if (oldDefinitions != definitions) {
-                oldDefinitions = std::move(definitions);
-                nfixpoints = 0;
+            foreach (const BasicBlock *successor, cfg.getSuccessors(basicBlock)) {
+                enqueue(successor);
             }
         }
 
-        /*
-         * Some terms might have changed their addresses. Filter again.
-         */
-        foreach (auto &termAndDefinitions, dataflow().term2definitions()) {
-            termAndDefinitions.second.filterOut(notCovered);
+        /* Users of definitions with changed values must recompute their values. */
+        foreach (const Term *definition, changedDefinitions_) {
+            foreach (const BasicBlock *use, nc::find(definitionUses_, definition)) {
+                enqueue(use);
+            }
         }
+        changedDefinitions_.clear();
 
         /*
-         * Do we loop infinitely?
+         * Hooks are instrumented by callbacks, which look at the values
+         * computed during the previous execution of the basic block.
          */
-        if (++niterations >= 30) {
-            log_.warning(tr("%1: Fixpoint was not reached after %2 iterations.").arg(Q_FUNC_INFO).arg(niterations));
-            break;
+        if (changed_ && callbacksExecuted_) {
+            enqueue(basicBlock);
         }
 
         canceled_.poll();
     }
 
+    log_.debug(tr("Dataflow analysis: %1 basic blocks, %2 executions.").arg(basicBlocks.size()).arg(basicBlockExecutions_));
+
+    definitionUses_.clear();
+
+    /*
+     * Some terms might have changed their addresses. Filter again.
+     */
+    auto terms = dataflow().terms();
+    foreach (auto term, terms) {
+        if (term->isRead()) {
+            dataflow().getDefinitions(term).filterOut(notCovered);
+        }
+    }
+
     /*
      * Remove information about terms that disappeared.
      * Terms can disappear if e.g. a call is deinstrumented during the analysis.
      */
     auto disappeared = [](const Term *term){ return term->statement()->basicBlock() == nullptr; };
 
-    std::vector<const Term *> disappearedTerms;
-    foreach (auto &termAndDefinitions, dataflow().term2definitions()) {
-        termAndDefinitions.second.filterOut([disappeared](const MemoryLocation &, const Term *term) { return disappeared(term); } );
+    foreach (auto term, terms) {
+        if (term->isRead()) {
+            dataflow().getDefinitions(term).filterOut([disappeared](const MemoryLocation &, const Term *term) { return disappeared(term); } );
+        }
     }
 
-    remove_if(dataflow().term2value(), disappeared);
-    remove_if(dataflow().term2location(), disappeared);
-    remove_if(dataflow().term2definitions(), disappeared);
+    dataflow().removeTerms(disappeared);
 }
 
 void DataflowAnalyzer::execute(const Statement *statement, ReachingDefinitions &definitions) {
@@ -195,6 +277,7 @@ void DataflowAnalyzer::execute(const Statement *statement, ReachingDefinitions &
         }
         case Statement::CALLBACK: {
             statement->asCallback()->function()();
+            callbacksExecuted_ = true;
             break;
         }
         case Statement::REMEMBER_REACHING_DEFINITIONS: {
@@ -208,6 +291,29 @@ void DataflowAnalyzer::execute(const Statement *statement, ReachingDefinitions &
 }
 
 Value *DataflowAnalyzer::computeValue(const Term *term, const ReachingDefinitions &definitions) {
+    if (!currentBasicBlock_) {
+        return doComputeValue(term, definitions);
+    }
+
+    Value oldValue = *dataflow().getValue(term);
+
+    auto value = doComputeValue(term, definitions);
+
+    if (*value != oldValue) {
+        changed_ = true;
+
+        /* The right hand side of an assignment gives the value to its left hand side. */
+        if (auto assignment = term->statement()->asAssignment()) {
+            if (assignment->right() == term) {
+                changedDefinitions_.push_back(assignment->left());
+            }
+        }
+    }
+
+    return value;
+}
+
+Value *DataflowAnalyzer::doComputeValue(const Term *term, const ReachingDefinitions &definitions) {
     switch (term->kind()) {
         case Term::INT_CONST: {
             auto constant = term->asConstant();
@@ -270,7 +376,9 @@ Value *DataflowAnalyzer::computeValue(const Term *term, const ReachingDefinition
 }
 
 const MemoryLocation &DataflowAnalyzer::computeMemoryLocation(const Term *term, const ReachingDefinitions &definitions) {
-    return dataflow().setMemoryLocation(term, [&]() -> MemoryLocation {
+    auto oldMemoryLocation = dataflow().getMemoryLocation(term);
+
+    const auto &memoryLocation = dataflow().setMemoryLocation(term, [&]() -> MemoryLocation {
         switch (term->kind()) {
             case Term::MEMORY_LOCATION_ACCESS: {
                 return term->asMemoryLocationAccess()->memoryLocation();
@@ -304,6 +412,12 @@ const MemoryLocation &DataflowAnalyzer::computeMemoryLocation(const Term *term,
             }
         }
     }());
+
+    if (memoryLocation != oldMemoryLocation) {
+        changed_ = true;
+    }
+
+    return memoryLocation;
 }
 
 const ReachingDefinitions &DataflowAnalyzer::computeReachingDefinitions(const Term *term,
@@ -357,6 +471,13 @@ Value *DataflowAnalyzer::computeValue(const Term *term, const MemoryLocation &me
         }
 
         foreach (auto definition, chunk.definitions()) {
+            if (currentBasicBlock_) {
+                auto &uses = definitionUses_[definition];
+                if (!nc::contains(uses, currentBasicBlock_)) {
+                    uses.push_back(currentBasicBlock_);
+                }
+            }
+
             auto definitionLocation = dataflow().getMemoryLocation(definition);
             assert(definitionLocation.covers(chunk.location()));
 
@@ -31,6 +31,9 @@
 #include <nc/common/LogToken.h>
 
 #include <cassert>
+#include <vector>
+
+#include <boost/unordered_map.hpp>
 
 namespace nc {
 
@@ -42,6 +45,7 @@ namespace arch {
 
 namespace ir {
 
+class BasicBlock;
 class CFG;
 class MemoryLocation;
 class Statement;
@@ -67,6 +71,24 @@ class DataflowAnalyzer {
     const CancellationToken &canceled_;
     const LogToken &log_;
 
+    /** Basic block being executed by analyze(), nullptr when execute() is called from outside. */
+    const BasicBlock *currentBasicBlock_;
+
+    /** True if a value or a memory location of a term has changed while executing the current basic block. */
+    bool changed_;
+
+    /** True if callback statements have been executed in the current basic block. */
+    bool callbacksExecuted_;
+
+    /** Definitions whose values have changed while executing the current basic block. */
+    std::vector<const Term *> changedDefinitions_;
+
+    /** Mapping from a definition to the basic blocks where it was used as a reaching definition. */
+    boost::unordered_map<const Term *, std::vector<const BasicBlock *>> definitionUses_;
+
+    /** Number of basic block executions performed by the last analyze() call. */
+    std::size_t basicBlockExecutions_;
+
 public:
     /**
      * Constructor.
@@ -78,7 +100,8 @@ public:
      */
     DataflowAnalyzer(Dataflow &dataflow, const arch::Architecture *architecture,
         const CancellationToken &canceled, const LogToken &log):
-        dataflow_(dataflow), architecture_(architecture), canceled_(canceled), log_(log)
+        dataflow_(dataflow), architecture_(architecture), canceled_(canceled), log_(log),
+        currentBasicBlock_(nullptr), changed_(false), callbacksExecuted_(false), basicBlockExecutions_(0)
     {
         assert(architecture != nullptr);
     }
@@ -97,10 +120,21 @@ public:
      * Performs joint reaching definitions and constant propagation/folding
      * analysis on the given control flow graph.
      *
+     * Basic blocks are kept in a worklist ordered by their reverse postorder
+     * numbers. A basic block is executed again only when the definitions
+     * reaching the end of one of its predecessors change, when the value of
+     * a definition it uses changes, or when hooks inserted into it have
+     * changed the code executed after them.
+     *
      * \param[in] cfg Control flow graph to run dataflow analysis on.
      */
     void analyze(const CFG &cfg);
 
+    /**
+     * \return Number of basic block executions performed by the last call to analyze().
+     */
+    std::size_t basicBlockExecutions() const { return basicBlockExecutions_; }
+
     /**
      * Executes a statement.
      *
@@ -112,6 +146,7 @@ public:
 private:
     /**
      * Computes the value of the given term.
+     * When called from analyze(), also remembers whether the value has changed.
      *
      * \param term          Valid pointer to a term.
      * \param definitions   Reaching definitions.
@@ -120,6 +155,16 @@ private:
      */
     Value *computeValue(const Term *term, const ReachingDefinitions &definitions);
 
+    /**
+     * Actually computes the value of the given term.
+     *
+     * \param term          Valid pointer to a term.
+     * \param definitions   Reaching definitions.
+     *
+     * \return Valid pointer to the computed value, owned by dataflow().
+     */
+    Value *doComputeValue(const Term *term, const ReachingDefinitions &definitions);
+
     /**
      * Computes the memory location of the given term.
      *
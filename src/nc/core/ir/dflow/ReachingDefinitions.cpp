@@ -42,13 +42,15 @@ void ReachingDefinitions::addDefinition(const MemoryLocation &mloc, const Term *
     assert(mloc);
 
     killDefinitions(mloc);
-    
-    auto i = std::lower_bound(chunks_.begin(), chunks_.end(), mloc,
+
+    auto &chunks = detachChunks();
+
+    auto i = std::lower_bound(chunks.begin(), chunks.end(), mloc,
         [](const Chunk &a, const MemoryLocation &b) -> bool {
             return a.location() < b;
         });
 
-    chunks_.insert(i, Chunk(mloc, std::vector<const Term *>(1, term)));
+    chunks.insert(i, Chunk(mloc, std::vector<const Term *>(1, term)));
 
     selfTest();
 }
@@ -56,37 +58,44 @@ void ReachingDefinitions::addDefinition(const MemoryLocation &mloc, const Term *
 void ReachingDefinitions::killDefinitions(const MemoryLocation &mloc) {
     assert(mloc);
 
-    if (chunks_.empty()) {
+    if (std::none_of(this->chunks().begin(), this->chunks().end(),
+            [&](const Chunk &chunk) -> bool { return mloc.overlaps(chunk.location()); })) {
         return;
     }
 
-    std::vector<Chunk> result;
-    result.reserve(chunks_.size() + 1);
+    auto &chunks = detachChunks();
+
+    for (std::size_t i = 0; i < chunks.size(); ) {
+        const Chunk &chunk = chunks[i];
 
-    foreach (auto &chunk, chunks_) {
         if (!mloc.overlaps(chunk.location())) {
-            result.push_back(std::move(chunk));
+            ++i;
+            continue;
+        }
+
+        /* Parts of the chunk's location not covered by mloc keep the chunk's terms. */
+        bool hasHead = chunk.location().addr() < mloc.addr();
+        bool hasTail = mloc.endAddr() < chunk.location().endAddr();
+
+        if (hasHead && hasTail) {
+            Chunk tail(MemoryLocation(mloc.domain(), mloc.endAddr(), chunk.location().endAddr() - mloc.endAddr()), chunk);
+            chunks[i] = Chunk(MemoryLocation(mloc.domain(), chunk.location().addr(), mloc.addr() - chunk.location().addr()), chunk);
+            chunks.insert(chunks.begin() + i + 1, std::move(tail));
+            i += 2;
+        } else if (hasHead) {
+            chunks[i] = Chunk(MemoryLocation(mloc.domain(), chunk.location().addr(), mloc.addr() - chunk.location().addr()), chunk);
+            ++i;
+        } else if (hasTail) {
+            chunks[i] = Chunk(MemoryLocation(mloc.domain(), mloc.endAddr(), chunk.location().endAddr() - mloc.endAddr()), chunk);
+            ++i;
         } else {
-            if (chunk.location().addr() < mloc.addr()) {
-                if (mloc.endAddr() < chunk.location().endAddr()) {
-                    result.push_back(Chunk(
-                        MemoryLocation(mloc.domain(), chunk.location().addr(), mloc.addr() - chunk.location().addr()),
-                        chunk.definitions()));
-                } else {
-                    result.push_back(Chunk(
-                        MemoryLocation(mloc.domain(), chunk.location().addr(), mloc.addr() - chunk.location().addr()),
-                        std::move(chunk.definitions())));
-                }
-            }
-            if (mloc.endAddr() < chunk.location().endAddr()) {
-                result.push_back(Chunk(
-                    MemoryLocation(mloc.domain(), mloc.endAddr(), chunk.location().endAddr() - mloc.endAddr()),
-                    std::move(chunk.definitions())));
-            }
+            chunks.erase(chunks.begin() + i);
         }
     }
 
-    chunks_ = std::move(result);
+    if (chunks.empty()) {
+        chunks_.reset();
+    }
 
     selfTest();
 }
@@ -94,29 +103,32 @@ void ReachingDefinitions::killDefinitions(const MemoryLocation &mloc) {
 void ReachingDefinitions::project(const MemoryLocation &mloc, ReachingDefinitions &result) const {
     assert(mloc);
 
-    result.clear();
+    std::vector<Chunk> chunks;
 
-    foreach (const auto &chunk, chunks_) {
+    foreach (const auto &chunk, this->chunks()) {
         if (chunk.location().domain() == mloc.domain()) {
             auto addr = std::max(chunk.location().addr(), mloc.addr());
             auto endAddr = std::min(chunk.location().endAddr(), mloc.endAddr());
 
             if (addr < endAddr) {
-                result.chunks_.push_back(Chunk(
-                    MemoryLocation(mloc.domain(), addr, endAddr - addr),
-                    chunk.definitions()));
+                chunks.push_back(Chunk(MemoryLocation(mloc.domain(), addr, endAddr - addr), chunk));
             }
         }
     }
 
+    /* Keep sharing the old list if nothing has changed. */
+    if (chunks != result.chunks()) {
+        result.setChunks(std::move(chunks));
+    }
+
     result.selfTest();
 }
 
 std::vector<MemoryLocation> ReachingDefinitions::getDefinedMemoryLocationsWithin(Domain domain) const {
     std::vector<MemoryLocation> result;
-    result.reserve(chunks_.size());
+    result.reserve(chunks().size());
 
-    foreach (const auto &chunk, chunks_) {
+    foreach (const auto &chunk, chunks()) {
         if (chunk.location().domain() == domain) {
             result.push_back(chunk.location());
         }
@@ -128,14 +140,22 @@ std::vector<MemoryLocation> ReachingDefinitions::getDefinedMemoryLocationsWithin
 void ReachingDefinitions::merge(const ReachingDefinitions &those) {
     selfTest();
 
+    if (chunks_ == those.chunks_ || those.empty()) {
+        return;
+    }
+    if (empty()) {
+        chunks_ = those.chunks_;
+        return;
+    }
+
     std::vector<Chunk> result;
-    result.reserve(chunks_.size() + those.chunks_.size());
+    result.reserve(chunks_->size() + those.chunks_->size());
 
-    auto i = chunks_.begin();
-    auto iend = chunks_.end();
+    auto i = chunks_->begin();
+    auto iend = chunks_->end();
 
-    auto j = those.chunks_.begin();
-    auto jend = those.chunks_.end();
+    auto j = those.chunks_->begin();
+    auto jend = those.chunks_->end();
 
     while (i != iend || j != jend) {
         auto a = i != iend ? i->location() : MemoryLocation();
@@ -152,54 +172,87 @@ void ReachingDefinitions::merge(const ReachingDefinitions &those) {
         }
 
         if (!b) {
-            result.push_back(Chunk(a, i->definitions()));
+            result.push_back(Chunk(a, *i));
             ++i;
         } else if (!a) {
-            result.push_back(Chunk(b, j->definitions()));
+            result.push_back(Chunk(b, *j));
             ++j;
         } else if (a.domain() < b.domain()) {
-            result.push_back(Chunk(a, i->definitions()));
+            result.push_back(Chunk(a, *i));
             ++i;
         } else if (b.domain() < a.domain()) {
-            result.push_back(Chunk(b, j->definitions()));
+            result.push_back(Chunk(b, *j));
             ++j;
         } else if (a.endAddr() <= b.addr()) {
-            result.push_back(Chunk(a, i->definitions()));
+            result.push_back(Chunk(a, *i));
             ++i;
         } else if (b.endAddr() <= a.addr()) {
-            result.push_back(Chunk(b, j->definitions()));
+            result.push_back(Chunk(b, *j));
             ++j;
         } else if (a.addr() < b.addr()) {
-            result.push_back(Chunk(MemoryLocation(a.domain(), a.addr(), b.addr() - a.addr()), i->definitions()));
+            result.push_back(Chunk(MemoryLocation(a.domain(), a.addr(), b.addr() - a.addr()), *i));
         } else if (b.addr() < a.addr()) {
-            result.push_back(Chunk(MemoryLocation(b.domain(), b.addr(), a.addr() - b.addr()), j->definitions()));
+            result.push_back(Chunk(MemoryLocation(b.domain(), b.addr(), a.addr() - b.addr()), *j));
         } else {
-            std::vector<const Term *> merged;
-            merged.reserve(i->definitions().size() + j->definitions().size());
-            std::set_union(i->definitions().begin(), i->definitions().end(), j->definitions().begin(), j->definitions().end(), std::back_inserter(merged));
+            auto location = a.size() <= b.size() ? a : b;
+
+            if (i->sharesDefinitions(*j) || std::includes(i->definitions().begin(), i->definitions().end(),
+                                                          j->definitions().begin(), j->definitions().end())) {
+                result.push_back(Chunk(location, *i));
+            } else if (std::includes(j->definitions().begin(), j->definitions().end(),
+                                     i->definitions().begin(), i->definitions().end())) {
+                result.push_back(Chunk(location, *j));
+            } else {
+                std::vector<const Term *> merged;
+                merged.reserve(i->definitions().size() + j->definitions().size());
+                std::set_union(i->definitions().begin(), i->definitions().end(), j->definitions().begin(), j->definitions().end(), std::back_inserter(merged));
+                result.push_back(Chunk(location, std::move(merged)));
+            }
 
             if (a.size() < b.size()) {
-                result.push_back(Chunk(a, std::move(merged)));
                 ++i;
             } else if (b.size() < a.size()) {
-                result.push_back(Chunk(b, std::move(merged)));
                 ++j;
             } else {
-                result.push_back(Chunk(a, std::move(merged)));
                 ++i;
                 ++j;
             }
         }
     }
 
-    chunks_ = std::move(result);
+    /* Keep sharing the old list if nothing has changed. */
+    if (result != *chunks_) {
+        setChunks(std::move(result));
+    }
 
     selfTest();
 }
 
+void ReachingDefinitions::setChunks(std::vector<Chunk> chunks) {
+    if (chunks.empty()) {
+        chunks_.reset();
+    } else {
+        chunks_ = std::make_shared<std::vector<Chunk>>(std::move(chunks));
+    }
+}
+
+std::vector<ReachingDefinitions::Chunk> &ReachingDefinitions::detachChunks() {
+    if (!chunks_) {
+        chunks_ = std::make_shared<std::vector<Chunk>>();
+    } else if (chunks_.use_count() > 1) {
+        chunks_ = std::make_shared<std::vector<Chunk>>(*chunks_);
+    }
+    return *chunks_;
+}
+
+const std::vector<ReachingDefinitions::Chunk> &ReachingDefinitions::noChunks() {
+    static const std::vector<Chunk> result;
+    return result;
+}
+
 void ReachingDefinitions::print(QTextStream &out) const {
     out << '{';
-    foreach (const auto &chunk, chunks_) {
+    foreach (const auto &chunk, chunks()) {
         out << chunk.location() << ':';
         foreach (const Term *term, chunk.definitions()) {
             out << ' ' << *term;
@@ -27,6 +27,8 @@
 
 #include <algorithm>
 #include <cassert>
+#include <iterator>
+#include <memory>
 #include <vector>
 
 #include <nc/common/Foreach.h>
@@ -44,26 +46,44 @@ namespace dflow {
 
 /**
  * Reaching definitions.
+ *
+ * Objects of this class are cheap to copy: the list of chunks and the lists
+ * of terms in the chunks are shared between the copies. The lists of terms
+ * are immutable. The list of chunks is copied once before being modified in
+ * place, if it is shared; operations producing a new list build it only for
+ * the parts that really change.
  */
 class ReachingDefinitions: public PrintableBase<ReachingDefinitions> {
 public:
-    /*
+    /**
      * Memory location and the list of terms defining this memory location.
      */
     class Chunk {
         MemoryLocation location_; ///< Memory location.
-        std::vector<const Term *> definitions_; ///< Terms defining this memory location.
+        std::shared_ptr<const std::vector<const Term *>> definitions_; ///< Terms defining this memory location.
 
         public:
 
-        /*
+        /**
          * Constructor.
          *
          * \param location      Valid memory location.
          * \param definitions   List of terms defining this memory location.
          */
         Chunk(const MemoryLocation &location, std::vector<const Term *> definitions):
-            location_(location), definitions_(std::move(definitions))
+            location_(location), definitions_(std::make_shared<const std::vector<const Term *>>(std::move(definitions)))
+        {
+            assert(location);
+        }
+
+        /**
+         * Constructor of a chunk sharing the list of terms with another chunk.
+         *
+         * \param location      Valid memory location.
+         * \param chunk         Chunk whose list of terms defines this memory location.
+         */
+        Chunk(const MemoryLocation &location, const Chunk &chunk):
+            location_(location), definitions_(chunk.definitions_)
         {
             assert(location);
         }
@@ -76,12 +96,14 @@ public:
         /**
          * \return List of terms defining the memory location.
          */
-        std::vector<const Term *> &definitions() { return definitions_; }
+        const std::vector<const Term *> &definitions() const { return *definitions_; }
 
         /**
-         * \return List of terms defining the memory location.
+         * \param that Another object of the same type.
+         *
+         * \return True if *this and that share the same list of terms.
          */
-        const std::vector<const Term *> &definitions() const { return definitions_; }
+        bool sharesDefinitions(const Chunk &that) const { return definitions_ == that.definitions_; }
 
         /**
          * \param that Another object of the same type.
@@ -90,7 +112,7 @@ public:
          *         false otherwise.
          */
         bool operator==(const Chunk &that) const {
-            return location_ == that.location_ && definitions_ == that.definitions_;
+            return location_ == that.location_ && (sharesDefinitions(that) || *definitions_ == *that.definitions_);
         }
     };
 
@@ -99,8 +121,10 @@ private:
      * Pairs of memory locations and terms defining them.
      * The pairs are sorted by memory location.
      * Terms are sorted using default comparator.
+     * Can be nullptr, meaning no chunks. Can be shared with other objects,
+     * in which case it must not be modified.
      */
-    std::vector<Chunk> chunks_;
+    std::shared_ptr<std::vector<Chunk>> chunks_;
 
 public:
     /**
@@ -108,17 +132,17 @@ public:
      *         The pairs are sorted by memory location.
      *         Terms are sorted using default comparator.
      */
-    const std::vector<Chunk> &chunks() const { return chunks_; }
+    const std::vector<Chunk> &chunks() const { return chunks_ ? *chunks_ : noChunks(); }
 
     /**
      * \return True if the list of pairs (chunks) is empty, false otherwise.
      */
-    bool empty() const { return chunks_.empty(); }
+    bool empty() const { return !chunks_ || chunks_->empty(); }
 
     /**
      * Clears the reaching definitions.
      */
-    void clear() { chunks_.clear(); }
+    void clear() { chunks_.reset(); }
 
     /**
      * Adds a definition of memory location, removing all previous definitions of overlapping memory locations.
@@ -149,8 +173,6 @@ public:
      *
      * \return A subset of reaching definitions defining (parts of)
      * given memory location.
-     *
-     * \note Prefer using project() as it does less memory allocations.
      */
     ReachingDefinitions projected(const MemoryLocation &memoryLocation) const {
         ReachingDefinitions result;
@@ -177,7 +199,9 @@ public:
      *
      * \param[in] those Reaching definitions.
      */
-    bool operator==(const ReachingDefinitions &those) const { return chunks_ == those.chunks_; }
+    bool operator==(const ReachingDefinitions &those) const {
+        return chunks_ == those.chunks_ || chunks() == those.chunks();
+    }
 
     /**
      * \return True, if these and given reaching definitions are different.
@@ -188,6 +212,7 @@ public:
 
     /**
      * Removes all reaching definitions for which given predicate returns true.
+     * Chunks in which nothing is removed stay shared.
      *
      * \param pred Predicate functor accepting two arguments: a memory location
      *             and a valid pointer to a term covering this location.
@@ -196,30 +221,75 @@ public:
     template<class T>
     void filterOut(const T &pred) {
         selfTest();
-        foreach (auto &chunk, chunks_) {
-            chunk.definitions().erase(
-                std::remove_if(chunk.definitions().begin(), chunk.definitions().end(),
-                    [&](const Term *term) -> bool { return pred(chunk.location(), term); }),
-                chunk.definitions().end());
+
+        if (empty()) {
+            return;
         }
-        chunks_.erase(
-            std::remove_if(chunks_.begin(), chunks_.end(),
-                [](const Chunk &chunk) -> bool { return chunk.definitions().empty(); }),
-            chunks_.end());
+
+        std::vector<Chunk> result;
+        result.reserve(chunks_->size());
+        bool changed = false;
+
+        foreach (const auto &chunk, *chunks_) {
+            auto removed = [&](const Term *term) -> bool { return pred(chunk.location(), term); };
+
+            const auto &definitions = chunk.definitions();
+            auto firstRemoved = std::find_if(definitions.begin(), definitions.end(), removed);
+
+            if (firstRemoved == definitions.end()) {
+                result.push_back(chunk);
+                continue;
+            }
+
+            changed = true;
+
+            std::vector<const Term *> remaining(definitions.begin(), firstRemoved);
+            std::remove_copy_if(firstRemoved + 1, definitions.end(), std::back_inserter(remaining), removed);
+
+            if (!remaining.empty()) {
+                result.push_back(Chunk(chunk.location(), std::move(remaining)));
+            }
+        }
+
+        if (changed) {
+            setChunks(std::move(result));
+        }
+
         selfTest();
     }
 
     void print(QTextStream &out) const;
 
 private:
+    /**
+     * Replaces the list of chunks.
+     *
+     * \param chunks New list of chunks.
+     */
+    void setChunks(std::vector<Chunk> chunks);
+
+    /**
+     * Makes sure that the list of chunks is not shared with other objects,
+     * copying it if necessary.
+     *
+     * \return Reference to the list of chunks, which can be modified in place.
+     */
+    std::vector<Chunk> &detachChunks();
+
+    /**
+     * \return Reference to a static empty list of chunks.
+     */
+    static const std::vector<Chunk> &noChunks();
+
     /**
      * Checks if the data structure is in a valid state.
      * Fails with an assertion if not.
      */
     void selfTest() const {
 #ifndef NDEBUG
-        for (std::size_t i = 1; i < chunks_.size(); ++i) {
-            assert(chunks_[i-1].location() < chunks_[i].location());
+        const auto &chunks = this->chunks();
+        for (std::size_t i = 1; i < chunks.size(); ++i) {
+            assert(chunks[i-1].location() < chunks[i].location());
         }
 #endif
     }
@@ -13,10 +13,13 @@ namespace ir {
 namespace dflow {
 
 Uses::Uses(const Dataflow &dataflow) {
-    foreach (auto &termAndDefinitions, dataflow.term2definitions()) {
-        foreach (const auto &chunk, termAndDefinitions.second.chunks()) {
+    foreach (auto term, dataflow.terms()) {
+        if (!term->isRead()) {
+            continue;
+        }
+        foreach (const auto &chunk, dataflow.getDefinitions(term).chunks()) {
             foreach (const Term *definition, chunk.definitions()) {
-                term2uses_[definition].push_back(Use(chunk.location(), termAndDefinitions.first));
+                term2uses_[definition].push_back(Use(chunk.location(), term));
             }
         }
     }
@@ -76,6 +76,7 @@ bool bitTwiddlingWorks = (NC_UNUSED(bitTwiddlingWorks), testBitTwiddling());
 
 Value::Value(SmallBitSize size):
     abstractValue_(size, -1, -1),
+    stackOffset_(0),
     isStackOffset_(false), isNotStackOffset_(false),
     isProduct_(false), isNotProduct_(false),
     isReturnAddress_(false), isNotReturnAddress_(false)
@@ -102,6 +103,19 @@ void Value::makeStackOffset(SignedConstantValue offset) {
     }
 }
 
+bool Value::operator==(const Value &that) const {
+    return abstractValue_.size() == that.abstractValue_.size() &&
+           abstractValue_.zeroBits() == that.abstractValue_.zeroBits() &&
+           abstractValue_.oneBits() == that.abstractValue_.oneBits() &&
+           isStackOffset_ == that.isStackOffset_ &&
+           isNotStackOffset_ == that.isNotStackOffset_ &&
+           (!isStackOffset_ || stackOffset_ == that.stackOffset_) &&
+           isProduct_ == that.isProduct_ &&
+           isNotProduct_ == that.isNotProduct_ &&
+           isReturnAddress_ == that.isReturnAddress_ &&
+           isNotReturnAddress_ == that.isNotReturnAddress_;
+}
+
 } // namespace dflow
 } // namespace ir
 } // namespace core
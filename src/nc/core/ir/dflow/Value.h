@@ -42,16 +42,16 @@ namespace dflow {
 class Value {
     AbstractValue abstractValue_; ///< Abstract value of the term, in the host byte order.
 
-    bool isStackOffset_; ///< Value is a stack pointer with a known offset from the frame base.
-    bool isNotStackOffset_; ///< Value is not a stack pointer with a known offset from the frame base.
-
     SignedConstantValue stackOffset_; ///< Offset to stack frame base (in bytes), if the value is a stack pointer.
 
-    bool isProduct_; ///< Value was computed via multiplication.
-    bool isNotProduct_; ///< Value was computed not via multiplication.
+    bool isStackOffset_ : 1; ///< Value is a stack pointer with a known offset from the frame base.
+    bool isNotStackOffset_ : 1; ///< Value is not a stack pointer with a known offset from the frame base.
+
+    bool isProduct_ : 1; ///< Value was computed via multiplication.
+    bool isNotProduct_ : 1; ///< Value was computed not via multiplication.
 
-    bool isReturnAddress_; ///< Value is a return address.
-    bool isNotReturnAddress_; ///< Value is not a return address.
+    bool isReturnAddress_ : 1; ///< Value is a return address.
+    bool isNotReturnAddress_ : 1; ///< Value is not a return address.
 
 public:
     /**
@@ -143,6 +143,18 @@ public:
      * Marks the value as being not a return address.
      */
     void makeNotReturnAddress() { isNotReturnAddress_ = true; }
+
+    /**
+     * \param that Another value description.
+     * \return True if both descriptions carry exactly the same information.
+     */
+    bool operator==(const Value &that) const;
+
+    /**
+     * \param that Another value description.
+     * \return True if the descriptions differ.
+     */
+    bool operator!=(const Value &that) const { return !(*this == that); }
 };
 
 } // namespace dflow
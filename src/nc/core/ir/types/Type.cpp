@@ -38,34 +38,34 @@ namespace types {
 void Type::updateSize(SmallBitSize size) {
     if (size && (!size_ || size < size_)) {
         size_ = size;
-        changed_ = true;
+        setChanged();
     }
 }
 
 void Type::makeInteger() {
     if (!isInteger_) {
         isInteger_ = true;
-        changed_ = true;
+        setChanged();
     }
 }
 
 void Type::makeFloat() {
     if (!isFloat_) {
         isFloat_ = true;
-        changed_ = true;
+        setChanged();
     }
 }
 
 void Type::makePointer(Type *pointee) {
     if (!isPointer_) {
         isPointer_ = true;
-        changed_ = true;
+        setChanged();
     }
 
     if (pointee) {
         if (!pointee_) {
             pointee_ = pointee;
-            changed_ = true;
+            setChanged();
         } else {
             pointee_->unionSet(pointee);
         }
@@ -75,14 +75,14 @@ void Type::makePointer(Type *pointee) {
 void Type::makeSigned() {
     if (!isSigned_) {
         isSigned_ = true;
-        changed_ = true;
+        setChanged();
     }
 }
 
 void Type::makeUnsigned() {
     if (!isUnsigned_) {
         isUnsigned_ = true;
-        changed_ = true;
+        setChanged();
     }
 }
 
@@ -105,7 +105,7 @@ void Type::updateFactor(ConstantValue increment) {
     factor_ = gcd(increment, factor_);
 
     if (oldFactor != factor_) {
-        changed_ = true;
+        setChanged();
     }
 }
 
@@ -120,6 +120,15 @@ void Type::addOffset(ByteSize offset, Type *typeTraits) {
 }
 #endif
 
+void Type::setChanged() {
+    if (!changed_) {
+        changed_ = true;
+        if (changes_) {
+            changes_->push_back(this);
+        }
+    }
+}
+
 bool Type::changed() {
     if (changed_) {
         changed_ = false;
@@ -133,13 +142,27 @@ void Type::unionSet(Type *that) {
     Type *thisSet = this->findSet();
     Type *thatSet = that->findSet();
 
+    if (thisSet == thatSet) {
+        return;
+    }
+
     DisjointSet<Type>::unionSet(that);
 
-    if (findSet() == thisSet) {
-        thisSet->join(thatSet);
-    } else {
-        thatSet->join(thisSet);
+    Type *set = findSet();
+    Type *other = set == thisSet ? thatSet : thisSet;
+
+    set->join(other);
+
+    /*
+     * Users of the absorbed type now see the properties of the merged one.
+     */
+    if (set->users_.size() < other->users_.size()) {
+        set->users_.swap(other->users_);
     }
+    set->users_.insert(set->users_.end(), other->users_.begin(), other->users_.end());
+    std::vector<const Term *>().swap(other->users_);
+
+    set->setChanged();
 }
 
 void Type::join(Type *that) {
@@ -25,6 +25,8 @@
 
 #include <nc/config.h>
 
+#include <vector>
+
 #ifdef NC_STRUCT_RECOVERY
 #include <map>
 #endif
@@ -36,6 +38,9 @@
 namespace nc {
 namespace core {
 namespace ir {
+
+class Term;
+
 namespace types {
 
 class Type;
@@ -62,16 +67,23 @@ class Type: public DisjointSet<Type>, public PrintableBase<Type> {
 #endif
 
     bool changed_; ///< Type properties have changed since last call to changed().
+    std::vector<Type *> *changes_; ///< Log of changed types, or nullptr.
+
+    std::vector<const Term *> users_; ///< Terms whose typing rules involve this type (valid for representatives).
 
     public:
 
     /**
      * Class constructor.
+     *
+     * \param[in] changes Pointer to a log where the type appends itself
+     *                    when its properties change. Can be nullptr.
      */
-    Type():
+    explicit Type(std::vector<Type *> *changes = nullptr):
         size_(0),
         isInteger_(false), isFloat_(false), isPointer_(false), pointee_(0),
-        isSigned_(false), isUnsigned_(false), factor_(0), changed_(false)
+        isSigned_(false), isUnsigned_(false), factor_(0), changed_(false),
+        changes_(changes)
     { 
 #ifdef NC_STRUCT_RECOVERY
         addOffset(0, this); 
@@ -184,6 +196,19 @@ class Type: public DisjointSet<Type>, public PrintableBase<Type> {
      */
     bool changed();
 
+    /**
+     * Remembers that the typing rule of the given term involves this type.
+     *
+     * \param[in] term Valid pointer to a term.
+     */
+    void addUser(const Term *term) { findSet()->users_.push_back(term); }
+
+    /**
+     * \return Terms whose typing rules involve types merged into this one.
+     *          Complete only for the representative of the set.
+     */
+    const std::vector<const Term *> &users() const { return users_; }
+
     /**
      * Merges this and that types together.
      *
@@ -204,6 +229,13 @@ class Type: public DisjointSet<Type>, public PrintableBase<Type> {
      * \param out Output stream.
      */
     void print(QTextStream &out) const;
+
+    private:
+
+    /**
+     * Marks the properties of this type as changed.
+     */
+    void setChanged();
 };
 
 } // namespace types
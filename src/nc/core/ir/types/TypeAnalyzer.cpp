@@ -24,6 +24,8 @@
 
 #include "TypeAnalyzer.h"
 
+#include <boost/unordered_set.hpp>
+
 #include <nc/common/CancellationToken.h>
 #include <nc/common/Foreach.h>
 
@@ -57,22 +59,50 @@ void TypeAnalyzer::analyze() {
     uniteVariableTypes();
     uniteArgumentTypes();
     markStackPointersAsPointers();
+    registerUsers();
 
     /*
-     * Recompute types until reaching fixpoint.
+     * The first round looks at every live term anyway.
      */
-    bool changed;
-    do {
-        changed = false;
+    foreach (Type *type, types_.changes()) {
+        type->changed();
+    }
+    types_.changes().clear();
 
-        foreach (const Function *function, functions_.list()) {
-            while (analyze(function)) {
-                changed = true;
-                canceled_.poll();
-            }
-            canceled_.poll();
+    ++rounds_;
+    foreach (const Function *function, functions_.list()) {
+        analyze(function);
+        canceled_.poll();
+    }
+
+    /*
+     * Recompute types of the terms affected by changes until reaching fixpoint.
+     */
+    std::vector<const Term *> terms;
+    takeChanges(terms);
+
+    while (!terms.empty()) {
+        ++rounds_;
+
+        std::vector<const Term *> round;
+        round.swap(terms);
+
+        foreach (const Term *term, round) {
+            analyze(term);
         }
-    } while (changed);
+        canceled_.poll();
+
+        takeChanges(terms);
+    }
+
+    /*
+     * Compress the paths in the disjoint sets, so that finding
+     * the representatives does not modify them anymore and can
+     * be done concurrently by the code generator.
+     */
+    foreach (const auto &termAndType, types_.map()) {
+        termAndType.second->findSet();
+    }
 }
 
 void TypeAnalyzer::uniteTypesOfAssignedTerms() {
@@ -162,7 +192,49 @@ void TypeAnalyzer::markStackPointersAsPointers() {
     }
 }
 
-bool TypeAnalyzer::analyze(const Function *function) {
+void TypeAnalyzer::registerUsers() {
+    foreach (const auto &functionAndLiveness, livenesses_) {
+        foreach (const Term *term, functionAndLiveness.second->liveTerms()) {
+            types_.getType(term)->addUser(term);
+
+            switch (term->kind()) {
+                case Term::DEREFERENCE:
+                    types_.getType(term->asDereference()->address())->addUser(term);
+                    break;
+                case Term::UNARY_OPERATOR:
+                    types_.getType(term->asUnaryOperator()->operand())->addUser(term);
+                    break;
+                case Term::BINARY_OPERATOR:
+                    types_.getType(term->asBinaryOperator()->left())->addUser(term);
+                    types_.getType(term->asBinaryOperator()->right())->addUser(term);
+                    break;
+                default:
+                    break;
+            }
+        }
+    }
+}
+
+void TypeAnalyzer::takeChanges(std::vector<const Term *> &terms) {
+    /*
+     * A type is logged at most once until its changed() is called,
+     * and a term may use several changed types: filter out duplicates.
+     */
+    boost::unordered_set<const Term *> seen(terms.begin(), terms.end());
+
+    foreach (Type *type, types_.changes()) {
+        if (type->changed()) {
+            foreach (const Term *term, type->findSet()->users()) {
+                if (seen.insert(term).second) {
+                    terms.push_back(term);
+                }
+            }
+        }
+    }
+    types_.changes().clear();
+}
+
+void TypeAnalyzer::analyze(const Function *function) {
     const auto &liveness = *livenesses_.at(function);
 
     /*
@@ -175,17 +247,11 @@ bool TypeAnalyzer::analyze(const Function *function) {
     reverse_foreach (const Term *term, liveness.liveTerms()) {
         analyze(term);
     }
-
-    bool changed = false;
-    foreach (const Term *term, liveness.liveTerms()) {
-        if (types_.getType(term)->changed()) {
-            changed = true;
-        }
-    }
-    return changed;
 }
 
 void TypeAnalyzer::analyze(const Term *term) {
+    ++visits_;
+
     switch (term->kind()) {
         case Term::INT_CONST: /* FALLTHROUGH */
         case Term::INTRINSIC: /* FALLTHROUGH */
@@ -25,6 +25,9 @@
 
 #include <nc/config.h>
 
+#include <cstddef>
+#include <vector>
+
 namespace nc {
 
 class CancellationToken;
@@ -71,6 +74,8 @@ class TypeAnalyzer {
     const calling::Hooks &hooks_; ///< Hooks manager.
     const calling::Signatures &signatures_; ///< Signatures of functions.
     const CancellationToken &canceled_;
+    std::size_t rounds_; ///< Number of rounds of recomputation performed.
+    std::size_t visits_; ///< Number of recomputations of terms' types performed.
 
 public:
     /**
@@ -91,14 +96,29 @@ public:
         const CancellationToken &canceled
     ):
         types_(types), functions_(functions), dataflows_(dataflows), variables_(variables),
-        livenesses_(livenesses), hooks_(hooks), signatures_(signatures), canceled_(canceled)
+        livenesses_(livenesses), hooks_(hooks), signatures_(signatures), canceled_(canceled),
+        rounds_(0), visits_(0)
     {}
 
     /**
      * Computes type traits for all terms in all functions.
+     *
+     * The first round recomputes the types of all live terms.
+     * Each next round recomputes only the types of the terms
+     * whose typing rules involve a type changed in the previous round.
      */
     void analyze();
 
+    /**
+     * \return Number of rounds of recomputation performed by analyze().
+     */
+    std::size_t rounds() const { return rounds_; }
+
+    /**
+     * \return Number of recomputations of terms' types performed by analyze().
+     */
+    std::size_t visits() const { return visits_; }
+
 private:
     /**
      * Unites types of terms assigned to each other.
@@ -121,14 +141,25 @@ private:
      */
     void markStackPointersAsPointers();
 
+    /**
+     * Registers live terms as users of the types involved in their typing rules.
+     */
+    void registerUsers();
+
+    /**
+     * Empties the log of changed types, appending the users of each
+     * changed type to the given list of terms.
+     *
+     * \param[out] terms List of terms to recompute types of.
+     */
+    void takeChanges(std::vector<const Term *> &terms);
+
     /**
      * Recomputes types of terms in the given function.
      *
      * \param function Valid pointer to a function.
-     *
-     * \return True if types changed, false otherwise.
      */
-    bool analyze(const Function *function);
+    void analyze(const Function *function);
 
     /**
      * Recomputes type of the given term.
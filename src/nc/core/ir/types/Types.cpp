@@ -24,6 +24,8 @@
 
 #include "Types.h"
 
+#include <QMutexLocker>
+
 #include <nc/core/ir/Term.h>
 
 #include "Type.h"
@@ -40,7 +42,7 @@ Types::~Types() {}
 Type *Types::getType(const Term *term) {
     auto &type = types_[term];
     if (!type) {
-        type.reset(new Type());
+        type.reset(new Type(&changes_));
         type->updateSize(term->size());
         return type.get();
     } else {
@@ -49,6 +51,8 @@ Type *Types::getType(const Term *term) {
 }
 
 const Type *Types::getType(const Term *term) const {
+    QMutexLocker locker(&mutex_);
+
     return const_cast<Types *>(this)->getType(term);
 }
 
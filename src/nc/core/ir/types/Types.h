@@ -23,8 +23,13 @@
 
 #pragma once
 
+#include <memory>
+#include <vector>
+
 #include <boost/unordered_map.hpp>
 
+#include <QMutex>
+
 namespace nc {
 namespace core {
 namespace ir {
@@ -40,6 +45,8 @@ class Type;
  */
 class Types {
     mutable boost::unordered_map<const Term *, std::unique_ptr<Type> > types_; ///< Mapping of terms to their type traits.
+    std::vector<Type *> changes_; ///< Types whose properties have changed.
+    mutable QMutex mutex_; ///< Mutex protecting the lookups via the const getType().
 
     public:
 
@@ -64,6 +71,8 @@ class Types {
      * \param[in] term Term.
      *
      * \return Valid pointer to type traits for this term.
+     *
+     * This function may be called concurrently.
      */
     const Type *getType(const Term *term) const;
 
@@ -71,6 +80,13 @@ class Types {
      * \return Mapping of terms to their type traits.
      */
     boost::unordered_map<const Term *, std::unique_ptr<Type> > &map() { return types_; };
+
+    /**
+     * \return Log of types whose properties have changed, in the order of changes.
+     *          A type is logged again only after its changed() has been called.
+     *          The log is never cleared by this class.
+     */
+    std::vector<Type *> &changes() { return changes_; }
 };
 
 }}}} // namespace nc::core::ir::types
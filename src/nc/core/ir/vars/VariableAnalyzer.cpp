@@ -63,9 +63,8 @@ void VariableAnalyzer::analyze() {
         /*
          * Make a set for each read or write term which has a memory location.
          */
-        foreach (const auto &termAndLocation, dataflow.term2location()) {
-            const auto &term = termAndLocation.first;
-            const auto &location = termAndLocation.second;
+        foreach (auto term, dataflow.terms()) {
+            const auto &location = dataflow.getMemoryLocation(term);
 
             if ((term->isRead() || term->isWrite()) && location) {
                 if (architecture_->isGlobalMemory(location)) {
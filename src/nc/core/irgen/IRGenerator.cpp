@@ -24,13 +24,19 @@
 
 #include "IRGenerator.h"
 
+#include <algorithm>
 #include <cassert>
 #include <queue>
 
+#include <QStringList>
+
 #include <boost/range/algorithm_ext/is_sorted.hpp>
 #include <boost/unordered_set.hpp>
 
+#include <nc/common/Arena.h>
 #include <nc/common/Foreach.h>
+#include <nc/common/LogToken.h>
+#include <nc/common/Parallel.h>
 #include <nc/common/Range.h>
 #include <nc/common/make_unique.h>
 
@@ -50,6 +56,7 @@
 #include <nc/core/ir/misc/PatternRecognition.h>
 
 #include "InstructionAnalyzer.h"
+#include "InvalidInstructionException.h"
 
 namespace nc {
 namespace core {
@@ -57,7 +64,8 @@ namespace irgen {
 
 IRGenerator::IRGenerator(const image::Image *image, const arch::Instructions *instructions, ir::Program *program,
     const CancellationToken &canceled, const LogToken &log):
-    image_(image), instructions_(instructions), program_(program), canceled_(canceled), log_(log)
+    image_(image), instructions_(instructions), program_(program), canceled_(canceled), log_(log),
+    threadCount_(1)
 {
     assert(image);
     assert(instructions);
@@ -67,7 +75,9 @@ IRGenerator::IRGenerator(const image::Image *image, const arch::Instructions *in
 IRGenerator::~IRGenerator() {}
 
 void IRGenerator::generate() {
-    image_->platform().architecture()->createInstructionAnalyzer()->createStatements(instructions_, program_, canceled_, log_);
+    createStatements();
+
+    Arena::Scope scope(program_->arena());
 
 #ifndef NDEBUG
     /*
@@ -81,11 +91,7 @@ void IRGenerator::generate() {
     }
 #endif
 
-    /* Compute jump targets. */
-    foreach (auto basicBlock, program_->basicBlocks()) {
-        computeJumpTargets(basicBlock);
-        canceled_.poll();
-    }
+    computeJumpTargets(std::vector<ir::BasicBlock *>(program_->basicBlocks().begin(), program_->basicBlocks().end()));
 
 #ifndef NDEBUG
     /*
@@ -107,7 +113,152 @@ void IRGenerator::generate() {
     }
 }
 
-void IRGenerator::computeJumpTargets(ir::BasicBlock *basicBlock) {
+namespace {
+
+/** Minimal number of instructions lifted by a thread. */
+const std::size_t MIN_INSTRUCTIONS_PER_THREAD = 1 << 14;
+
+} // anonymous namespace
+
+void IRGenerator::createStatements() {
+    auto architecture = image_->platform().architecture();
+
+    std::size_t shardCount = std::min<std::size_t>(
+        instructions_->size() / MIN_INSTRUCTIONS_PER_THREAD, static_cast<std::size_t>(threadCount_) * 4);
+
+    if (threadCount_ <= 1 || shardCount < 2) {
+        Arena::Scope scope(program_->arena());
+        architecture->createInstructionAnalyzer()->createStatements(instructions_, program_, canceled_, log_);
+        return;
+    }
+
+    std::vector<const arch::Instruction *> instructions;
+    instructions.reserve(instructions_->size());
+    foreach (const auto &instruction, instructions_->all()) {
+        instructions.push_back(instruction.get());
+    }
+
+    std::vector<std::unique_ptr<ir::Program>> shards(shardCount);
+    std::vector<QStringList> warnings(shardCount);
+
+    parallelFor(shardCount, threadCount_, [&](std::size_t i) {
+        auto begin = instructions.size() * i / shardCount;
+        auto end = instructions.size() * (i + 1) / shardCount;
+
+        auto analyzer = architecture->createInstructionAnalyzer();
+
+        shards[i] = std::make_unique<ir::Program>();
+        Arena::Scope scope(shards[i]->arena());
+
+        for (auto j = begin; j != end; ++j) {
+            try {
+                analyzer->createStatements(instructions[j], shards[i].get());
+            } catch (const InvalidInstructionException &e) {
+                warnings[i].append(e.unicodeWhat());
+            }
+            canceled_.poll();
+        }
+    });
+
+    /* Statements allocated from the shards' arenas stay valid after the shards are gone. */
+    for (std::size_t i = 0; i < shardCount; ++i) {
+        foreach (const QString &warning, warnings[i]) {
+            log_.warning(warning);
+        }
+        program_->append(*shards[i]);
+        shards[i].reset();
+    }
+}
+
+std::vector<ir::BasicBlock *> IRGenerator::computeJumpTargets(std::vector<ir::BasicBlock *> basicBlocks) {
+    std::vector<ir::BasicBlock *> analyzed;
+
+    while (!basicBlocks.empty()) {
+        std::vector<Discoveries> discoveries(basicBlocks.size());
+
+        parallelFor(basicBlocks.size(), threadCount_, [&](std::size_t i) {
+            std::unique_ptr<arch::Disassembler> disassembler;
+            computeJumpTargets(basicBlocks[i], discoveries[i], disassembler);
+            canceled_.poll();
+        });
+
+        /*
+         * Basic blocks are appended to the program when created,
+         * including the ones split off existing basic blocks.
+         */
+        const ir::BasicBlock *last = program_->basicBlocks().back();
+
+        foreach (const auto &blockDiscoveries, discoveries) {
+            apply(blockDiscoveries);
+        }
+
+        analyzed.insert(analyzed.end(), basicBlocks.begin(), basicBlocks.end());
+
+        /*
+         * A basic block with statements appended here has been split off
+         * another one. Targets of its jumps were computed using dataflow
+         * information from the statements before the split point, which
+         * do not precede the jumps anymore. Compute them again from the
+         * start of the new basic block. Called addresses found this way
+         * are kept.
+         */
+        basicBlocks.clear();
+        for (auto i = ++program_->basicBlocks().get_iterator(last); i != program_->basicBlocks().end(); ++i) {
+            resetJumpTargets(*i);
+            basicBlocks.push_back(*i);
+        }
+        canceled_.poll();
+    }
+
+    return analyzed;
+}
+
+void IRGenerator::apply(const Discoveries &discoveries) {
+    foreach (ByteAddr address, discoveries.calledAddresses) {
+        program_->addCalledAddress(address);
+        program_->createBasicBlock(address);
+    }
+
+    foreach (const auto &targetAndAddress, discoveries.jumps) {
+        targetAndAddress.first->setBasicBlock(program_->createBasicBlock(targetAndAddress.second));
+    }
+
+    foreach (const auto &targetAndEntries, discoveries.tables) {
+        auto table = std::make_unique<ir::JumpTable>();
+
+        foreach (ByteAddr targetAddress, targetAndEntries.second) {
+            table->push_back(ir::JumpTableEntry(targetAddress, program_->createBasicBlock(targetAddress)));
+        }
+        targetAndEntries.first->setTable(std::move(table));
+    }
+
+    foreach (ByteAddr address, discoveries.blockAddresses) {
+        program_->createBasicBlock(address);
+    }
+}
+
+void IRGenerator::resetJumpTargets(ir::BasicBlock *basicBlock) {
+    assert(basicBlock != nullptr);
+
+    auto resetJumpTarget = [](ir::JumpTarget &target) {
+        if (target.address()) {
+            target.setBasicBlock(nullptr);
+            target.setTable(nullptr);
+        }
+    };
+
+    foreach (auto statement, basicBlock->statements()) {
+        if (statement->is<ir::Jump>()) {
+            auto jump = statement->as<ir::Jump>();
+            resetJumpTarget(jump->thenTarget());
+            resetJumpTarget(jump->elseTarget());
+        }
+    }
+}
+
+void IRGenerator::computeJumpTargets(ir::BasicBlock *basicBlock, Discoveries &discoveries,
+                                     std::unique_ptr<arch::Disassembler> &disassembler) const
+{
     assert(basicBlock != nullptr);
 
     /* Prepare context for quick and dirty dataflow analysis. */
@@ -133,14 +284,10 @@ void IRGenerator::computeJumpTargets(ir::BasicBlock *basicBlock) {
 
                 /* Record information about the function entry. */
                 if (addressValue->abstractValue().isConcrete()) {
-                    ByteAddr address = addressValue->abstractValue().asConcrete().value();
-
-                    program_->addCalledAddress(address);
-                    program_->createBasicBlock(address);
+                    discoveries.calledAddresses.push_back(addressValue->abstractValue().asConcrete().value());
                 } else {
-                    foreach (ByteAddr address, getJumpTableEntries(call->target(), dataflow)) {
-                        program_->addCalledAddress(address);
-                        program_->createBasicBlock(address);
+                    foreach (ByteAddr address, getJumpTableEntries(call->target(), dataflow, disassembler)) {
+                        discoveries.calledAddresses.push_back(address);
                     }
                 }
 
@@ -155,41 +302,40 @@ void IRGenerator::computeJumpTargets(ir::BasicBlock *basicBlock) {
                 auto jump = statement->as<ir::Jump>();
 
                 /* If the target basic block is unknown, try to guess it. */
-                computeJumpTarget(jump->thenTarget(), dataflow);
-                computeJumpTarget(jump->elseTarget(), dataflow);
+                computeJumpTarget(jump->thenTarget(), dataflow, discoveries, disassembler);
+                computeJumpTarget(jump->elseTarget(), dataflow, discoveries, disassembler);
 
                 break;
             }
         }
 
         if (statement->isTerminator() && statement->basicBlock()->address() && statement->instruction()) {
-            program_->createBasicBlock(statement->instruction()->endAddr());
+            discoveries.blockAddresses.push_back(statement->instruction()->endAddr());
         }
     }
 }
 
-void IRGenerator::computeJumpTarget(ir::JumpTarget &target, const ir::dflow::Dataflow &dataflow) {
+void IRGenerator::computeJumpTarget(ir::JumpTarget &target, const ir::dflow::Dataflow &dataflow, Discoveries &discoveries,
+                                    std::unique_ptr<arch::Disassembler> &disassembler) const
+{
     if (target.address() && !target.basicBlock() && !target.table()) {
         const ir::dflow::Value *addressValue = dataflow.getValue(target.address());
 
         if (addressValue->abstractValue().isConcrete()) {
-            target.setBasicBlock(program_->createBasicBlock(addressValue->abstractValue().asConcrete().value()));
+            discoveries.jumps.push_back(std::make_pair(&target, addressValue->abstractValue().asConcrete().value()));
         } else {
-            auto entries = getJumpTableEntries(target.address(), dataflow);
+            auto entries = getJumpTableEntries(target.address(), dataflow, disassembler);
 
             if (!entries.empty()) {
-                auto table = std::make_unique<ir::JumpTable>();
-
-                foreach (ByteAddr targetAddress, entries) {
-                    table->push_back(ir::JumpTableEntry(targetAddress, program_->createBasicBlock(targetAddress)));
-                }
-                target.setTable(std::move(table));
+                discoveries.tables.push_back(std::make_pair(&target, std::move(entries)));
             }
         }
     }
 }
 
-std::vector<ByteAddr> IRGenerator::getJumpTableEntries(const ir::Term *target, const ir::dflow::Dataflow &dataflow) {
+std::vector<ByteAddr> IRGenerator::getJumpTableEntries(const ir::Term *target, const ir::dflow::Dataflow &dataflow,
+                                                       std::unique_ptr<arch::Disassembler> &disassembler) const
+{
     std::vector<ByteAddr> result;
 
     auto arrayAccess = ir::misc::recognizeArrayAccess(target, dataflow);
@@ -207,7 +353,7 @@ std::vector<ByteAddr> IRGenerator::getJumpTableEntries(const ir::Term *target, c
 
     ByteAddr address = arrayAccess.base();
     while (auto entry = reader.readInt<ByteAddr>(address, entrySize, byteOrder)) {
-        if (!isInstructionAddress(*entry)) {
+        if (!isInstructionAddress(*entry, disassembler)) {
             break;
         }
         result.push_back(*entry);
@@ -222,7 +368,7 @@ std::vector<ByteAddr> IRGenerator::getJumpTableEntries(const ir::Term *target, c
     return result;
 }
 
-bool IRGenerator::isInstructionAddress(ByteAddr address) {
+bool IRGenerator::isInstructionAddress(ByteAddr address, std::unique_ptr<arch::Disassembler> &disassembler) const {
     if (instructions_->get(address)) {
         return true;
     }
@@ -232,11 +378,11 @@ bool IRGenerator::isInstructionAddress(ByteAddr address) {
         return false;
     }
 
-    if (!disassembler_) {
-        disassembler_ = image_->platform().architecture()->createDisassembler();
+    if (!disassembler) {
+        disassembler = image_->platform().architecture()->createDisassembler();
     }
 
-    return disassembler_->disassembleSingleInstruction(address, section) != nullptr;
+    return disassembler->disassembleSingleInstruction(address, section) != nullptr;
 }
 
 void IRGenerator::addJumpToDirectSuccessor(ir::BasicBlock *basicBlock) {
@@ -28,6 +28,8 @@
 #include <QCoreApplication>
 
 #include <cassert>
+#include <memory>
+#include <utility>
 #include <vector>
 
 #include <nc/common/CancellationToken.h>
@@ -70,7 +72,7 @@ class IRGenerator {
     ir::Program *program_; ///< Program.
     const CancellationToken &canceled_; ///< Cancellation token.
     const LogToken &log_; ///< Log token.
-    std::unique_ptr<arch::Disassembler> disassembler_; ///< Disassembler.
+    int threadCount_; ///< Maximal number of threads for lifting instructions and resolving jump targets.
 
 public:
     /**
@@ -96,39 +98,122 @@ public:
      */
     void generate();
 
+    /**
+     * Sets the maximal number of threads that may be used for lifting
+     * instructions into statements and resolving jump targets.
+     * 1 means no concurrency.
+     *
+     * \param threadCount Number of threads, must be positive.
+     */
+    void setThreadCount(int threadCount) { assert(threadCount > 0); threadCount_ = threadCount; }
+
+    /**
+     * Computes jump targets in the given basic blocks of the program and
+     * in the basic blocks created while doing so. Targets computed before
+     * are kept. Allows extending a program with newly lifted instructions
+     * without analyzing the basic blocks that did not change.
+     *
+     * The basic blocks are analyzed in parallel, without modifying
+     * the program. The discovered targets are then applied to the program
+     * serially. The basic blocks created while doing so, including the ones
+     * split off existing basic blocks, are analyzed in the next round, until
+     * no new basic blocks appear. Targets of the jumps in the split off
+     * basic blocks are computed anew, so that they do not depend on the
+     * statements before the split point.
+     *
+     * \param basicBlocks Basic blocks of the program to analyze.
+     *
+     * \return All the basic blocks analyzed, in the order of analysis.
+     */
+    std::vector<ir::BasicBlock *> computeJumpTargets(std::vector<ir::BasicBlock *> basicBlocks);
+
 private:
+    /**
+     * Lifts the instructions into statements of the program, splitting
+     * the work between threads if the thread count allows it.
+     *
+     * Each thread lifts a contiguous range of instructions into a program
+     * of its own, using its own instruction analyzer. The programs are
+     * then appended to the resulting program in the order of addresses,
+     * which gives the same result as lifting all the instructions serially.
+     */
+    void createStatements();
+
+    /**
+     * Results of the local analysis of a basic block, to be applied to the program.
+     */
+    struct Discoveries {
+        /** Addresses of called functions. */
+        std::vector<ByteAddr> calledAddresses;
+
+        /** Jump targets with the addresses they point to. */
+        std::vector<std::pair<ir::JumpTarget *, ByteAddr>> jumps;
+
+        /** Jump targets with the entries of the jump tables they use. */
+        std::vector<std::pair<ir::JumpTarget *, std::vector<ByteAddr>>> tables;
+
+        /** Addresses where basic blocks must start. */
+        std::vector<ByteAddr> blockAddresses;
+    };
+
     /**
      * Computes jump targets in the basic block.
      *
-     * \param basicBlock Valid pointer to a basic block.
+     * \param[in] basicBlock Valid pointer to a basic block.
+     * \param[out] discoveries Discovered jump targets and called addresses.
+     * \param[in,out] disassembler Disassembler for checking instruction addresses, created on demand.
      */
-    void computeJumpTargets(ir::BasicBlock *basicBlock);
+    void computeJumpTargets(ir::BasicBlock *basicBlock, Discoveries &discoveries,
+                            std::unique_ptr<arch::Disassembler> &disassembler) const;
 
     /**
-     * Sets the basic block or jump table fields in the jump target,
+     * Computes the basic block or jump table the jump target must point to,
      * based on the address expression and some guessing.
      *
-     * \param[in,out] target   Jump target.
-     * \param[in]     dataflow Dataflow information collected up to the point where jump has been met.
+     * \param[in]     target       Jump target.
+     * \param[in]     dataflow     Dataflow information collected up to the point where jump has been met.
+     * \param[out]    discoveries  Discovered jump targets.
+     * \param[in,out] disassembler Disassembler for checking instruction addresses, created on demand.
      */
-    void computeJumpTarget(ir::JumpTarget &target, const ir::dflow::Dataflow &dataflow);
+    void computeJumpTarget(ir::JumpTarget &target, const ir::dflow::Dataflow &dataflow, Discoveries &discoveries,
+                           std::unique_ptr<arch::Disassembler> &disassembler) const;
 
     /**
      * Determines jump table address and recovers its entries in a form of a vector of addresses.
      *
      * \param[in] target Valid pointer to a term representing the jump target.
      * \param[in] dataflow Dataflow information collected up to the point where jump has been met.
+     * \param[in,out] disassembler Disassembler for checking instruction addresses, created on demand.
      *
      * \returns The entries of the jump table.
      */
-    std::vector<ByteAddr> getJumpTableEntries(const ir::Term *target, const ir::dflow::Dataflow &dataflow);
+    std::vector<ByteAddr> getJumpTableEntries(const ir::Term *target, const ir::dflow::Dataflow &dataflow,
+                                              std::unique_ptr<arch::Disassembler> &disassembler) const;
 
     /**
      * \param address A virtual address.
+     * \param[in,out] disassembler Disassembler, created on demand.
      *
      * \return True if the address seems to be an instruction address, false otherwise.
      */
-    bool isInstructionAddress(ByteAddr address);
+    bool isInstructionAddress(ByteAddr address, std::unique_ptr<arch::Disassembler> &disassembler) const;
+
+    /**
+     * Creates the basic blocks, sets the jump targets, and records
+     * the called addresses found by the analysis of a basic block.
+     *
+     * \param discoveries Discovered jump targets and called addresses.
+     */
+    void apply(const Discoveries &discoveries);
+
+    /**
+     * Forgets the computed targets of the jumps in the given basic block,
+     * so that they are computed again. Targets without an address
+     * expression, i.e. the ones set during lifting, are kept.
+     *
+     * \param basicBlock Valid pointer to a basic block.
+     */
+    void resetJumpTargets(ir::BasicBlock *basicBlock);
 
     /**
      * Adds a jump to direct successor to given basic block if the latter
@@ -0,0 +1,240 @@
+/* The file is part of Snowman decompiler. */
+/* See doc/licenses.asciidoc for the licensing information. */
+
+#include "RecursiveDisassembler.h"
+
+#include <nc/common/Arena.h>
+#include <nc/common/CancellationToken.h>
+#include <nc/common/Foreach.h>
+#include <nc/common/make_unique.h>
+
+#include <nc/core/arch/Architecture.h>
+#include <nc/core/arch/Disassembler.h>
+#include <nc/core/arch/Instruction.h>
+#include <nc/core/arch/Instructions.h>
+#include <nc/core/image/Image.h>
+#include <nc/core/image/Section.h>
+#include <nc/core/ir/BasicBlock.h>
+#include <nc/core/ir/Jump.h>
+#include <nc/core/ir/Program.h>
+#include <nc/core/ir/Statements.h>
+#include <nc/core/ir/Terms.h>
+
+#include "IRGenerator.h"
+#include "InstructionAnalyzer.h"
+#include "InvalidInstructionException.h"
+
+namespace nc {
+namespace core {
+namespace irgen {
+
+RecursiveDisassembler::RecursiveDisassembler(const image::Image *image, arch::Instructions *instructions,
+    const CancellationToken &canceled
+):
+    image_(image), instructions_(instructions), canceled_(canceled), existingLifted_(false), lastBlock_(nullptr),
+    rounds_(0), analyzedBlocks_(0), followCalls_(true)
+{
+    assert(image);
+    assert(instructions);
+
+    disassembler_ = image->platform().architecture()->createDisassembler();
+    instructionAnalyzer_ = image->platform().architecture()->createInstructionAnalyzer();
+    program_ = std::make_unique<ir::Program>();
+    generator_ = std::make_unique<IRGenerator>(image_, instructions_, program_.get(), canceled_, log_);
+}
+
+RecursiveDisassembler::~RecursiveDisassembler() {}
+
+bool RecursiveDisassembler::addEntry(ByteAddr addr) {
+    if (!isNewCode(addr) || !visited_.insert(addr).second) {
+        return false;
+    }
+    pending_.push_back(addr);
+    return true;
+}
+
+bool RecursiveDisassembler::isNewCode(ByteAddr addr) const {
+    auto section = image_->getSectionContainingAddress(addr);
+    if (!section || !section->isCode()) {
+        return false;
+    }
+
+    const auto &instruction = instructions_->getCovering(addr);
+    return !instruction || instruction->addr() > addr || instruction->endAddr() <= addr;
+}
+
+void RecursiveDisassembler::disassemble() {
+    if (!existingLifted_ && !pending_.empty()) {
+        /* Jumps in the code decoded before can lead to new code too. */
+        Arena::Scope scope(program_->arena());
+        instructionAnalyzer_->createStatements(instructions_, program_.get(), canceled_, log_);
+        existingLifted_ = true;
+    }
+
+    while (!pending_.empty()) {
+        ++rounds_;
+
+        while (!pending_.empty()) {
+            ByteAddr addr = pending_.back();
+            pending_.pop_back();
+
+            disassembleRun(addr);
+            canceled_.poll();
+        }
+
+        resolveIndirectTargets();
+    }
+}
+
+void RecursiveDisassembler::disassembleRun(ByteAddr addr) {
+    /* The address could have been decoded as a part of another run. */
+    if (!isNewCode(addr)) {
+        return;
+    }
+
+    auto section = image_->getSectionContainingAddress(addr);
+
+    /*
+     * Instructions of the run are lifted one by one in order to see which
+     * of them transfer control and where. The statements stay in the program
+     * for resolving indirect targets.
+     */
+    Arena::Scope scope(program_->arena());
+
+    for (ByteAddr pc = addr; pc < section->endAddr(); ) {
+        if (pc != addr && !isNewCode(pc)) {
+            break;
+        }
+
+        std::shared_ptr<const arch::Instruction> instruction = disassembler_->disassembleSingleInstruction(pc, section);
+        if (!instruction) {
+            break;
+        }
+
+        instructions_->add(instruction);
+        pc = instruction->endAddr();
+
+        try {
+            instructionAnalyzer_->createStatements(instruction.get(), program_.get());
+        } catch (const InvalidInstructionException &) {
+            /* IRGenerator will complain about it later. */
+            break;
+        }
+
+        bool fallsThrough = true;
+
+        auto basicBlock = program_->getBasicBlockCovering(instruction->addr());
+        assert(basicBlock != nullptr);
+
+        if (extendedBlocks_.empty() || extendedBlocks_.back() != basicBlock) {
+            extendedBlocks_.push_back(basicBlock);
+        }
+
+        const auto &statements = basicBlock->statements();
+        for (auto i = statements.rbegin(); i != statements.rend(); ++i) {
+            const ir::Statement *statement = *i;
+            if (statement->instruction() != instruction.get()) {
+                break;
+            }
+            if (auto jump = statement->asJump()) {
+                addTarget(jump->thenTarget());
+                addTarget(jump->elseTarget());
+                fallsThrough = false;
+            } else if (statement->is<ir::Halt>()) {
+                fallsThrough = false;
+            } else if (auto call = statement->asCall()) {
+                if (auto constant = call->target()->asConstant()) {
+                    addCall(constant->value().value());
+                }
+            }
+        }
+
+        if (!fallsThrough) {
+            break;
+        }
+    }
+}
+
+void RecursiveDisassembler::addCall(ByteAddr addr) {
+    if (followCalls_) {
+        addEntry(addr);
+    } else {
+        calledAddresses_.push_back(addr);
+    }
+}
+
+void RecursiveDisassembler::addTarget(const ir::JumpTarget &target) {
+    if (target.basicBlock()) {
+        if (target.basicBlock()->address()) {
+            addEntry(*target.basicBlock()->address());
+        }
+    } else if (target.table()) {
+        foreach (const auto &entry, *target.table()) {
+            addEntry(entry.address());
+        }
+    } else if (target.address()) {
+        if (auto constant = target.address()->asConstant()) {
+            addEntry(constant->value().value());
+        }
+    }
+}
+
+void RecursiveDisassembler::resolveIndirectTargets() {
+    /*
+     * Blocks created since the previous round, either by lifting or by
+     * lifting-time splitting, are appended to the program. The blocks
+     * created before that only need to be analyzed again if they got
+     * new statements.
+     */
+    std::vector<ir::BasicBlock *> basicBlocks;
+    boost::unordered_set<const ir::BasicBlock *> added;
+
+    foreach (ir::BasicBlock *basicBlock, extendedBlocks_) {
+        if (added.insert(basicBlock).second) {
+            basicBlocks.push_back(basicBlock);
+        }
+    }
+    extendedBlocks_.clear();
+
+    auto &allBlocks = program_->basicBlocks();
+    for (auto i = lastBlock_ ? ++allBlocks.get_iterator(lastBlock_) : allBlocks.begin(); i != allBlocks.end(); ++i) {
+        if (added.insert(*i).second) {
+            basicBlocks.push_back(*i);
+        }
+    }
+
+    /*
+     * IRGenerator computes the targets of jumps through the registers
+     * and recovers jump tables using dataflow information. It returns
+     * the given blocks together with the ones it has split off.
+     */
+    Arena::Scope scope(program_->arena());
+    basicBlocks = generator_->computeJumpTargets(std::move(basicBlocks));
+
+    analyzedBlocks_ += basicBlocks.size();
+    lastBlock_ = allBlocks.empty() ? nullptr : allBlocks.back();
+
+    foreach (const ir::BasicBlock *basicBlock, basicBlocks) {
+        if (auto terminator = basicBlock->getTerminator()) {
+            if (auto jump = terminator->asJump()) {
+                addTarget(jump->thenTarget());
+                addTarget(jump->elseTarget());
+            }
+        } else if (basicBlock->address() && basicBlock->successorAddress()) {
+            /* E.g. an instruction lifted into several basic blocks, the last one falling through. */
+            addEntry(*basicBlock->successorAddress());
+        }
+    }
+
+    foreach (ByteAddr addr, program_->calledAddresses()) {
+        if (knownCalls_.insert(addr).second) {
+            addCall(addr);
+        }
+    }
+}
+
+} // namespace irgen
+} // namespace core
+} // namespace nc
+
+/* vim:set et sts=4 sw=4: */
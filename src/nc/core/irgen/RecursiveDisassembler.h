@@ -0,0 +1,181 @@
+/* The file is part of Snowman decompiler. */
+/* See doc/licenses.asciidoc for the licensing information. */
+
+#pragma once
+
+#include <nc/config.h>
+
+#include <memory>
+#include <vector>
+
+#include <QCoreApplication>
+
+#include <boost/unordered_set.hpp>
+
+#include <nc/common/LogToken.h>
+#include <nc/common/Types.h>
+
+namespace nc {
+
+class CancellationToken;
+
+namespace core {
+
+namespace image {
+    class Image;
+}
+
+namespace ir {
+    class BasicBlock;
+    class JumpTarget;
+    class Program;
+}
+
+namespace arch {
+    class Disassembler;
+    class Instructions;
+}
+
+namespace irgen {
+
+class IRGenerator;
+class InstructionAnalyzer;
+
+/**
+ * Disassembler following the control flow from a set of entry addresses.
+ *
+ * Unlike a linear sweep of code sections, it decodes only the instructions
+ * reachable from the entries via fallthrough, direct jumps and calls, and
+ * jump tables, so that data, padding and jump tables embedded into code
+ * sections are not taken for code.
+ *
+ * Direct jump and call targets are followed as soon as the instructions are
+ * decoded. Indirect targets are resolved between rounds in the same way
+ * IRGenerator does it for the whole program. The decoded instructions are
+ * lifted once into a program kept for the lifetime of the disassembler,
+ * and each round analyzes only the basic blocks created or extended since
+ * the previous one.
+ */
+class RecursiveDisassembler {
+    Q_DECLARE_TR_FUNCTIONS(RecursiveDisassembler)
+
+    const image::Image *image_; ///< Executable image.
+    arch::Instructions *instructions_; ///< Instructions.
+    const CancellationToken &canceled_; ///< Cancellation token.
+    LogToken log_; ///< Silent log token, invalid instructions are reported by the real IR generation.
+    std::unique_ptr<arch::Disassembler> disassembler_; ///< Disassembler.
+    std::unique_ptr<InstructionAnalyzer> instructionAnalyzer_; ///< Instruction analyzer.
+    std::unique_ptr<ir::Program> program_; ///< Intermediate representation of the decoded instructions.
+    std::unique_ptr<IRGenerator> generator_; ///< Generator resolving jump targets in program_.
+    bool existingLifted_; ///< Whether the instructions given to the constructor are lifted into program_.
+    const ir::BasicBlock *lastBlock_; ///< Last basic block of program_ after the previous round, nullptr if none.
+    std::vector<ir::BasicBlock *> extendedBlocks_; ///< Basic blocks statements were added to since the previous round.
+    boost::unordered_set<ByteAddr> knownCalls_; ///< Called addresses of program_ already handled.
+    std::vector<ByteAddr> pending_; ///< Addresses to start decoding from.
+    boost::unordered_set<ByteAddr> visited_; ///< Addresses decoding has been started from.
+    std::size_t rounds_; ///< Number of rounds of indirect target resolution.
+    std::size_t analyzedBlocks_; ///< Number of basic blocks analyzed for indirect targets.
+    bool followCalls_; ///< Whether to decode the code at the called addresses.
+    std::vector<ByteAddr> calledAddresses_; ///< Called addresses not followed.
+
+public:
+    /**
+     * Constructor.
+     *
+     * \param[in] image Valid pointer to the executable image.
+     * \param[in,out] instructions Valid pointer to the set of instructions to add decoded instructions to.
+     * \param[in] canceled Cancellation token.
+     */
+    RecursiveDisassembler(const image::Image *image, arch::Instructions *instructions, const CancellationToken &canceled);
+
+    /**
+     * Destructor.
+     */
+    ~RecursiveDisassembler();
+
+    /**
+     * Adds an address to start decoding from. Addresses outside code
+     * sections, inside already decoded instructions, or already tried
+     * are ignored.
+     *
+     * \param addr Address.
+     *
+     * \return True if the address was added, false if it was ignored.
+     */
+    bool addEntry(ByteAddr addr);
+
+    /**
+     * Sets whether the code at the called addresses must be decoded.
+     * If not, the called addresses are only collected. By default,
+     * calls are followed.
+     *
+     * \param followCalls Whether to follow calls.
+     */
+    void setFollowCalls(bool followCalls) { followCalls_ = followCalls; }
+
+    /**
+     * Decodes all the instructions reachable from the added entries.
+     */
+    void disassemble();
+
+    /**
+     * \return Called addresses met by disassemble() when calls are not followed,
+     *          in the order they were met, possibly with duplicates.
+     */
+    const std::vector<ByteAddr> &calledAddresses() const { return calledAddresses_; }
+
+    /**
+     * \return Number of rounds of indirect target resolution done by disassemble().
+     */
+    std::size_t rounds() const { return rounds_; }
+
+    /**
+     * \return Number of basic blocks analyzed for indirect targets by disassemble(),
+     *         summed over all rounds.
+     */
+    std::size_t analyzedBlocks() const { return analyzedBlocks_; }
+
+private:
+    /**
+     * \param addr Address.
+     *
+     * \return True if the address is in a code section and not covered by a decoded instruction.
+     */
+    bool isNewCode(ByteAddr addr) const;
+
+    /**
+     * Decodes instructions starting at the given address until the
+     * control flow leaves the straight-line sequence, lifting them into
+     * the program and queuing direct jump and call targets met on the way.
+     *
+     * \param addr Address.
+     */
+    void disassembleRun(ByteAddr addr);
+
+    /**
+     * Queues or remembers a called address, depending on whether calls are followed.
+     *
+     * \param addr Called address.
+     */
+    void addCall(ByteAddr addr);
+
+    /**
+     * Queues the address of the given jump target, if it is known.
+     *
+     * \param target Jump target.
+     */
+    void addTarget(const ir::JumpTarget &target);
+
+    /**
+     * Computes jump targets in the basic blocks created or extended since
+     * the previous round and queues the targets of jumps and calls found
+     * by IRGenerator.
+     */
+    void resolveIndirectTargets();
+};
+
+} // namespace irgen
+} // namespace core
+} // namespace nc
+
+/* vim:set et sts=4 sw=4: */
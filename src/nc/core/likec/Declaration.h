@@ -39,7 +39,7 @@ namespace likec {
 class Declaration: public TreeNode {
     NC_BASE_CLASS(Declaration, declarationKind)
 
-    const QString identifier_;
+    QString identifier_;
 
 public:
 
@@ -53,6 +53,7 @@ public:
         MEMBER_DECLARATION,             ///< Declaration of a struct or union member.
         STRUCT_TYPE_DECLARATION,        ///< Declaration of structural type.
         VARIABLE_DECLARATION,           ///< Variable declaration.
+        VERBATIM_DECLARATION,           ///< Declaration given by its source text.
     };
 
     /**
@@ -69,6 +70,13 @@ public:
      * \return Name of declared entity.
      */
     const QString &identifier() const { return identifier_; }
+
+    /**
+     * Sets the name of declared entity.
+     *
+     * \param[in] identifier Name of declared entity.
+     */
+    void setIdentifier(QString identifier) { identifier_ = std::move(identifier); }
 };
 
 } // namespace likec
@@ -73,6 +73,8 @@ std::unique_ptr<Declaration> Simplifier::simplify(std::unique_ptr<Declaration> n
             return node;
         case Declaration::VARIABLE_DECLARATION:
             return simplify(as<VariableDeclaration>(std::move(node)));
+        case Declaration::VERBATIM_DECLARATION:
+            return node;
     }
     unreachable();
 }
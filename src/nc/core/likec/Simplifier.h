@@ -57,8 +57,14 @@ public:
      */
     std::unique_ptr<CompilationUnit> simplify(std::unique_ptr<CompilationUnit> node);
 
-private:
+    /**
+     * \param node Valid pointer to a top-level declaration.
+     *
+     * \return Pointer to the simplified declaration.
+     */
     std::unique_ptr<Declaration> simplify(std::unique_ptr<Declaration> node);
+
+private:
     std::unique_ptr<FunctionDefinition> simplify(std::unique_ptr<FunctionDefinition> node);
     std::unique_ptr<LabelDeclaration> simplify(std::unique_ptr<LabelDeclaration> node);
     std::unique_ptr<VariableDeclaration> simplify(std::unique_ptr<VariableDeclaration> node);
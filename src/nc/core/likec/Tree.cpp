@@ -24,6 +24,8 @@
 
 #include "Tree.h"
 
+#include <QMutexLocker>
+
 #include <nc/common/Foreach.h>
 
 #include "Simplifier.h"
@@ -40,6 +42,16 @@ void Tree::rewriteRoot() {
     }
 }
 
+void Tree::rewriteDeclarations(std::size_t begin) {
+    if (root_) {
+        Simplifier simplifier(*this);
+        auto &declarations = root_->declarations();
+        for (std::size_t i = begin; i < declarations.size(); ++i) {
+            declarations[i] = simplifier.simplify(std::move(declarations[i]));
+        }
+    }
+}
+
 void Tree::print(QTextStream &out, PrintCallback<const TreeNode *> *callback) const {
     TreePrinter(out, callback).print(root());
 }
@@ -49,6 +61,8 @@ const VoidType *Tree::makeVoidType() {
 }
 
 const IntegerType *Tree::makeIntegerType(SmallBitSize size, bool isUnsigned) {
+    QMutexLocker locker(&typesMutex_);
+
     foreach (const auto &type, integerTypes_) {
         if (type->size() == size && type->isUnsigned() == isUnsigned) {
             return type.get();
@@ -62,6 +76,8 @@ const IntegerType *Tree::makeIntegerType(SmallBitSize size, bool isUnsigned) {
 }
 
 const FloatType *Tree::makeFloatType(SmallBitSize size) {
+    QMutexLocker locker(&typesMutex_);
+
     foreach (const auto &type, floatTypes_) {
         if (type->size() == size) {
             return type.get();
@@ -75,6 +91,8 @@ const FloatType *Tree::makeFloatType(SmallBitSize size) {
 }
 
 const PointerType *Tree::makePointerType(SmallBitSize size, const Type *pointee) {
+    QMutexLocker locker(&typesMutex_);
+
     auto range = pointerTypes_.equal_range(pointee);
     for (auto i = range.first; i != range.second; ++i) {
         if (i->second->size() == size) {
@@ -88,6 +106,8 @@ const PointerType *Tree::makePointerType(SmallBitSize size, const Type *pointee)
 }
 
 const ArrayType *Tree::makeArrayType(SmallBitSize size, const Type *elementType, std::size_t length) {
+    QMutexLocker locker(&typesMutex_);
+
     auto range = arrayTypes_.equal_range(elementType);
     for (auto i = range.first; i != range.second; ++i) {
         if (i->second->length() == length && i->second->size() == size) {
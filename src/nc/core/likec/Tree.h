@@ -32,6 +32,8 @@
 
 #include <boost/noncopyable.hpp>
 
+#include <QMutex>
+
 #include <nc/common/PrintCallback.h>
 
 #include "CompilationUnit.h"
@@ -43,6 +45,9 @@ namespace likec {
 
 /**
  * Abstract syntax tree of high-level program in a C-like language.
+ *
+ * Types are interned: each of the make*Type() functions returns the same
+ * object for the same arguments. These functions may be called concurrently.
  */
 class Tree: boost::noncopyable {
     std::unique_ptr<CompilationUnit> root_; ///< Tree root node.
@@ -57,6 +62,7 @@ class Tree: boost::noncopyable {
     std::multimap<const Type *, std::unique_ptr<PointerType> > pointerTypes_; ///< Pointers to other types.
     std::multimap<const Type *, std::unique_ptr<ArrayType> > arrayTypes_; ///< Arrays of other types.
     const ErroneousType erroneousType_; ///< Erroneous type.
+    QMutex typesMutex_; ///< Mutex protecting the tables of types above.
 
 public:
     /**
@@ -124,6 +130,16 @@ public:
      */
     void rewriteRoot();
 
+    /**
+     * Rewrites the top-level declarations of the root,
+     * starting from the one with the given index.
+     *
+     * \param[in] begin Index of the first declaration to rewrite.
+     *
+     * \see rewriteRoot()
+     */
+    void rewriteDeclarations(std::size_t begin);
+
     /**
      * Prints the whole tree into a stream.
      *
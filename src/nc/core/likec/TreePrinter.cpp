@@ -38,6 +38,7 @@
 #include "UnaryOperator.h"
 #include "UndeclaredIdentifier.h"
 #include "VariableDeclaration.h"
+#include "VerbatimDeclaration.h"
 #include "While.h"
 
 namespace nc {
@@ -231,6 +232,9 @@ void TreePrinter::doPrint(const Declaration *node) {
         case Declaration::VARIABLE_DECLARATION:
             doPrint(node->as<VariableDeclaration>());
             break;
+        case Declaration::VERBATIM_DECLARATION:
+            doPrint(node->as<VerbatimDeclaration>());
+            break;
         default:
             unreachable();
     }
@@ -303,6 +307,10 @@ void TreePrinter::doPrint(const VariableDeclaration *node) {
     out_ << ';';
 }
 
+void TreePrinter::doPrint(const VerbatimDeclaration *node) {
+    out_ << node->text();
+}
+
 void TreePrinter::doPrint(const Expression *node) {
     switch (node->expressionKind()) {
         case Expression::BINARY_OPERATOR:
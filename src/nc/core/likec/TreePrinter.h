@@ -48,6 +48,7 @@ class UnaryOperator;
 class UndeclaredIdentifier;
 class VariableDeclaration;
 class VariableIdentifier;
+class VerbatimDeclaration;
 class While;
 
 /**
@@ -85,6 +86,7 @@ private:
     void doPrint(const MemberDeclaration *node);
     void doPrint(const StructTypeDeclaration *node);
     void doPrint(const VariableDeclaration *node);
+    void doPrint(const VerbatimDeclaration *node);
 
     void doPrint(const Expression *node);
     void doPrint(const BinaryOperator *node);
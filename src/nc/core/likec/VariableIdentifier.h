@@ -58,6 +58,14 @@ public:
      * \return Variable declaration.
      */
     const VariableDeclaration *declaration() const { return declaration_; }
+
+    /**
+     * \param declaration Valid pointer to the variable declaration.
+     */
+    void setDeclaration(VariableDeclaration *declaration) {
+        assert(declaration != nullptr);
+        declaration_ = declaration;
+    }
 };
 
 } // namespace likec
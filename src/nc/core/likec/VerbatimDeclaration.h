@@ -0,0 +1,66 @@
+/* The file is part of Snowman decompiler. */
+/* See doc/licenses.asciidoc for the licensing information. */
+
+#pragma once
+
+#include <nc/config.h>
+
+#include <memory>
+
+#include "Declaration.h"
+
+namespace nc {
+namespace core {
+namespace likec {
+
+/**
+ * Declaration available only as ready-made source text,
+ * e.g. a function definition restored from a cache.
+ *
+ * The declaration may keep a node describing the declared entity,
+ * which other nodes can refer to. The node itself is not printed.
+ */
+class VerbatimDeclaration: public Declaration {
+    std::unique_ptr<Declaration> declaration_; ///< Node describing the declared entity.
+    QString text_; ///< Source text of the declaration.
+
+public:
+    /**
+     * Class constructor.
+     *
+     * \param[in] identifier Name of declared entity.
+     * \param[in] text Source text of the declaration.
+     */
+    VerbatimDeclaration(QString identifier, QString text):
+        Declaration(VERBATIM_DECLARATION, std::move(identifier)), text_(std::move(text))
+    {}
+
+    /**
+     * Class constructor.
+     *
+     * \param[in] declaration Valid pointer to the node describing the declared entity.
+     * \param[in] text Source text of the declaration.
+     */
+    VerbatimDeclaration(std::unique_ptr<Declaration> declaration, QString text):
+        Declaration(VERBATIM_DECLARATION, declaration->identifier()),
+        declaration_(std::move(declaration)), text_(std::move(text))
+    {}
+
+    /**
+     * \return Pointer to the node describing the declared entity. Can be nullptr.
+     */
+    const Declaration *declaration() const { return declaration_.get(); }
+
+    /**
+     * \return Source text of the declaration.
+     */
+    const QString &text() const { return text_; }
+};
+
+} // namespace likec
+} // namespace core
+} // namespace nc
+
+NC_SUBCLASS(nc::core::likec::Declaration, nc::core::likec::VerbatimDeclaration, nc::core::likec::Declaration::VERBATIM_DECLARATION)
+
+/* vim:set et sts=4 sw=4: */
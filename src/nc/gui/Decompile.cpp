@@ -26,9 +26,15 @@
 
 #include <cassert>
 
+#ifdef NC_USE_THREADS
+#include <QThread>
+#endif
+
 #include <nc/common/make_unique.h>
 
 #include <nc/core/Context.h>
+#include <nc/core/Statistics.h>
+#include <nc/core/ir/FunctionCache.h>
 
 #include "Decompilation.h"
 #include "Project.h"
@@ -52,6 +58,18 @@ void Decompile::work() {
     context->setInstructions(instructions_);
     context->setCancellationToken(cancellationToken());
     context->setLogToken(project_->logToken());
+    context->setStatistics(std::make_shared<core::Statistics>());
+
+    /* Reuse the results of the previous decompilation or of a restored session, and keep them for saving. */
+    auto functionCache = project_->context()->sharedFunctionCache();
+    if (!functionCache) {
+        functionCache = std::make_shared<core::ir::FunctionCache>(nullptr);
+    }
+    context->setFunctionCache(functionCache);
+
+#ifdef NC_USE_THREADS
+    context->setThreadCount(qMax(QThread::idealThreadCount(), 1));
+#endif
 
     project_->setContext(context);
 
@@ -26,6 +26,10 @@
 
 #include <cassert>
 
+#ifdef NC_USE_THREADS
+#include <QThread>
+#endif
+
 #include <nc/common/make_unique.h>
 
 #include <nc/core/Context.h>
@@ -51,6 +55,9 @@ void Disassemble::work() {
     context->setInstructions(project_->instructions());
     context->setCancellationToken(cancellationToken());
     context->setLogToken(project_->logToken());
+#ifdef NC_USE_THREADS
+    context->setThreadCount(qMax(QThread::idealThreadCount(), 1));
+#endif
 
     project_->setContext(context);
 
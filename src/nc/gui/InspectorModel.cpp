@@ -290,6 +290,10 @@ void expand(InspectorItem *item, const core::likec::Declaration *declaration) {
             item->addChild(tr("type"), variableDeclaration->type());
             break;
         }
+        case core::likec::Declaration::VERBATIM_DECLARATION: {
+            item->addComment(tr("Verbatim Declaration"));
+            break;
+        }
         default: {
             item->addComment(tr("declaration kind = %1").arg(declaration->declarationKind()));
             break;
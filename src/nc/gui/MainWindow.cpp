@@ -66,6 +66,7 @@
 #include "Project.h"
 #include "SectionsModel.h"
 #include "SectionsView.h"
+#include "StatisticsView.h"
 #include "SymbolsModel.h"
 #include "SymbolsView.h"
 
@@ -156,6 +157,13 @@ void MainWindow::createWidgets() {
 
     connect(logView_, SIGNAL(status(const QString &)), this, SLOT(setStatusText(const QString &)));
 
+    statisticsView_ = new StatisticsView(this);
+    statisticsView_->setObjectName("StatisticsView");
+    addDockWidget(Qt::BottomDockWidgetArea, statisticsView_);
+    statisticsView_->hide();
+
+    connect(statisticsView_, SIGNAL(status(const QString &)), this, SLOT(setStatusText(const QString &)));
+
     disassemblyDialog_ = new DisassemblyDialog(this);
     connect(disassemblyDialog_, SIGNAL(accepted()), this, SLOT(disassembleSelectedSectionRange()));
 
@@ -176,6 +184,12 @@ void MainWindow::createActions() {
     openAction_->setShortcuts(QKeySequence::Open);
     connect(openAction_, SIGNAL(triggered()), this, SLOT(open()));
 
+    openSessionAction_ = new QAction(tr("Open &Session..."), this);
+    connect(openSessionAction_, SIGNAL(triggered()), this, SLOT(openSession()));
+
+    saveSessionAction_ = new QAction(tr("Sa&ve Session..."), this);
+    connect(saveSessionAction_, SIGNAL(triggered()), this, SLOT(saveSession()));
+
     exportCfgAction_ = new QAction(tr("&Export CFG..."), this);
     connect(exportCfgAction_, SIGNAL(triggered()), this, SLOT(exportCfg()));
 
@@ -221,6 +235,9 @@ void MainWindow::createActions() {
     logViewAction_->setText(tr("&Log"));
     logViewAction_->setShortcut(Qt::ALT + Qt::Key_L);
 
+    statisticsViewAction_ = statisticsView_->toggleViewAction();
+    statisticsViewAction_->setText(tr("St&atistics"));
+
     aboutQtAction_ = new QAction(tr("About &Qt"), this);
     connect(aboutQtAction_, SIGNAL(triggered()), qApp, SLOT(aboutQt()));
 
@@ -243,7 +260,9 @@ void MainWindow::createActions() {
 void MainWindow::createMenus() {
     QMenu *fileMenu = menuBar()->addMenu(tr("&File"));
     fileMenu->addAction(openAction_);
+    fileMenu->addAction(openSessionAction_);
     fileMenu->addSeparator();
+    fileMenu->addAction(saveSessionAction_);
     fileMenu->addAction(exportCfgAction_);
     fileMenu->addSeparator();
     fileMenu->addAction(loadStyleSheetAction_);
@@ -264,6 +283,7 @@ void MainWindow::createMenus() {
     viewMenu->addAction(symbolsViewAction_);
     viewMenu->addAction(inspectorViewAction_);
     viewMenu->addAction(logViewAction_);
+    viewMenu->addAction(statisticsViewAction_);
 
     QMenu *helpMenu = menuBar()->addMenu(tr("&Help"));
     helpMenu->addAction(aboutQtAction_);
@@ -318,6 +338,7 @@ void MainWindow::saveSettings() {
 }
 
 void MainWindow::updateGuiState() {
+    saveSessionAction_->setEnabled(project() != nullptr);
     exportCfgAction_->setEnabled(project() != nullptr);
     disassembleAction_->setEnabled(project() != nullptr);
     decompileAction_->setEnabled(project() != nullptr);
@@ -392,6 +413,39 @@ void MainWindow::open(const QStringList &filenames) {
     }
 }
 
+void MainWindow::openSession() {
+    QString filename = QFileDialog::getOpenFileName(this, tr("Which session should I restore?"), QString(), tr("Sessions (*.session);;All Files(*)"));
+    if (filename.isEmpty()) {
+        return;
+    }
+
+    auto context = std::make_shared<core::Context>();
+    context->setLogToken(logToken_);
+
+    try {
+        core::Driver::loadSession(*context, filename);
+    } catch (const nc::Exception &e) {
+        QMessageBox::critical(this, tr("Error"), e.unicodeWhat());
+        return;
+    } catch (const std::exception &e) {
+        QMessageBox::critical(this, tr("Error"), e.what());
+        return;
+    }
+
+    auto project = std::make_unique<gui::Project>();
+    project->setName(QFileInfo(filename).fileName());
+    project->setContext(context);
+    project->setImage(context->image());
+    project->setInstructions(context->instructions());
+
+    open(std::move(project));
+
+    /* A restored session already has its instructions and, usually, the generated code. */
+    if (!project_->context()->tree() && decompileAutomatically()) {
+        project_->decompile();
+    }
+}
+
 void MainWindow::open(std::unique_ptr<Project> project) {
     assert(project);
 
@@ -452,6 +506,8 @@ void MainWindow::treeChanged() {
         inspectorView_->model()->deleteLater();
     }
     inspectorView_->setModel(new InspectorModel(this, project()->context()));
+
+    statisticsView_->setStatistics(project()->context() ? project()->context()->sharedStatistics() : nullptr);
 }
 
 void MainWindow::populateInstructionsContextMenu(QMenu *menu) {
@@ -484,6 +540,28 @@ void MainWindow::populateSymbolsContextMenu(QMenu *menu) {
     }
 }
 
+void MainWindow::saveSession() {
+    if (!project()) {
+        return;
+    }
+
+    if (project()->commandQueue()->front()) {
+        QMessageBox::critical(this, tr("Error"), tr("Sorry, the session cannot be saved while commands are running. Wait until they finish or cancel them."));
+        return;
+    }
+
+    QString filename = QFileDialog::getSaveFileName(this, tr("Where should I save the session?"), QString(), tr("Sessions (*.session);;All Files(*)"));
+    if (filename.isEmpty()) {
+        return;
+    }
+
+    try {
+        core::Driver::saveSession(*project()->context(), filename);
+    } catch (const nc::Exception &e) {
+        QMessageBox::critical(this, tr("Error"), e.unicodeWhat());
+    }
+}
+
 void MainWindow::exportCfg() {
     if (!project()) {
         return;
@@ -56,6 +56,7 @@ class InstructionsView;
 class LogView;
 class Project;
 class SectionsView;
+class StatisticsView;
 class SymbolsView;
 
 /**
@@ -72,12 +73,15 @@ class MainWindow: public QMainWindow {
     SymbolsView *symbolsView_; ///< Symbols view.
     InspectorView *inspectorView_; ///< Inspector view.
     LogView *logView_; ///< Log window.
+    StatisticsView *statisticsView_; ///< Profiling statistics window.
     DisassemblyDialog *disassemblyDialog_; ///< Disassembly dialog.
     QProgressDialog *progressDialog_; ///< Progress dialog.
     QLabel *statusLabel_; ///< Label in the status bar.
     QProgressBar *statusProgressBar_; ///< Progress bar in the status bar.
 
     QAction *openAction_; ///< Action for opening a file.
+    QAction *openSessionAction_; ///< Action for restoring a saved session.
+    QAction *saveSessionAction_; ///< Action for saving the session.
     QAction *exportCfgAction_; ///< Action for exporting CFG in DOT format.
     QAction *loadStyleSheetAction_; ///< Action for loading a Qt style sheet.
     QAction *quitAction_; ///< Action for closing the main window.
@@ -90,6 +94,7 @@ class MainWindow: public QMainWindow {
     QAction *symbolsViewAction_; ///< Action for showing/hiding the symbols window.
     QAction *inspectorViewAction_; ///< Action for showing/hiding the tree inspector.
     QAction *logViewAction_; ///< Action for showing/hiding the log window.
+    QAction *statisticsViewAction_; ///< Action for showing/hiding the statistics window.
     QAction *aboutAction_; ///< Action for showing 'About Application' dialog.
     QAction *aboutQtAction_; ///< Action for showing 'About Qt' dialog.
     QAction *deleteSelectedInstructionsAction_; ///< Action for deleting selected instructions.
@@ -168,6 +173,11 @@ public Q_SLOTS:
      */
     void open(const QStringList &filenames);
 
+    /**
+     * Opens a dialog for selecting a session file and restores the session from it.
+     */
+    void openSession();
+
 public: 
     /**
      * Opens a project.
@@ -300,6 +310,11 @@ private Q_SLOTS:
      */
     void populateSymbolsContextMenu(QMenu *menu);
 
+    /**
+     * Opens a dialog for selecting a file and saves the current session to it.
+     */
+    void saveSession();
+
     /**
      * Export CFG in DOT format.
      */
@@ -0,0 +1,82 @@
+/* The file is part of Snowman decompiler. */
+/* See doc/licenses.asciidoc for the licensing information. */
+
+#include "StatisticsView.h"
+
+#include <algorithm>
+
+#include <QPlainTextEdit>
+#include <QTextStream>
+
+#include <nc/common/Foreach.h>
+
+#include <nc/core/Statistics.h>
+
+namespace nc { namespace gui {
+
+namespace {
+
+/** Maximal number of the slowest functions shown for each pass. */
+const std::size_t MAX_FUNCTIONS = 10;
+
+void printCounters(QTextStream &out, const core::Statistics::Counters &counters) {
+    foreach (const auto &counter, counters) {
+        out << " " << counter.first << "=" << counter.second;
+    }
+}
+
+} // anonymous namespace
+
+StatisticsView::StatisticsView(QWidget *parent):
+    TextView(tr("Statistics"), parent)
+{
+    textEdit()->setReadOnly(true);
+}
+
+void StatisticsView::setStatistics(const std::shared_ptr<const core::Statistics> &statistics) {
+    QString text;
+
+    if (statistics) {
+        QTextStream out(&text);
+
+        foreach (auto pass, statistics->passes()) {
+            out << pass.name << ": " << QString::number(pass.nanoseconds / 1e6, 'f', 3) << " ms";
+            if (pass.memoryGrowth) {
+                out << ", memory " << (*pass.memoryGrowth >= 0 ? "+" : "") << *pass.memoryGrowth / 1024 << " KiB";
+            }
+            printCounters(out, pass.counters);
+            out << endl;
+
+            std::sort(pass.functions.begin(), pass.functions.end(),
+                [](const core::Statistics::FunctionRecord &a, const core::Statistics::FunctionRecord &b) {
+                    return a.nanoseconds > b.nanoseconds;
+                });
+            if (pass.functions.size() > MAX_FUNCTIONS) {
+                pass.functions.resize(MAX_FUNCTIONS);
+            }
+
+            foreach (const auto &function, pass.functions) {
+                out << "    ";
+                if (function.address) {
+                    out << "0x" << QString::number(*function.address, 16);
+                } else {
+                    out << "?";
+                }
+                out << ": " << QString::number(function.nanoseconds / 1e6, 'f', 3) << " ms";
+                printCounters(out, function.counters);
+                out << endl;
+            }
+        }
+
+        auto peakMemoryUsage = core::Statistics::peakMemoryUsage();
+        if (peakMemoryUsage >= 0) {
+            out << "Peak memory usage: " << peakMemoryUsage / 1024 << " KiB" << endl;
+        }
+    }
+
+    textEdit()->setPlainText(text);
+}
+
+}} // namespace nc::gui
+
+/* vim:set et sts=4 sw=4: */
@@ -0,0 +1,45 @@
+/* The file is part of Snowman decompiler. */
+/* See doc/licenses.asciidoc for the licensing information. */
+
+#pragma once
+
+#include <nc/config.h>
+
+#include <memory>
+
+#include "TextView.h"
+
+namespace nc {
+
+namespace core {
+    class Statistics;
+}
+
+namespace gui {
+
+/**
+ * Dock widget showing the time, memory, and counters of the decompiler passes.
+ */
+class StatisticsView: public TextView {
+    Q_OBJECT
+
+    public:
+
+    /**
+     * Constructor.
+     *
+     * \param[in] parent Pointer to the parent widget. Can be nullptr.
+     */
+    explicit StatisticsView(QWidget *parent = 0);
+
+    /**
+     * Shows given statistics.
+     *
+     * \param statistics Pointer to the statistics. Can be nullptr.
+     */
+    void setStatistics(const std::shared_ptr<const core::Statistics> &statistics);
+};
+
+}} // namespace nc::gui
+
+/* vim:set et sts=4 sw=4: */
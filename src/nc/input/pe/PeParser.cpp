@@ -35,6 +35,8 @@
 #include <nc/common/make_unique.h>
 
 #include <nc/core/image/Image.h>
+#include <nc/core/image/MappedByteSource.h>
+#include <nc/core/image/MappedFile.h>
 #include <nc/core/image/Reader.h>
 #include <nc/core/image/Relocation.h>
 #include <nc/core/image/Section.h>
@@ -112,6 +114,7 @@ class PeParserImpl {
     QIODevice *source_;
     core::image::Image *image_;
     const LogToken &log_;
+    std::shared_ptr<const core::image::MappedFile> mappedFile_;
 
     ByteAddr optionalHeaderOffset_;
     IMAGE_FILE_HEADER &fileHeader_;
@@ -119,7 +122,8 @@ class PeParserImpl {
 
 public:
     PeParserImpl(QIODevice *source, core::image::Image *image, const LogToken &log, IMAGE_FILE_HEADER &fileHeader):
-        source_(source), image_(image), log_(log), fileHeader_(fileHeader)
+        source_(source), image_(image), log_(log), mappedFile_(core::image::MappedFile::map(source)),
+        fileHeader_(fileHeader)
     {}
 
     void parse() {
@@ -200,6 +204,11 @@ private:
 
             if (sectionHeader.SizeOfRawData == 0) {
                 log_.debug(tr("Section %1 has no raw data.").arg(section->name()));
+            } else if (mappedFile_ && mappedFile_->contains(sectionHeader.PointerToRawData, sectionHeader.SizeOfRawData)) {
+                log_.debug(tr("Mapping contents of section %1 (size of raw data = 0x%2).").arg(section->name()).arg(sectionHeader.SizeOfRawData));
+
+                section->setExternalByteSource(std::make_unique<core::image::MappedByteSource>(
+                    mappedFile_, section.get(), sectionHeader.PointerToRawData, sectionHeader.SizeOfRawData));
             } else {
                 log_.debug(tr("Reading contents of section %1 (size of raw data = 0x%2).").arg(section->name()).arg(sectionHeader.SizeOfRawData));
 
@@ -24,14 +24,23 @@
 
 #include <nc/config.h>
 
+#include <memory>
+#include <vector>
+
+#include <boost/unordered_map.hpp>
+
 #include <nc/common/Branding.h>
+#include <nc/common/CancellationToken.h>
+#include <nc/common/DiskCache.h>
 #include <nc/common/Exception.h>
 #include <nc/common/Foreach.h>
+#include <nc/common/Parallel.h>
 #include <nc/common/StreamLogger.h>
 #include <nc/common/Unreachable.h>
 
 #include <nc/core/Context.h>
 #include <nc/core/Driver.h>
+#include <nc/core/Statistics.h>
 #include <nc/core/arch/Architecture.h>
 #include <nc/core/arch/ArchitectureRepository.h>
 #include <nc/core/arch/Instruction.h>
@@ -42,6 +51,7 @@
 #include <nc/core/input/ParserRepository.h>
 #include <nc/core/ir/BasicBlock.h>
 #include <nc/core/ir/Function.h>
+#include <nc/core/ir/FunctionCache.h>
 #include <nc/core/ir/Functions.h>
 #include <nc/core/ir/Program.h>
 #include <nc/core/ir/Statements.h>
@@ -50,9 +60,13 @@
 #include <nc/core/likec/Tree.h>
 
 #include <QCoreApplication>
+#include <QElapsedTimer>
 #include <QFile>
+#include <QMutex>
+#include <QMutexLocker>
 #include <QStringList>
 #include <QTextStream>
+#include <QThread>
 
 #include <nc/core/image/Section.h>
 
@@ -130,6 +144,303 @@ void printRegionGraphs(nc::core::Context &context, QTextStream &out) {
     out << "}" << endl;
 }
 
+/**
+ * An input of the batch mode and the file to print its C++ code to.
+ */
+struct BatchItem {
+    QString input;
+    QString output;
+};
+
+/**
+ * Reads a manifest of the batch mode. Every non-empty line not starting
+ * with '#' names an input file and, optionally, separated by a tab,
+ * the output file. By default, the output file name is the input file
+ * name with ".cpp" appended.
+ *
+ * \param filename Name of the manifest file, or "-" for stdin.
+ *
+ * \return List of the inputs.
+ */
+std::vector<BatchItem> readManifest(const QString &filename) {
+    QFile file;
+    if (filename == "-") {
+        if (!file.open(stdin, QIODevice::ReadOnly)) {
+            throw nc::Exception("could not read the manifest from stdin");
+        }
+    } else {
+        file.setFileName(filename);
+        if (!file.open(QIODevice::ReadOnly)) {
+            throw nc::Exception(QString("could not open manifest file: %1").arg(filename));
+        }
+    }
+
+    std::vector<BatchItem> result;
+
+    QTextStream in(&file);
+    while (!in.atEnd()) {
+        QString line = in.readLine();
+        if (line.trimmed().isEmpty() || line.startsWith('#')) {
+            continue;
+        }
+
+        BatchItem item;
+        item.input = line.section('\t', 0, 0);
+        item.output = line.section('\t', 1, 1);
+        if (item.output.isEmpty()) {
+            item.output = item.input + ".cpp";
+        }
+        result.push_back(item);
+    }
+
+    return result;
+}
+
+/**
+ * Logger prefixing the messages with the name of the batch input they are about.
+ */
+class BatchLogger: public nc::Logger {
+    std::shared_ptr<nc::Logger> logger_;
+    QString prefix_;
+
+public:
+    /**
+     * \param logger Valid pointer to the logger to pass the messages to.
+     * \param input Name of the batch input.
+     */
+    BatchLogger(std::shared_ptr<nc::Logger> logger, const QString &input):
+        logger_(std::move(logger)), prefix_(input + QLatin1String(": "))
+    {}
+
+    void log(nc::LogLevel level, const QString &text) override {
+        logger_->log(level, prefix_ + text);
+    }
+};
+
+/**
+ * Thread canceling the decompilation of batch inputs running for too long.
+ */
+class BatchWatchdog: public QThread {
+    struct Job {
+        nc::CancellationToken token;
+        QElapsedTimer timer;
+        bool timedOut;
+    };
+
+    qint64 timeout_;
+    QMutex mutex_;
+    boost::unordered_map<std::size_t, Job> jobs_;
+    bool stopped_;
+
+public:
+    /**
+     * \param timeout Timeout in milliseconds.
+     */
+    explicit BatchWatchdog(qint64 timeout): timeout_(timeout), stopped_(false) {}
+
+    /**
+     * Starts watching a job.
+     *
+     * \param index Index of the job.
+     * \param token Cancellation token of the job.
+     */
+    void add(std::size_t index, const nc::CancellationToken &token) {
+        QMutexLocker locker(&mutex_);
+        Job &job = jobs_[index];
+        job.token = token;
+        job.timer.start();
+        job.timedOut = false;
+    }
+
+    /**
+     * Stops watching a job.
+     *
+     * \param index Index of the job.
+     *
+     * \return True if the job has been canceled because of the timeout.
+     */
+    bool remove(std::size_t index) {
+        QMutexLocker locker(&mutex_);
+        auto i = jobs_.find(index);
+        bool result = i->second.timedOut;
+        jobs_.erase(i);
+        return result;
+    }
+
+    /**
+     * Makes the thread finish.
+     */
+    void stop() {
+        QMutexLocker locker(&mutex_);
+        stopped_ = true;
+    }
+
+protected:
+    void run() override {
+        while (true) {
+            {
+                QMutexLocker locker(&mutex_);
+                if (stopped_) {
+                    return;
+                }
+                foreach (auto &item, jobs_) {
+                    Job &job = item.second;
+                    if (!job.timedOut && job.timer.elapsed() > timeout_) {
+                        job.timedOut = true;
+                        job.token.cancel();
+                    }
+                }
+            }
+            msleep(100);
+        }
+    }
+};
+
+/**
+ * Decompiles every input of the manifest in its own context and prints
+ * the C++ code to the output file of the input. Failures of one input
+ * do not affect the others. A line with the input name, the status
+ * (ok, error, or timeout), the time spent in seconds, and the error
+ * message, if any, is printed for every input to stdout. The code of
+ * inputs with "-" as the output file is printed to stdout, too, after
+ * the input has been decompiled completely.
+ *
+ * \param manifestFile Name of the manifest file.
+ * \param jobCount Maximal number of inputs decompiled concurrently.
+ * \param timeout Timeout per input in seconds, or zero if none.
+ * \param stream Whether to generate code function by function.
+ * \param recursive Whether to disassemble only the code reachable from entry points.
+ * \param incrementalStructuring Whether to structure regions incrementally.
+ * \param verbose Whether to print progress information to stderr.
+ * \param statsFile File to print the statistics of all inputs to, in the order of the manifest.
+ *                  Empty string means no statistics.
+ * \param cache Persistent cache of per-function results shared by all inputs. Can be nullptr.
+ *
+ * \return Number of inputs that could not be decompiled.
+ */
+std::size_t runBatch(const QString &manifestFile, int jobCount, int timeout, bool stream, bool recursive,
+                     bool incrementalStructuring, bool verbose, const QString &statsFile, const std::shared_ptr<nc::DiskCache> &cache)
+{
+    auto items = readManifest(manifestFile);
+
+    std::shared_ptr<nc::Logger> logger;
+    if (verbose) {
+        logger = std::make_shared<nc::StreamLogger>(qerr);
+    }
+
+    std::vector<std::shared_ptr<nc::core::Statistics>> statistics(items.size());
+
+    std::unique_ptr<BatchWatchdog> watchdog;
+    if (timeout > 0) {
+        watchdog.reset(new BatchWatchdog(timeout * 1000LL));
+        watchdog->start();
+    }
+
+    QMutex outputMutex;
+    std::size_t failureCount = 0;
+
+    nc::parallelFor(items.size(), jobCount, [&](std::size_t index) {
+        const BatchItem &item = items[index];
+
+        QElapsedTimer timer;
+        timer.start();
+
+        QString status = "ok";
+        QString message;
+
+        /* Code printed to stdout is buffered, so that it does not interleave with other inputs. */
+        QString code;
+
+        {
+            nc::core::Context context;
+            context.setCache(cache);
+            context.setIncrementalStructuring(incrementalStructuring);
+
+            if (logger) {
+                context.setLogToken(nc::LogToken(std::make_shared<BatchLogger>(logger, item.input)));
+            }
+            if (!statsFile.isEmpty()) {
+                statistics[index] = std::make_shared<nc::core::Statistics>();
+                context.setStatistics(statistics[index]);
+            }
+
+            if (watchdog) {
+                watchdog->add(index, context.cancellationToken());
+            }
+
+            try {
+                nc::core::Driver::parse(context, item.input);
+                if (recursive) {
+                    nc::core::Driver::disassembleReachable(context);
+                } else {
+                    nc::core::Driver::disassemble(context);
+                }
+
+                auto decompile = [&](QTextStream &out) {
+                    if (stream) {
+                        nc::core::Driver::decompile(context, out);
+                    } else {
+                        nc::core::Driver::decompile(context);
+                        context.tree()->print(out);
+                    }
+                };
+
+                if (item.output == "-") {
+                    QTextStream out(&code);
+                    decompile(out);
+                } else {
+                    openFileForWritingAndCall(item.output, decompile);
+                }
+            } catch (const nc::Exception &e) {
+                status = "error";
+                message = e.unicodeWhat();
+            } catch (const std::exception &e) {
+                status = "error";
+                message = e.what();
+            }
+
+            if (watchdog && watchdog->remove(index) && status != "ok") {
+                status = "timeout";
+                message = QString();
+            }
+        }
+
+        if (status != "ok" && item.output != "-") {
+            QFile::remove(item.output);
+        }
+
+        QMutexLocker locker(&outputMutex);
+        if (status != "ok") {
+            ++failureCount;
+        } else if (item.output == "-") {
+            qout << code;
+        }
+        qout << item.input << '\t' << status << '\t' << QString::number(timer.elapsed() / 1000.0, 'f', 3);
+        if (!message.isEmpty()) {
+            qout << '\t' << message.simplified();
+        }
+        qout << endl;
+    });
+
+    if (watchdog) {
+        watchdog->stop();
+        watchdog->wait();
+    }
+
+    openFileForWritingAndCall(statsFile, [&](QTextStream &out) {
+        out << "[";
+        for (std::size_t i = 0; i < items.size(); ++i) {
+            out << (i ? "," : "") << endl;
+            out << "{\"input\": " << nc::core::Statistics::toJsonString(items[i].input) << ", \"statistics\":" << endl;
+            statistics[i]->print(out);
+            out << "}";
+        }
+        out << endl << "]" << endl;
+    });
+
+    return failureCount;
+}
+
 void help() {
     auto branding = nc::branding();
     branding.setApplicationName("Nocode");
@@ -146,6 +457,38 @@ void help() {
          << "  --print-ir[=FILE]           Print intermediate representation in DOT language to the file." << endl
          << "  --print-regions[=FILE]      Print results of structural analysis in DOT language to the file." << endl
          << "  --print-cxx[=FILE]          Print reconstructed program into given file." << endl
+         << "  --jobs[=N]                  Analyze up to N functions in parallel (N defaults to the number of CPUs)." << endl
+         << "                              Without this option, functions are analyzed one at a time." << endl
+         << "  --stats[=FILE]              Print time, memory and counters of each pass in JSON format to the file." << endl
+         << "  --batch=FILE                Decompile every input listed in the manifest FILE ('-' for stdin)" << endl
+         << "                              in its own context, up to --jobs inputs at a time. Each line of the" << endl
+         << "                              manifest is an input file name, optionally followed by a tab and" << endl
+         << "                              the output file name (default: input name + '.cpp'). A status line" << endl
+         << "                              is printed to stdout for every input, preceded by the code of the" << endl
+         << "                              input if its output file name is '-'. --stats prints a JSON array" << endl
+         << "                              with the statistics of every input; memory figures are process-wide." << endl
+         << "  --timeout=SECONDS           Cancel the decompilation of a batch input running longer than this." << endl
+         << "  --stream                    Print C++ code function by function as soon as it is generated." << endl
+         << "                              Structural graphs are built for one function at a time, and each" << endl
+         << "                              function's analysis results are released once it is printed. Dataflow" << endl
+         << "                              and liveness of all functions are still computed before printing," << endl
+         << "                              as type reconstruction needs them." << endl
+         << "  --recursive                 Disassemble only the code reachable from the entry point and function" << endl
+         << "                              symbols instead of all code sections." << endl
+         << "  --incremental-structuring   Perform all reductions of a kind in one pass during structural analysis" << endl
+         << "                              instead of restarting it after every reduction. The recovered control" << endl
+         << "                              flow can differ, as the order of reductions changes." << endl
+         << "  --function=ADDR[,ADDR...]   Disassemble and decompile only the functions at the given hexadecimal" << endl
+         << "                              addresses, analyzing their callees only as far as needed for" << endl
+         << "                              reconstructing the callees' signatures." << endl
+         << "  --cache=DIR                 Reuse signatures, structure, and code of functions whose code is unchanged" << endl
+         << "                              since previous runs sharing DIR." << endl
+         << "  --save-session=FILE         Save parsed image, instructions, generated code, and signatures and" << endl
+         << "                              structure of functions to the file. Other analysis results are not saved." << endl
+         << "  --load-session=FILE         Restore a session saved by --save-session instead of parsing input files." << endl
+         << "                              Printing C++ code runs no analyses; --print-cfg, --print-ir and" << endl
+         << "                              --print-regions decompile the restored instructions again, reusing" << endl
+         << "                              the saved signatures and structure of functions." << endl
          << "  --from[=ADDR]               From disassemble boundary." << endl
          << "  --to[=ADDR]                 To disassemble boundary." << endl
          << endl
@@ -182,11 +525,22 @@ int main(int argc, char *argv[]) {
         QString irFile;
         QString regionsFile;
         QString cxxFile;
+        QString statsFile;
+        QString cacheDirectory;
+        QString saveSessionFile;
+        QString loadSessionFile;
+        QString manifestFile;
         nc::ByteAddr from_addr = 0;
         nc::ByteAddr to_addr = 0;
 
+        int threadCount = 1;
+        int timeout = 0;
+
         bool autoDefault = true;
         bool verbose = false;
+        bool stream = false;
+        bool recursive = false;
+        bool incrementalStructuring = false;
 
         std::vector<nc::ByteAddr> functionAddresses;
         std::vector<nc::ByteAddr> callAddresses;
@@ -202,6 +556,47 @@ int main(int argc, char *argv[]) {
                 return 1;
             } else if (arg == "--verbose" || arg == "-v") {
                 verbose = true;
+            } else if (arg == "--jobs") {
+                threadCount = qMax(QThread::idealThreadCount(), 1);
+            } else if (arg.startsWith("--jobs=")) {
+                bool ok;
+                threadCount = arg.section('=', 1).toInt(&ok);
+                if (!ok || threadCount < 1) {
+                    throw nc::Exception(QString("invalid number of jobs: %1").arg(arg.section('=', 1)));
+                }
+            } else if (arg == "--stats") {
+                statsFile = "-";
+            } else if (arg.startsWith("--stats=")) {
+                statsFile = arg.section('=', 1);
+            } else if (arg.startsWith("--batch=")) {
+                manifestFile = arg.section('=', 1);
+            } else if (arg.startsWith("--timeout=")) {
+                bool ok;
+                timeout = arg.section('=', 1).toInt(&ok);
+                if (!ok || timeout < 0) {
+                    throw nc::Exception(QString("invalid timeout: %1").arg(arg.section('=', 1)));
+                }
+            } else if (arg == "--stream") {
+                stream = true;
+            } else if (arg == "--recursive") {
+                recursive = true;
+            } else if (arg == "--incremental-structuring") {
+                incrementalStructuring = true;
+            } else if (arg.startsWith("--function=")) {
+                foreach (const QString &address, arg.section('=', 1).split(',')) {
+                    bool ok;
+                    functionAddresses.push_back(address.toULongLong(&ok, 16));
+                    if (!ok) {
+                        throw nc::Exception(QString("invalid function address: %1").arg(address));
+                    }
+                }
+            } else if (arg.startsWith("--cache=")) {
+                cacheDirectory = arg.section('=', 1);
+            } else if (arg.startsWith("--save-session=")) {
+                saveSessionFile = arg.section('=', 1);
+                autoDefault = false;
+            } else if (arg.startsWith("--load-session=")) {
+                loadSessionFile = arg.section('=', 1);
 
             #define FILE_OPTION(option, variable)       \
             } else if (arg == option) {                 \
@@ -240,20 +635,70 @@ int main(int argc, char *argv[]) {
             }
         }
 
+        if (!manifestFile.isEmpty()) {
+            if (!files.empty() || !loadSessionFile.isEmpty() || !saveSessionFile.isEmpty() || !autoDefault ||
+                !functionAddresses.empty()) {
+                throw nc::Exception("--batch cannot be combined with input files, sessions, --function, or --print-* options");
+            }
+
+            std::shared_ptr<nc::DiskCache> cache;
+            if (!cacheDirectory.isEmpty()) {
+                cache = std::make_shared<nc::DiskCache>(cacheDirectory);
+            }
+
+            return runBatch(manifestFile, threadCount, timeout, stream, recursive, incrementalStructuring, verbose, statsFile, cache) == 0 ? 0 : 1;
+        }
+
         if (autoDefault) {
             cxxFile = "-";
         }
 
-        if (files.empty()) {
+        if (files.empty() && loadSessionFile.isEmpty()) {
             throw nc::Exception("no input files");
         }
 
+        if (!files.empty() && !loadSessionFile.isEmpty()) {
+            throw nc::Exception("input files cannot be combined with --load-session");
+        }
+
+        if (stream && (!regionsFile.isEmpty() || !saveSessionFile.isEmpty())) {
+            throw nc::Exception("--stream cannot be combined with --print-regions or --save-session");
+        }
+
+        if (!functionAddresses.empty() && (from_addr || to_addr || recursive)) {
+            throw nc::Exception("--function cannot be combined with --from, --to, or --recursive");
+        }
+
         nc::core::Context context;
+        context.setThreadCount(threadCount);
+        context.setIncrementalStructuring(incrementalStructuring);
+        context.setSelectedFunctions(functionAddresses);
 
         if (verbose) {
             context.setLogToken(nc::LogToken(std::make_shared<nc::StreamLogger>(qerr)));
         }
 
+        if (!statsFile.isEmpty()) {
+            context.setStatistics(std::make_shared<nc::core::Statistics>());
+        }
+
+        if (!cacheDirectory.isEmpty()) {
+            context.setCache(std::make_shared<nc::DiskCache>(cacheDirectory));
+        }
+
+        if (!loadSessionFile.isEmpty()) {
+            try {
+                nc::core::Driver::loadSession(context, loadSessionFile);
+            } catch (const nc::Exception &e) {
+                throw nc::Exception(loadSessionFile + ":" + e.unicodeWhat());
+            }
+        }
+
+        /* Results of the analyses of functions are saved in the session, too. */
+        if (!saveSessionFile.isEmpty() && !context.functionCache()) {
+            context.setFunctionCache(std::make_shared<nc::core::ir::FunctionCache>(context.cache()));
+        }
+
         foreach (const QString &filename, files) {
             try {
                 nc::core::Driver::parse(context, filename);
@@ -267,26 +712,52 @@ int main(int argc, char *argv[]) {
         openFileForWritingAndCall(sectionsFile, [&](QTextStream &out) { printSections(context, out); });
         openFileForWritingAndCall(symbolsFile, [&](QTextStream &out) { printSymbols(context, out); });
 
-        if (!instructionsFile.isEmpty() || !cfgFile.isEmpty() || !irFile.isEmpty() || !regionsFile.isEmpty() || !cxxFile.isEmpty()) {
-            if(from_addr && to_addr)
-            {
-                foreach (const nc::core::image::Section *section, context.image()->sections())
-                    if( from_addr >= section->addr() && to_addr <= section->endAddr() )
-                        nc::core::Driver::disassemble(context, section, from_addr, to_addr);
+        if (!instructionsFile.isEmpty() || !cfgFile.isEmpty() || !irFile.isEmpty() || !regionsFile.isEmpty() || !cxxFile.isEmpty() ||
+            !saveSessionFile.isEmpty()) {
+            /* A restored session already has its instructions. */
+            if (loadSessionFile.isEmpty()) {
+                if (!functionAddresses.empty())
+                    nc::core::Driver::disassembleFunctions(context, functionAddresses);
+                else if(from_addr && to_addr)
+                {
+                    foreach (const nc::core::image::Section *section, context.image()->sections())
+                        if( from_addr >= section->addr() && to_addr <= section->endAddr() )
+                            nc::core::Driver::disassemble(context, section, from_addr, to_addr);
+                }
+                else if (recursive)
+                    nc::core::Driver::disassembleReachable(context);
+                else
+                    nc::core::Driver::disassemble(context);
             }
-            else
-                nc::core::Driver::disassemble(context);
 
             openFileForWritingAndCall(instructionsFile, [&](QTextStream &out) { context.instructions()->print(out); });
 
-            if (!cfgFile.isEmpty() || !irFile.isEmpty() || !regionsFile.isEmpty() || !cxxFile.isEmpty()) {
-                nc::core::Driver::decompile(context);
+            bool needsTree = !cxxFile.isEmpty() || !saveSessionFile.isEmpty();
+            bool streamCxx = stream && !cxxFile.isEmpty() && !context.tree();
+
+            if (!cfgFile.isEmpty() || !irFile.isEmpty() || !regionsFile.isEmpty() || (needsTree && !context.tree())) {
+                if (streamCxx) {
+                    openFileForWritingAndCall(cxxFile, [&](QTextStream &out) { nc::core::Driver::decompile(context, out); });
+                } else {
+                    nc::core::Driver::decompile(context);
+                }
 
                 openFileForWritingAndCall(cfgFile,     [&](QTextStream &out) { context.program()->print(out); });
                 openFileForWritingAndCall(irFile,      [&](QTextStream &out) { context.functions()->print(out); });
                 openFileForWritingAndCall(regionsFile, [&](QTextStream &out) { printRegionGraphs(context, out); });
-                openFileForWritingAndCall(cxxFile,     [&](QTextStream &out) { context.tree()->print(out); });
             }
+
+            if (!streamCxx) {
+                openFileForWritingAndCall(cxxFile, [&](QTextStream &out) { context.tree()->print(out); });
+            }
+        }
+
+        if (!saveSessionFile.isEmpty()) {
+            nc::core::Driver::saveSession(context, saveSessionFile);
+        }
+
+        if (context.statistics()) {
+            openFileForWritingAndCall(statsFile, [&](QTextStream &out) { context.statistics()->print(out); });
         }
     } catch (const nc::Exception &e) {
         qerr << self << ": " << e.unicodeWhat() << endl;